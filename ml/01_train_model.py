@@ -1,6 +1,9 @@
+import argparse
 import pandas as pd
 import numpy as np
+from sklearn.discriminant_analysis import LinearDiscriminantAnalysis
 from sklearn.linear_model import LogisticRegression
+from sklearn.neural_network import MLPClassifier
 from sklearn.multiclass import OneVsRestClassifier
 from sklearn.preprocessing import StandardScaler
 from sklearn.model_selection import train_test_split
@@ -8,6 +11,21 @@ from sklearn.metrics import accuracy_score, confusion_matrix, classification_rep
 import joblib
 import warnings
 
+from emg_features import (extract_features_batch, firmware_prefilter, firmware_spectral,
+                          firmware_time_features)
+from model_export import (write_model_header, write_model_source, model_from_sklearn,
+                          model_param_count, drop_unused_time_features, MODEL_MAX_HIDDEN)
+
+# Model type trades accuracy against cycles per window (emg_host modelbench)
+parser = argparse.ArgumentParser(description='Train the EMG gesture model and export it as C')
+parser.add_argument('--model', choices=['lr', 'lda', 'mlp'], default='lr',
+                    help='one-vs-rest logistic regression, LDA or a one-hidden-layer MLP')
+parser.add_argument('--hidden', type=int, default=16,
+                    help=f'MLP hidden units (max {MODEL_MAX_HIDDEN})')
+args = parser.parse_args()
+if not 1 <= args.hidden <= MODEL_MAX_HIDDEN:
+    parser.error(f'--hidden must be 1..{MODEL_MAX_HIDDEN}')
+
 # Suppress the deprecation warnings
 warnings.filterwarnings('ignore', category=FutureWarning)
 
@@ -61,53 +79,17 @@ print(f"\nTotal samples: {len(df)}")
 print("Gesture distribution:")
 print(df['label'].value_counts().sort_index())
 
-# Feature extraction functions (optimized for STM32)
-def extract_features(window):
-    """Extract features for a window of data (4 channels)"""
-    features = []
-    
-    for ch in range(4):  # 4 channels
-        signal = window[:, ch]
-        
-        # 1. Mean Absolute Value (MAV) - simple and effective
-        mav = np.mean(np.abs(signal))
-        
-        # 2. Root Mean Square (RMS) - good for EMG
-        rms = np.sqrt(np.mean(signal**2))
-        
-        # 3. Variance (VAR)
-        var = np.var(signal)
-        
-        # 4. Waveform Length (WL) - sum of absolute differences
-        wl = np.sum(np.abs(np.diff(signal)))
-        
-        # 5. Zero Crossing (ZC) - count sign changes
-        zc = np.sum(np.diff(np.sign(signal)) != 0)
-        
-        features.extend([mav, rms, var, wl, zc])
-    
-    return features
-
 # Prepare sliding windows
-WINDOW_SIZE = 150  # 150ms at 1000Hz = 150 samples
-OVERLAP = 100      # 100ms overlap = 67% overlap
-
-X = []
-y = []
+WINDOW_SIZE = 150  # 100ms at 1500Hz = 150 samples
+OVERLAP = 100      # 67ms overlap = 67% overlap
 
 data_array = df[['ch1', 'ch2', 'ch3', 'ch4']].values
 labels = df['label'].values
 
-for i in range(0, len(data_array) - WINDOW_SIZE, WINDOW_SIZE - OVERLAP):
-    window = data_array[i:i+WINDOW_SIZE]
-    window_label = labels[i+WINDOW_SIZE//2]  # Label for middle of window
-    
-    features = extract_features(window)
-    X.append(features)
-    y.append(window_label)
-
-X = np.array(X)
-y = np.array(y)
+# Features come from the firmware's own C extractor (emg_features.py), so the model
+# is trained on exactly what the STM32 computes
+X, starts = extract_features_batch(data_array, WINDOW_SIZE, WINDOW_SIZE - OVERLAP)
+y = labels[starts + WINDOW_SIZE // 2]  # Label for middle of window
 
 print(f"\nFeature matrix shape: {X.shape}")
 print(f"Number of features per sample: {X.shape[1]}")
@@ -120,18 +102,26 @@ scaler = StandardScaler()
 X_train_scaled = scaler.fit_transform(X_train)
 X_test_scaled = scaler.transform(X_test)
 
-# Train logistic regression with OneVsRest strategy
-print("\nTraining logistic regression...")
-base_model = LogisticRegression(
-    C=0.1,  # Strong regularization to prevent overfitting
-    penalty='l2',
-    solver='liblinear',  # Good for small datasets
-    max_iter=1000,
-    random_state=42
-)
-
-# Wrap with OneVsRestClassifier for multiclass
-model = OneVsRestClassifier(base_model)
+if args.model == 'lr':
+    # Train logistic regression with OneVsRest strategy
+    print("\nTraining logistic regression...")
+    base_model = LogisticRegression(
+        C=0.1,  # Strong regularization to prevent overfitting
+        penalty='l2',
+        solver='liblinear',  # Good for small datasets
+        max_iter=1000,
+        random_state=42
+    )
+
+    # Wrap with OneVsRestClassifier for multiclass
+    model = OneVsRestClassifier(base_model)
+elif args.model == 'lda':
+    print("\nTraining linear discriminant analysis...")
+    model = LinearDiscriminantAnalysis()
+else:
+    print(f"\nTraining MLP with {args.hidden} hidden units...")
+    model = MLPClassifier(hidden_layer_sizes=(args.hidden,), activation='relu',
+                          alpha=1e-3, max_iter=2000, random_state=42)
 model.fit(X_train_scaled, y_train)
 
 # Evaluate
@@ -150,139 +140,25 @@ print(confusion_matrix(y_test, y_pred))
 # Save model for STM32
 print("\nSaving model for STM32...")
 
-# Access coefficients from the underlying estimators
-coef_list = []
-intercept_list = []
-
-for estimator in model.estimators_:
-    coef_list.append(estimator.coef_[0])  # Get the coefficient vector
-    intercept_list.append(estimator.intercept_[0])  # Get the intercept
-
-# Convert to arrays
-coef = np.array(coef_list)  # shape: (n_classes, n_features)
-intercept = np.array(intercept_list)  # shape: (n_classes,)
-
-print(f"Coefficient shape: {coef.shape}")
-print(f"Intercept shape: {intercept.shape}")
+# Weight blobs for the firmware model runtime, without the features it gives no weight
+exported = model_from_sklearn(model)
+scaler_mean, scaler_scale, exported, time_features, dropped = drop_unused_time_features(
+    scaler.mean_, scaler.scale_, exported, firmware_time_features(), firmware_spectral())
+if dropped:
+    print(f"Unused features left out of the export: {', '.join(dropped)}")
 
 # Calculate model size
-model_size_bytes = (coef.size + intercept.size) * 4  # 4 bytes per float
-print(f"Model size: {model_size_bytes} bytes")
-print(f"Number of parameters: {coef.size + intercept.size}")
-
-# Save as C header file
-with open('ml/emg_model.h', 'w') as f:
-    f.write('#ifndef EMG_MODEL_H\n')
-    f.write('#define EMG_MODEL_H\n\n')
-    
-    f.write('#include <stdint.h>\n\n')
-    
-    # IMPORTANT: Update gesture mapping to match your definitions
-    f.write('typedef enum {\n')
-    f.write('    // Based on exact definitions:\n')
-    f.write('    GESTURE_ROCK = 0,           // all closed\n')
-    f.write('    GESTURE_SCISSORS = 1,       // index, middle opened, others closed\n')
-    f.write('    GESTURE_PAPER = 2,          // all opened\n')
-    f.write('    GESTURE_FUCK = 3,           // middle finger opened, others closed\n')
-    f.write('    GESTURE_THREE = 4,          // index, middle, ring opened, others closed\n')
-    f.write('    GESTURE_FOUR = 5,           // only thumb closed\n')
-    f.write('    GESTURE_GOOD = 6,           // only thumb opened\n')
-    f.write('    GESTURE_OKAY = 7,           // index and thumb make circle, others opened\n')
-    f.write('    GESTURE_FINGER_GUN = 8,     // index, thumb opened, others closed\n')
-    f.write('    GESTURE_REST = 9            // relaxed\n')
-    f.write('} GestureType;\n\n')
-    
-    # Model parameters
-    f.write(f'#define NUM_FEATURES {X.shape[1]}\n')
-    f.write(f'#define NUM_CLASSES {len(gesture_mapping)}\n\n')
-    
-    f.write('// Channel mapping (CRITICAL!):\n')
-    f.write('// ch1: flexor carpi radialis (a0)\n')
-    f.write('// ch2: brachioradialis (a1)\n')
-    f.write('// ch3: flexor carpi ulnaris (a2)\n')
-    f.write('// ch4: flexor digitorum superficialis (a3)\n\n')
-    
-    f.write('// Feature scaling parameters\n')
-    f.write(f'extern const float scaler_mean[{X.shape[1]}];\n')
-    f.write(f'extern const float scaler_scale[{X.shape[1]}];\n\n')
-    
-    f.write('// Logistic regression coefficients\n')
-    f.write(f'extern const float lr_coefficients[NUM_CLASSES][NUM_FEATURES];\n')
-    f.write(f'extern const float lr_intercept[NUM_CLASSES];\n\n')
-    
-    f.write('// Gesture names\n')
-    f.write('extern const char* gesture_names[NUM_CLASSES];\n\n')
-    
-    f.write('#endif // EMG_MODEL_H\n')
-
-# Save as C source file
-with open('ml/emg_model.c', 'w') as f:
-    f.write('#include "emg_model.h"\n\n')
-    f.write('#include <math.h>\n\n')
-    
-    # Scaling parameters
-    f.write('const float scaler_mean[NUM_FEATURES] = {\n')
-    for mean_val in scaler.mean_:
-        f.write(f'    {mean_val:.6f}f,\n')
-    f.write('};\n\n')
-    
-    f.write('const float scaler_scale[NUM_FEATURES] = {\n')
-    for scale_val in scaler.scale_:
-        f.write(f'    {scale_val:.6f}f,\n')
-    f.write('};\n\n')
-    
-    # Coefficients
-    f.write('const float lr_coefficients[NUM_CLASSES][NUM_FEATURES] = {\n')
-    for class_idx in range(len(coef)):
-        f.write('    {\n')
-        for feat_idx in range(len(coef[class_idx])):
-            f.write(f'        {coef[class_idx][feat_idx]:.6f}f,\n')
-        f.write('    },\n')
-    f.write('};\n\n')
-    
-    # Intercepts
-    f.write('const float lr_intercept[NUM_CLASSES] = {\n')
-    for intercept_val in intercept:
-        f.write(f'    {intercept_val:.6f}f,\n')
-    f.write('};\n\n')
-    
-    # Gesture names
-    f.write('const char* gesture_names[NUM_CLASSES] = {\n')
-    for gesture in gesture_mapping.keys():
-        f.write(f'    "{gesture}",\n')
-    f.write('};\n\n')
-    
-    # Helper function for prediction
-    f.write('''
-GestureType predict_gesture(const float* features) {
-    float scores[NUM_CLASSES] = {0};
-    float max_score = -INFINITY;
-    int predicted_class = 0;
-    
-    // Scale features
-    float scaled_features[NUM_FEATURES];
-    for (int i = 0; i < NUM_FEATURES; i++) {
-        scaled_features[i] = (features[i] - scaler_mean[i]) / scaler_scale[i];
-    }
-    
-    // Calculate scores for each class (One-vs-Rest)
-    for (int class_idx = 0; class_idx < NUM_CLASSES; class_idx++) {
-        scores[class_idx] = lr_intercept[class_idx];
-        
-        for (int feat_idx = 0; feat_idx < NUM_FEATURES; feat_idx++) {
-            scores[class_idx] += lr_coefficients[class_idx][feat_idx] * scaled_features[feat_idx];
-        }
-        
-        // Keep track of maximum score
-        if (scores[class_idx] > max_score) {
-            max_score = scores[class_idx];
-            predicted_class = class_idx;
-        }
-    }
-    
-    return (GestureType)predicted_class;
-}
-''')
+num_params = model_param_count(exported)
+print(f"Model size: {num_params * 4} bytes")  # 4 bytes per float
+print(f"Number of parameters: {num_params}")
+
+# Save as C header/source (descriptor plus, for linear models, the fixed-point tables)
+write_model_header('ml/emg_model.h', gesture_mapping, len(scaler_mean), exported,
+                   prefilter=firmware_prefilter(), spectral=firmware_spectral(),
+                   time_features=time_features)
+write_model_source('ml/emg_model.c', scaler_mean, scaler_scale, exported,
+                   gesture_mapping, WINDOW_SIZE, spectral=firmware_spectral(),
+                   time_features=time_features)
 
 print("Model saved to ml/emg_model.h and ml/emg_model.c")
 
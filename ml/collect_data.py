@@ -5,6 +5,8 @@ import csv
 from datetime import datetime
 import sys
 
+from decode_telemetry import TelemetryDecoder
+
 def collect_data(gesture_name, duration_seconds=5, samples_per_gesture=500):
     """
     Collect data for a specific gesture
@@ -26,26 +28,25 @@ def collect_data(gesture_name, duration_seconds=5, samples_per_gesture=500):
     data = []
     start_time = time.time()
     
-    # Read data for specified duration
+    # Every ADC sample arrives in binary telemetry frames (see decode_telemetry.py)
+    decoder = TelemetryDecoder()
     while len(data) < samples_per_gesture:
         try:
-            line = ser.readline().decode('utf-8').strip()
-            if line and ',' in line:
-                # Format: "ch1,ch2,ch3,ch4,gesture"
-                parts = line.split(',')
-                if len(parts) >= 4:
-                    # Add gesture label
-                    parts.append(gesture_name)
-                    data.append(parts)
-                    
+            for kind, frame in decoder.feed(ser.read(ser.in_waiting or 1)):
+                if kind != 'frame':
+                    continue
+                for sample in frame.samples:
+                    # Format: ch1,ch2,ch3,ch4,gesture
+                    data.append(sample + [gesture_name])
+
                     # Progress indicator
-                    if len(data) % 50 == 0:
+                    if len(data) % 500 == 0:
                         print(f"Collected {len(data)}/{samples_per_gesture} samples")
-        except UnicodeDecodeError:
-            continue
         except KeyboardInterrupt:
             print("\nCollection interrupted!")
             return None
+    if decoder.lost_samples:
+        print(f"Warning: {decoder.lost_samples} samples lost on the link")
     
     elapsed = time.time() - start_time
     print(f"Finished! Collected {len(data)} samples in {elapsed:.1f} seconds")
@@ -67,10 +68,6 @@ if __name__ == "__main__":
         print("Flushing buffer...")
         ser.flushInput()
         
-        # Read and discard any initial data
-        while ser.in_waiting:
-            ser.readline()
-        
     except serial.SerialException as e:
         print(f"Error opening serial port: {e}")
         sys.exit(1)
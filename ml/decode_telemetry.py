@@ -0,0 +1,192 @@
+# ml/decode_telemetry.py
+# Decodes the firmware's binary UART telemetry (src/src_cube/telemetry.h) from a serial
+# port or a capture file, and reports lost frames and samples.
+#
+#   python ml/decode_telemetry.py --port /dev/ttyUSB0 --csv capture.csv
+#   python ml/decode_telemetry.py --file capture.bin
+import argparse
+import csv
+import struct
+import sys
+from collections import namedtuple
+
+SYNC = b'\xa5\x5a'
+HEADER_BYTES = 10
+SAMPLE_BYTES = 6
+SAMPLES_PER_FRAME = 8
+CHANNELS = 4
+
+Frame = namedtuple('Frame', 'seq first_sample gesture samples')
+
+
+def _crc16_table():
+    table = []
+    for i in range(256):
+        crc = i << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+        table.append(crc & 0xFFFF)
+    return table
+
+
+CRC16_TABLE = _crc16_table()
+
+
+def crc16(data):
+    """CRC-16/CCITT-FALSE, same as telemetry_crc16()."""
+    crc = 0xFFFF
+    for byte in data:
+        crc = ((crc << 8) & 0xFFFF) ^ CRC16_TABLE[(crc >> 8) ^ byte]
+    return crc
+
+
+def unpack_samples(payload, count):
+    samples = []
+    for i in range(count):
+        p = payload[i * SAMPLE_BYTES:(i + 1) * SAMPLE_BYTES]
+        sample = []
+        for j in range(0, SAMPLE_BYTES, 3):
+            sample.append(p[j] | ((p[j + 1] & 0x0F) << 8))
+            sample.append((p[j + 1] >> 4) | (p[j + 2] << 4))
+        samples.append(sample)
+    return samples
+
+
+class TelemetryDecoder:
+    """Reassembles frames from arbitrary chunks of the byte stream.
+
+    Bytes outside valid frames (startup and gesture log lines) are collected as text.
+    Gaps are counted from the sequence number (frames) and the first-sample index
+    (samples), so both dropped frames and bytes lost on the wire show up.
+    """
+
+    def __init__(self):
+        self.buffer = bytearray()
+        self.text = bytearray()
+        self.next_seq = None
+        self.next_sample = None
+        self.frames = 0
+        self.samples = 0
+        self.crc_errors = 0
+        self.lost_frames = 0
+        self.lost_samples = 0
+        self.gaps = []  # (first missing sample index, count)
+
+    def feed(self, data):
+        """Yields ('frame', Frame) and ('text', str) items decoded from data."""
+        self.buffer.extend(data)
+        buf = self.buffer
+        pos = 0
+        while True:
+            start = buf.find(SYNC, pos)
+            if start < 0:
+                end = len(buf) - (1 if buf.endswith(SYNC[:1]) else 0)
+                yield from self._text(buf[pos:max(pos, end)])
+                pos = max(pos, end)
+                break
+            if start > pos:
+                yield from self._text(buf[pos:start])
+                pos = start
+            if len(buf) - pos < HEADER_BYTES:
+                break
+
+            count = buf[pos + 8]
+            length = HEADER_BYTES + count * SAMPLE_BYTES + 2
+            if not 1 <= count <= SAMPLES_PER_FRAME:
+                yield from self._text(buf[pos:pos + 1])
+                pos += 1
+                continue
+            if len(buf) - pos < length:
+                break
+
+            (crc,) = struct.unpack_from('<H', buf, pos + length - 2)
+            if crc16(buf[pos + 2:pos + length - 2]) != crc:
+                # Not a frame after all (or corrupted): resync one byte further on
+                self.crc_errors += 1
+                yield from self._text(buf[pos:pos + 1])
+                pos += 1
+                continue
+
+            seq, first_sample, _, gesture = struct.unpack_from('<HIBB', buf, pos + 2)
+            frame = Frame(seq, first_sample, gesture,
+                          unpack_samples(buf[pos + HEADER_BYTES:pos + length - 2], count))
+            pos += length
+            self._account(frame)
+            yield 'frame', frame
+        del buf[:pos]
+
+    def _text(self, data):
+        self.text.extend(data)
+        while b'\n' in self.text:
+            line, _, rest = bytes(self.text).partition(b'\n')
+            self.text = bytearray(rest)
+            yield 'text', line.decode('utf-8', errors='replace').rstrip('\r')
+
+    def _account(self, frame):
+        if self.next_seq is not None and frame.seq != self.next_seq:
+            self.lost_frames += (frame.seq - self.next_seq) & 0xFFFF
+        if self.next_sample is not None and frame.first_sample != self.next_sample:
+            missing = (frame.first_sample - self.next_sample) & 0xFFFFFFFF
+            self.lost_samples += missing
+            self.gaps.append((self.next_sample, missing))
+        self.next_seq = (frame.seq + 1) & 0xFFFF
+        self.next_sample = (frame.first_sample + len(frame.samples)) & 0xFFFFFFFF
+        self.frames += 1
+        self.samples += len(frame.samples)
+
+    def report(self):
+        lines = [f'{self.frames} frames, {self.samples} samples',
+                 f'lost: {self.lost_frames} frames, {self.lost_samples} samples '
+                 f'in {len(self.gaps)} gaps; {self.crc_errors} CRC mismatches while resyncing']
+        for first, count in self.gaps[:10]:
+            lines.append(f'  gap at sample {first}: {count} missing')
+        return '\n'.join(lines)
+
+
+def read_chunks(args):
+    if args.file:
+        with open(args.file, 'rb') as f:
+            while True:
+                chunk = f.read(65536)
+                if not chunk:
+                    return
+                yield chunk
+    else:
+        import serial
+        with serial.Serial(args.port, args.baud, timeout=0.1) as ser:
+            while True:
+                yield ser.read(4096)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Decode binary EMG telemetry')
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument('--port', help='serial port, e.g. /dev/ttyUSB0')
+    source.add_argument('--file', help='raw capture of the UART stream')
+    parser.add_argument('--baud', type=int, default=230400)
+    parser.add_argument('--csv', help='write ch1..ch4,gesture per sample')
+    parser.add_argument('--quiet', action='store_true', help='do not print log text')
+    args = parser.parse_args()
+
+    decoder = TelemetryDecoder()
+    out = open(args.csv, 'w', newline='') if args.csv else None
+    writer = csv.writer(out) if out else None
+    try:
+        for chunk in read_chunks(args):
+            for kind, item in decoder.feed(chunk):
+                if kind == 'text' and not args.quiet:
+                    print(item)
+                elif kind == 'frame' and writer:
+                    for sample in item.samples:
+                        writer.writerow(sample + [item.gesture])
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if out:
+            out.close()
+    print(decoder.report())
+    return 1 if decoder.lost_samples else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,150 @@
+# ml/emg_features.py
+# The firmware feature extractor (src/src_cube/emg_classifier.c) as a host shared
+# library, so training sees exactly the features the STM32 computes. The library is
+# compiled with the system C compiler on first use and rebuilt when a source changes.
+#
+#   X, starts = extract_features_batch(samples, WINDOW_SIZE, STEP)
+#
+# EMG_PREFILTER in the environment (0, 1 or 2, see src/src_cube/emg_filter.h) selects
+# the preprocessing ahead of the window, and EMG_SPECTRAL_FEATURES=1 appends the
+# spectral block (src/src_cube/emg_spectrum.h) to each channel's features; flash the
+# firmware with the same settings. EMG_TIME_FEATURES lists the time-domain features
+# (e.g. "mav,wl,zc,ssc"), and EMG_ZC_DEADBAND, EMG_SSC_THRESHOLD and
+# EMG_WAMP_THRESHOLD set their thresholds in ADC counts; the export records these,
+# and the firmware follows the export. The feature count follows from all of them.
+import ctypes
+import os
+import subprocess
+import sys
+
+import numpy as np
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SOURCES = [
+    'src/src_cube/emg_classifier.c',
+    'src/src_cube/emg_dsp.c',
+    'src/src_cube/emg_filter.c',
+    'src/src_cube/emg_spectrum.c',
+    'src/src_cube/emg_model.c',
+    'src/src_cube/model_runtime.c',
+    'src/src_native/feature_batch.c',
+]
+HEADERS = [
+    'src/src_cube/emg_classifier.h',
+    'src/src_cube/emg_dsp.h',
+    'src/src_cube/emg_filter.h',
+    'src/src_cube/emg_spectrum.h',
+    'src/src_cube/emg_model.h',
+    'src/src_cube/model_runtime.h',
+    'src/src_cube/common_defs.h',
+    'src/src_native/feature_batch.h',
+]
+BUILD_DIR = os.path.join(ROOT, 'ml', '.build')
+LIB_EXT = {'darwin': '.dylib', 'win32': '.dll'}.get(sys.platform, '.so')
+# FEATURE_* bit order in emg_classifier.h
+TIME_FEATURES = ['mav', 'rms', 'var', 'wl', 'zc', 'ssc', 'wamp']
+PREFILTER = int(os.environ.get('EMG_PREFILTER', '0'))
+SPECTRAL = int(os.environ.get('EMG_SPECTRAL_FEATURES', '0'))
+TIME_MASK = sum(1 << TIME_FEATURES.index(name.strip())
+                for name in os.environ.get('EMG_TIME_FEATURES', 'mav,rms,var,wl,zc').split(','))
+ZC_DEADBAND = int(os.environ.get('EMG_ZC_DEADBAND', '20'))
+SSC_THRESHOLD = int(os.environ.get('EMG_SSC_THRESHOLD', '3600'))
+WAMP_THRESHOLD = int(os.environ.get('EMG_WAMP_THRESHOLD', '200'))
+# One library per setting, so switching does not leave a stale build behind
+LIB_PATH = os.path.join(BUILD_DIR, f'libemg_features_p{PREFILTER}_s{SPECTRAL}_t{TIME_MASK:02x}'
+                        f'_{ZC_DEADBAND}_{SSC_THRESHOLD}_{WAMP_THRESHOLD}' + LIB_EXT)
+
+_lib = None
+
+
+def build_library(force=False):
+    """Compiles the shared library if it is missing or older than its sources."""
+    inputs = [os.path.join(ROOT, p) for p in SOURCES + HEADERS]
+    if not force and os.path.exists(LIB_PATH):
+        built = os.path.getmtime(LIB_PATH)
+        if all(os.path.getmtime(p) <= built for p in inputs):
+            return LIB_PATH
+    os.makedirs(BUILD_DIR, exist_ok=True)
+    cc = os.environ.get('CC', 'cc')
+    # EMG_FEATURES_ONLY: the feature count may differ from the currently exported model
+    cmd = [cc, '-O2', '-shared', '-fPIC', '-DEMG_FEATURES_ONLY', f'-DEMG_PREFILTER={PREFILTER}',
+           f'-DEMG_SPECTRAL_FEATURES={SPECTRAL}', f'-DEMG_TIME_FEATURES={TIME_MASK}',
+           f'-DEMG_ZC_DEADBAND={ZC_DEADBAND}', f'-DEMG_SSC_THRESHOLD={SSC_THRESHOLD}',
+           f'-DEMG_WAMP_THRESHOLD={WAMP_THRESHOLD}', '-I', os.path.join(ROOT, 'src', 'src_native'),
+           '-I', os.path.join(ROOT, 'src', 'src_cube'), '-o', LIB_PATH]
+    cmd += [os.path.join(ROOT, p) for p in SOURCES] + ['-lm']
+    subprocess.run(cmd, check=True)
+    return LIB_PATH
+
+
+def _load():
+    global _lib
+    if _lib is None:
+        lib = ctypes.CDLL(build_library())
+        i32 = ctypes.c_int32
+        lib.feature_batch_windows.argtypes = [i32, i32, i32]
+        lib.feature_batch_windows.restype = i32
+        lib.extract_features_batch.argtypes = [ctypes.POINTER(ctypes.c_int16), i32, i32, i32,
+                                               ctypes.POINTER(ctypes.c_float)]
+        lib.extract_features_batch.restype = i32
+        lib.feature_batch_info.argtypes = [ctypes.POINTER(i32)] * 3
+        lib.feature_batch_info.restype = None
+        lib.feature_batch_prefilter.argtypes = []
+        lib.feature_batch_prefilter.restype = i32
+        lib.feature_batch_spectral.argtypes = []
+        lib.feature_batch_spectral.restype = i32
+        lib.feature_batch_time_features.argtypes = [ctypes.POINTER(i32)] * 4
+        lib.feature_batch_time_features.restype = None
+        _lib = lib
+    return _lib
+
+
+def firmware_sizes():
+    """(WINDOW_SIZE, NUM_CHANNELS, TOTAL_FEATURES) the library was compiled with."""
+    values = [ctypes.c_int32() for _ in range(3)]
+    _load().feature_batch_info(*[ctypes.byref(v) for v in values])
+    return tuple(v.value for v in values)
+
+
+def firmware_prefilter():
+    """EMG_PREFILTER the library was compiled with, for write_model_header()."""
+    return _load().feature_batch_prefilter()
+
+
+def firmware_spectral():
+    """EMG_SPECTRAL_FEATURES the library was compiled with, for the model export."""
+    return _load().feature_batch_spectral()
+
+
+def firmware_time_features():
+    """Time-domain feature set the library was compiled with, for the model export:
+    {'mask': FEATURE_* bits, 'zc_deadband': ..., 'ssc_threshold': ..., 'wamp_threshold': ...}."""
+    values = [ctypes.c_int32() for _ in range(4)]
+    _load().feature_batch_time_features(*[ctypes.byref(v) for v in values])
+    keys = ['mask', 'zc_deadband', 'ssc_threshold', 'wamp_threshold']
+    return dict(zip(keys, (v.value for v in values)))
+
+
+def extract_features_batch(samples, window, step):
+    """Features of every window of a (n, channels) array of raw ADC samples.
+
+    Windows start at 0, step, 2*step, ... and must fit entirely. Returns the
+    (windows, features) float32 matrix and the start index of each window.
+    """
+    lib = _load()
+    window_size, channels, num_features = firmware_sizes()
+    if window != window_size:
+        raise ValueError(f'the firmware window is {window_size} samples, not {window}')
+    samples = np.ascontiguousarray(samples, dtype=np.int16)
+    if samples.ndim != 2 or samples.shape[1] != channels:
+        raise ValueError(f'expected (n, {channels}) samples, got {samples.shape}')
+
+    n = samples.shape[0]
+    count = lib.feature_batch_windows(n, window, step)
+    out = np.empty((count, num_features), dtype=np.float32)
+    written = lib.extract_features_batch(
+        samples.ctypes.data_as(ctypes.POINTER(ctypes.c_int16)), n, window, step,
+        out.ctypes.data_as(ctypes.POINTER(ctypes.c_float)))
+    if written != count:
+        raise RuntimeError(f'extract_features_batch returned {written}, expected {count}')
+    return out, np.arange(count) * step
@@ -0,0 +1,415 @@
+# ml/model_export.py
+# Writes a trained scaler + classifier as emg_model.h/.c for the firmware
+# (src/src_cube): the weight blobs plus a ModelDescriptor for model_runtime.c.
+# Shared by 01_train_model.py and retrain_mode.py.
+import math
+
+# Must match emg_classifier.h; the fixed-point tables cover the time-domain
+# features only (TIME_FEATURES_PER_CHANNEL)
+WINDOW_SIZE = 150
+NUM_CHANNELS = 4
+ADC_BITS = 12
+# FEATURE_* bit order; MAV is required (signal validation reads it)
+TIME_FEATURES = ['mav', 'rms', 'var', 'wl', 'zc', 'ssc', 'wamp']
+SPECTRAL_FEATURES_PER_CHANNEL = 5
+# The original feature set, for callers that do not pass one
+CLASSIC_TIME_FEATURES = {'mask': 0x1F, 'zc_deadband': 0, 'ssc_threshold': 0, 'wamp_threshold': 0}
+
+# Fixed-point path (EMG_FIXED_POINT): integer features are kept below 2^27 and
+# coefficients below 2^31 so 20 products always fit the int64 accumulator.
+Q_FEATURE_BITS = 27
+Q_COEF_BITS = 31
+
+GESTURE_COMMENTS = {
+    'rock': 'all closed',
+    'scissors': 'index, middle opened, others closed',
+    'paper': 'all opened',
+    'fuck': 'middle finger opened, others closed',
+    'three': 'index, middle, ring opened, others closed',
+    'four': 'only thumb closed',
+    'good': 'only thumb opened',
+    'okay': 'index and thumb make circle, others opened',
+    'finger-gun': 'index, thumb opened, others closed',
+    'rest': 'relaxed',
+}
+
+
+MODEL_TYPES = {'lr': 'MODEL_LR', 'lda': 'MODEL_LDA', 'mlp': 'MODEL_MLP'}
+
+# Must match model_runtime.h: model_predict() sizes its stack scratch by these
+MODEL_MAX_FEATURES = 64
+MODEL_MAX_HIDDEN = 64
+MODEL_MAX_CLASSES = 16
+
+
+def linear_model(kind, coef, intercept):
+    """LR or LDA: scores = coef @ x + intercept on the scaled features."""
+    return {'type': kind, 'coef': coef, 'intercept': intercept}
+
+
+def mlp_model(hidden_coef, hidden_intercept, out_coef, out_intercept):
+    """One ReLU hidden layer; weight matrices are [outputs][inputs]."""
+    return {'type': 'mlp', 'hidden_coef': hidden_coef, 'hidden_intercept': hidden_intercept,
+            'coef': out_coef, 'intercept': out_intercept}
+
+
+def model_from_sklearn(model):
+    """Exports OneVsRestClassifier(LogisticRegression), LinearDiscriminantAnalysis
+    or a one-hidden-layer MLPClassifier (relu) fitted on scaled features."""
+    name = type(model).__name__
+    if name == 'OneVsRestClassifier':
+        coef = [e.coef_[0] for e in model.estimators_]
+        intercept = [e.intercept_[0] for e in model.estimators_]
+        return linear_model('lr', coef, intercept)
+    if name == 'LinearDiscriminantAnalysis':
+        return linear_model('lda', list(model.coef_), list(model.intercept_))
+    if name == 'MLPClassifier':
+        if len(model.coefs_) != 2 or model.activation != 'relu':
+            raise ValueError('firmware runtime supports one relu hidden layer')
+        return mlp_model(model.coefs_[0].T, model.intercepts_[0],
+                         model.coefs_[1].T, model.intercepts_[1])
+    raise ValueError(f'cannot export {name}')
+
+
+def check_model_limits(num_features, model, num_classes):
+    """Raises if the model would not fit the firmware runtime's scratch arrays."""
+    sizes = [('features', num_features, MODEL_MAX_FEATURES),
+             ('classes', num_classes, MODEL_MAX_CLASSES)]
+    if model['type'] == 'mlp':
+        sizes.append(('hidden units', len(model['hidden_coef']), MODEL_MAX_HIDDEN))
+    for what, n, limit in sizes:
+        if not 1 <= n <= limit:
+            raise ValueError(f'{n} {what}, the firmware runtime supports 1..{limit}')
+
+
+def model_param_count(model):
+    count = sum(len(row) + 1 for row in model['coef'])
+    if model['type'] == 'mlp':
+        count += sum(len(row) + 1 for row in model['hidden_coef'])
+    return count
+
+
+def feature_names(mask):
+    """Enabled time-domain features of a FEATURE_* mask, in firmware order."""
+    return [name for i, name in enumerate(TIME_FEATURES) if mask & (1 << i)]
+
+
+def integer_feature_bounds(window_size=WINDOW_SIZE, adc_bits=ADC_BITS, names=None):
+    """Scale k and worst-case magnitude of each integer feature (see emg_classifier.h).
+
+    The firmware computes F = f * k exactly from the window sums:
+    MAV -> sum|x| (k=N), RMS -> isqrt(N*sum x^2) (k=N), VAR -> N*sum x^2 - (sum x)^2 (k=N^2),
+    WL -> sum|dx| (k=1), ZC, SSC and WAMP -> counts (k=1).
+    """
+    n = window_size
+    full = (1 << adc_bits) - 1
+    table = {
+        'mav': (n, n * full),
+        'rms': (n, n * full),
+        'var': (n * n, n * n * (full / 2.0) ** 2),
+        'wl': (1, (n - 1) * full),
+        'zc': (1, n - 1),
+        'ssc': (1, n - 2),
+        'wamp': (1, n - 1),
+    }
+    names = names or feature_names(CLASSIC_TIME_FEATURES['mask'])
+    return [table[name][0] for name in names], [table[name][1] for name in names]
+
+
+def drop_unused_time_features(scaler_mean, scaler_scale, model, time_features, spectral=0):
+    """Removes the time-domain features whose weights are zero on every channel.
+
+    Features constant over the training set (e.g. ZC on offset ADC counts) scale to
+    zero and get no weight, so dropping them changes no score; the firmware then
+    skips computing them. MAV stays. Returns the scaler, model and feature set to
+    export, and the names dropped.
+    """
+    names = feature_names(time_features['mask'])
+    per_channel = len(names) + (SPECTRAL_FEATURES_PER_CHANNEL if spectral else 0)
+    weights = model['hidden_coef'] if model['type'] == 'mlp' else model['coef']
+    unused = [name for k, name in enumerate(names) if name != 'mav'
+              and all(float(row[ch * per_channel + k]) == 0.0
+                      for row in weights for ch in range(NUM_CHANNELS))]
+    if not unused:
+        return scaler_mean, scaler_scale, model, time_features, []
+
+    keep = [ch * per_channel + k for ch in range(NUM_CHANNELS) for k in range(per_channel)
+            if k >= len(names) or names[k] not in unused]
+    model = dict(model)
+    key = 'hidden_coef' if model['type'] == 'mlp' else 'coef'
+    model[key] = [[row[i] for i in keep] for row in weights]
+    time_features = dict(time_features)
+    for name in unused:
+        time_features['mask'] &= ~(1 << TIME_FEATURES.index(name))
+    return ([scaler_mean[i] for i in keep], [scaler_scale[i] for i in keep], model,
+            time_features, unused)
+
+
+def fixed_point_tables(scaler_mean, scaler_scale, coef, intercept, window_size=WINDOW_SIZE,
+                       names=None):
+    """Folds the scaler into integer coefficients for predict_gesture_q().
+
+    score_c = b_c + sum_i w_ci * (f_i - mean_i) / scale_i
+            = (b_c - sum_i w_ci * mean_i / scale_i) + sum_i (w_ci / scale_i / k_i) * F_i
+    F_i is right-shifted by shift_i to bound it, and everything is scaled by 2^frac_bits.
+    """
+    k, bound = integer_feature_bounds(window_size, names=names)
+    num_features = len(scaler_mean)
+    per_channel = len(k)
+
+    shifts = []
+    for i in range(num_features):
+        bits = math.ceil(math.log2(bound[i % per_channel] + 1))
+        shifts.append(max(0, bits - Q_FEATURE_BITS))
+
+    folded = []
+    folded_intercept = []
+    for c in range(len(coef)):
+        row = [float(coef[c][i]) / float(scaler_scale[i]) for i in range(num_features)]
+        folded.append(row)
+        folded_intercept.append(float(intercept[c]) - sum(row[i] * float(scaler_mean[i])
+                                                          for i in range(num_features)))
+
+    per_unit = [[folded[c][i] / k[i % per_channel] * (1 << shifts[i])
+                 for i in range(num_features)] for c in range(len(coef))]
+    largest = max(abs(w) for row in per_unit for w in row)
+    frac_bits = int(math.floor(math.log2(((1 << (Q_COEF_BITS - 1)) - 1) / largest)))
+
+    q_coef = [[int(round(w * 2 ** frac_bits)) for w in row] for row in per_unit]
+    q_intercept = [int(round(b * 2 ** frac_bits)) for b in folded_intercept]
+    return shifts, frac_bits, q_coef, q_intercept
+
+
+def has_fixed_point(model, spectral):
+    """Integer tables exist for linear models on the time-domain features only."""
+    return model['type'] != 'mlp' and not spectral
+
+
+def write_model_header(path, gesture_mapping, num_features, model, prefilter=0, spectral=0,
+                       time_features=None):
+    linear = model['type'] != 'mlp'
+    time_features = time_features or CLASSIC_TIME_FEATURES
+    fixed = has_fixed_point(model, spectral)
+    check_model_limits(num_features, model, len(gesture_mapping))
+    with open(path, 'w') as f:
+        f.write('#ifndef EMG_MODEL_H\n')
+        f.write('#define EMG_MODEL_H\n\n')
+        f.write('#ifdef __cplusplus\n')
+        f.write('extern "C" {\n')
+        f.write('#endif\n\n')
+        f.write('#include <stdint.h>\n')
+        f.write('#include "model_runtime.h"\n\n')
+
+        f.write('typedef enum {\n')
+        last = len(gesture_mapping) - 1
+        for gesture, idx in gesture_mapping.items():
+            name = f'GESTURE_{gesture.upper().replace("-", "_")} = {idx}'
+            sep = ',' if idx != last else ''
+            f.write(f'    {name + sep:<28}// {GESTURE_COMMENTS.get(gesture, gesture)}\n')
+        f.write('} GestureType;\n\n')
+
+        f.write(f'#define NUM_FEATURES {num_features}\n')
+        f.write(f'#define NUM_CLASSES {len(gesture_mapping)}\n')
+        if not linear:
+            f.write(f'#define MLP_HIDDEN {len(model["hidden_coef"])}\n')
+        f.write('\n// Linear models also come with integer tables for EMG_FIXED_POINT\n')
+        f.write(f'#define EMG_MODEL_FIXED_POINT {1 if fixed else 0}\n\n')
+        f.write('// EMG_PREFILTER setting the training features were computed with\n')
+        f.write(f'#define EMG_MODEL_PREFILTER {prefilter}\n')
+        f.write('// Spectral block (EMG_SPECTRAL_FEATURES) in the features\n')
+        f.write(f'#define EMG_MODEL_SPECTRAL_FEATURES {spectral}\n')
+        f.write('// Time-domain features (FEATURE_* bits) and their thresholds in ADC counts\n')
+        f.write(f'#define EMG_MODEL_TIME_FEATURES 0x{time_features["mask"]:02X}\n')
+        f.write(f'#define EMG_MODEL_ZC_DEADBAND {time_features["zc_deadband"]}\n')
+        f.write(f'#define EMG_MODEL_SSC_THRESHOLD {time_features["ssc_threshold"]}\n')
+        f.write(f'#define EMG_MODEL_WAMP_THRESHOLD {time_features["wamp_threshold"]}\n\n')
+
+        f.write('// Channel mapping:\n')
+        f.write('// ch1: flexor carpi radialis (a0)\n')
+        f.write('// ch2: brachioradialis (a1)\n')
+        f.write('// ch3: flexor carpi ulnaris (a2)\n')
+        f.write('// ch4: flexor digitorum superficialis (a3)\n\n')
+
+        f.write('extern const float scaler_mean[NUM_FEATURES];\n')
+        f.write('extern const float scaler_scale[NUM_FEATURES];\n\n')
+        if linear:
+            f.write('extern const float lr_coefficients[NUM_CLASSES][NUM_FEATURES];\n')
+            f.write('extern const float lr_intercept[NUM_CLASSES];\n\n')
+        if fixed:
+            f.write('// Fixed-point model (EMG_FIXED_POINT): scaler folded into the coefficients,\n')
+            f.write('// scores are scaled by 2^LR_Q_FRAC_BITS (see emg_model.c)\n')
+            f.write('extern const uint8_t feature_q_shift[NUM_FEATURES];\n')
+            f.write('extern const int32_t lr_q_coefficients[NUM_CLASSES][NUM_FEATURES];\n')
+            f.write('extern const int64_t lr_q_intercept[NUM_CLASSES];\n\n')
+        if not linear:
+            f.write('extern const float mlp_hidden_weights[MLP_HIDDEN][NUM_FEATURES];\n')
+            f.write('extern const float mlp_hidden_bias[MLP_HIDDEN];\n')
+            f.write('extern const float mlp_out_weights[NUM_CLASSES][MLP_HIDDEN];\n')
+            f.write('extern const float mlp_out_bias[NUM_CLASSES];\n\n')
+
+        f.write('// Evaluated by model_runtime.c\n')
+        f.write('extern const ModelDescriptor emg_model_descriptor;\n\n')
+
+        f.write('extern const char* gesture_names[NUM_CLASSES];\n\n')
+        f.write('GestureType predict_gesture(const float* features);\n')
+        f.write('// Also fills probs[NUM_CLASSES] with the class probabilities\n')
+        f.write('GestureType predict_gesture_proba(const float* features, float* probs);\n')
+        if fixed:
+            f.write('GestureType predict_gesture_q(const int32_t* q_features);\n')
+            f.write('GestureType predict_gesture_q_proba(const int32_t* q_features, float* probs);\n')
+        f.write('\n')
+
+        f.write('#ifdef __cplusplus\n')
+        f.write('}\n')
+        f.write('#endif\n\n')
+        f.write('#endif // EMG_MODEL_H\n')
+
+
+def _write_array(f, decl, values):
+    f.write(f'{decl} = {{\n')
+    for v in values:
+        f.write(f'    {v:.6f}f,\n')
+    f.write('};\n\n')
+
+
+def _write_matrix(f, decl, rows):
+    f.write(f'{decl} = {{\n')
+    for row in rows:
+        f.write('    {\n')
+        for v in row:
+            f.write(f'        {v:.6f}f,\n')
+        f.write('    },\n')
+    f.write('};\n\n')
+
+
+def write_model_source(path, scaler_mean, scaler_scale, model, gesture_mapping,
+                       window_size=WINDOW_SIZE, spectral=0, time_features=None):
+    linear = model['type'] != 'mlp'
+    time_features = time_features or CLASSIC_TIME_FEATURES
+    fixed = has_fixed_point(model, spectral)
+    check_model_limits(len(scaler_mean), model, len(gesture_mapping))
+
+    with open(path, 'w') as f:
+        f.write('#include "emg_model.h"\n\n')
+        f.write('#include <stddef.h>\n')
+        f.write('#include <math.h>\n\n')
+        f.write('// model_predict() sizes its stack scratch by the MODEL_MAX_* limits\n')
+        f.write('_Static_assert(NUM_FEATURES <= MODEL_MAX_FEATURES, "NUM_FEATURES exceeds MODEL_MAX_FEATURES");\n')
+        f.write('_Static_assert(NUM_CLASSES <= MODEL_MAX_CLASSES, "NUM_CLASSES exceeds MODEL_MAX_CLASSES");\n')
+        if not linear:
+            f.write('_Static_assert(MLP_HIDDEN <= MODEL_MAX_HIDDEN, "MLP_HIDDEN exceeds MODEL_MAX_HIDDEN");\n')
+        f.write('\n')
+
+        _write_array(f, 'const float scaler_mean[NUM_FEATURES]', scaler_mean)
+        _write_array(f, 'const float scaler_scale[NUM_FEATURES]', scaler_scale)
+
+        if linear:
+            coef, intercept = model['coef'], model['intercept']
+            _write_matrix(f, 'const float lr_coefficients[NUM_CLASSES][NUM_FEATURES]', coef)
+            _write_array(f, 'const float lr_intercept[NUM_CLASSES]', intercept)
+        if fixed:
+            shifts, frac_bits, q_coef, q_intercept = fixed_point_tables(
+                scaler_mean, scaler_scale, coef, intercept, window_size,
+                names=feature_names(time_features['mask']))
+
+            f.write(f'#define LR_Q_FRAC_BITS {frac_bits}\n\n')
+            f.write('const uint8_t feature_q_shift[NUM_FEATURES] = {\n')
+            for shift in shifts:
+                f.write(f'    {shift},\n')
+            f.write('};\n\n')
+
+            f.write('const int32_t lr_q_coefficients[NUM_CLASSES][NUM_FEATURES] = {\n')
+            for row in q_coef:
+                f.write('    {\n')
+                for w in row:
+                    f.write(f'        {w},\n')
+                f.write('    },\n')
+            f.write('};\n\n')
+
+            f.write('const int64_t lr_q_intercept[NUM_CLASSES] = {\n')
+            for b in q_intercept:
+                f.write(f'    {b}LL,\n')
+            f.write('};\n\n')
+        if not linear:
+            _write_matrix(f, 'const float mlp_hidden_weights[MLP_HIDDEN][NUM_FEATURES]',
+                          model['hidden_coef'])
+            _write_array(f, 'const float mlp_hidden_bias[MLP_HIDDEN]', model['hidden_intercept'])
+            _write_matrix(f, 'const float mlp_out_weights[NUM_CLASSES][MLP_HIDDEN]', model['coef'])
+            _write_array(f, 'const float mlp_out_bias[NUM_CLASSES]', model['intercept'])
+
+        f.write('const ModelDescriptor emg_model_descriptor = {\n')
+        f.write(f'    .type = {MODEL_TYPES[model["type"]]},\n')
+        f.write('    .num_features = NUM_FEATURES,\n')
+        f.write('    .num_classes = NUM_CLASSES,\n')
+        f.write(f'    .num_hidden = {"MLP_HIDDEN" if not linear else 0},\n')
+        f.write('    .scaler_mean = scaler_mean,\n')
+        f.write('    .scaler_scale = scaler_scale,\n')
+        if linear:
+            f.write('    .weights = &lr_coefficients[0][0],\n')
+            f.write('    .bias = lr_intercept,\n')
+            f.write('    .out_weights = NULL,\n')
+            f.write('    .out_bias = NULL,\n')
+        else:
+            f.write('    .weights = &mlp_hidden_weights[0][0],\n')
+            f.write('    .bias = mlp_hidden_bias,\n')
+            f.write('    .out_weights = &mlp_out_weights[0][0],\n')
+            f.write('    .out_bias = mlp_out_bias,\n')
+        f.write('};\n\n')
+
+        f.write('const char* gesture_names[NUM_CLASSES] = {\n')
+        for gesture in gesture_mapping.keys():
+            f.write(f'    "{gesture}",\n')
+        f.write('};\n\n')
+
+        f.write(PREDICT_SOURCE)
+        if fixed:
+            f.write(PREDICT_Q_SOURCE)
+
+
+PREDICT_SOURCE = '''
+GestureType predict_gesture(const float* features) {
+    return (GestureType)model_predict(&emg_model_descriptor, features, NULL);
+}
+
+GestureType predict_gesture_proba(const float* features, float* probs) {
+    return (GestureType)model_predict_proba(&emg_model_descriptor, features, probs);
+}
+'''
+
+PREDICT_Q_SOURCE = '''
+// Integer scores scaled by 2^LR_Q_FRAC_BITS; returns the first maximum
+static int predict_scores_q(const int32_t* q_features, int64_t* scores) {
+    int predicted_class = 0;
+
+    for (int class_idx = 0; class_idx < NUM_CLASSES; class_idx++) {
+        int64_t score = lr_q_intercept[class_idx];
+        for (int feat_idx = 0; feat_idx < NUM_FEATURES; feat_idx++) {
+            score += (int64_t)lr_q_coefficients[class_idx][feat_idx] * q_features[feat_idx];
+        }
+        scores[class_idx] = score;
+        if (score > scores[predicted_class]) {
+            predicted_class = class_idx;
+        }
+    }
+
+    return predicted_class;
+}
+
+// Integer-only inference on the features from emg_buffer_process_window_q()
+GestureType predict_gesture_q(const int32_t* q_features) {
+    int64_t scores[NUM_CLASSES];
+    return (GestureType)predict_scores_q(q_features, scores);
+}
+
+// The argmax stays integer; only the probabilities go through float
+GestureType predict_gesture_q_proba(const int32_t* q_features, float* probs) {
+    int64_t scores[NUM_CLASSES];
+    float float_scores[NUM_CLASSES];
+    int predicted_class = predict_scores_q(q_features, scores);
+    for (int class_idx = 0; class_idx < NUM_CLASSES; class_idx++) {
+        float_scores[class_idx] = ldexpf((float)scores[class_idx], -LR_Q_FRAC_BITS);
+    }
+    model_scores_to_proba(emg_model_descriptor.type, float_scores, NUM_CLASSES, probs);
+    return (GestureType)predicted_class;
+}
+'''
@@ -8,6 +8,11 @@ from sklearn.model_selection import train_test_split
 from sklearn.metrics import accuracy_score, classification_report, confusion_matrix
 import joblib
 import warnings
+
+from emg_features import (extract_features_batch, firmware_prefilter, firmware_spectral,
+                          firmware_time_features)
+from model_export import (write_model_header, write_model_source, model_from_sklearn,
+                          drop_unused_time_features)
 warnings.filterwarnings('ignore')
 
 print("=== RETRAINING WITH CLEAN NEW DATA ===")
@@ -38,36 +43,15 @@ df['label'] = df['gesture'].map(gesture_mapping)
 df = df.dropna(subset=['label'])
 df['label'] = df['label'].astype(int)
 
-# Feature extraction (same as before)
-def extract_features(window):
-    features = []
-    for ch in range(4):
-        signal = window[:, ch]
-        mav = np.mean(np.abs(signal))
-        rms = np.sqrt(np.mean(signal**2))
-        var = np.var(signal)
-        wl = np.sum(np.abs(np.diff(signal)))
-        zc = np.sum(np.diff(np.sign(signal)) != 0)
-        features.extend([mav, rms, var, wl, zc])
-    return features
-
 WINDOW_SIZE = 150
 OVERLAP = 100
 
-X = []
-y = []
 data_array = df[['ch1', 'ch2', 'ch3', 'ch4']].values
 labels = df['label'].values
 
-for i in range(0, len(data_array) - WINDOW_SIZE, WINDOW_SIZE - OVERLAP):
-    window = data_array[i:i+WINDOW_SIZE]
-    window_label = labels[i+WINDOW_SIZE//2]
-    features = extract_features(window)
-    X.append(features)
-    y.append(window_label)
-
-X = np.array(X)
-y = np.array(y)
+# Firmware features via the C extractor (emg_features.py)
+X, starts = extract_features_batch(data_array, WINDOW_SIZE, WINDOW_SIZE - OVERLAP)
+y = labels[starts + WINDOW_SIZE // 2]
 
 print(f"\nFeature matrix shape: {X.shape}")
 print(f"Features per sample: {X.shape[1]}")
@@ -106,91 +90,19 @@ print(classification_report(y_test, y_pred, target_names=list(gesture_mapping.ke
 # Save model
 print("\nSaving model...")
 
-coef_list = []
-intercept_list = []
-for estimator in model.estimators_:
-    coef_list.append(estimator.coef_[0])
-    intercept_list.append(estimator.intercept_[0])
-
-coef = np.array(coef_list)
-intercept = np.array(intercept_list)
+exported = model_from_sklearn(model)
+scaler_mean, scaler_scale, exported, time_features, dropped = drop_unused_time_features(
+    scaler.mean_, scaler.scale_, exported, firmware_time_features(), firmware_spectral())
+if dropped:
+    print(f"Unused features left out of the export: {', '.join(dropped)}")
 
 # Save as C files (same format as before)
-with open('ml/emg_model_new.h', 'w') as f:
-    f.write('#ifndef EMG_MODEL_H\n')
-    f.write('#define EMG_MODEL_H\n\n')
-    f.write('#include <stdint.h>\n\n')
-    f.write('typedef enum {\n')
-    for gesture, idx in gesture_mapping.items():
-        f.write(f'    GESTURE_{gesture.upper().replace("-", "_")} = {idx},\n')
-    f.write('} GestureType;\n\n')
-    f.write(f'#define NUM_FEATURES {X.shape[1]}\n')
-    f.write(f'#define NUM_CLASSES {len(gesture_mapping)}\n\n')
-    f.write('extern const float scaler_mean[NUM_FEATURES];\n')
-    f.write('extern const float scaler_scale[NUM_FEATURES];\n\n')
-    f.write('extern const float lr_coefficients[NUM_CLASSES][NUM_FEATURES];\n')
-    f.write('extern const float lr_intercept[NUM_CLASSES];\n\n')
-    f.write('extern const char* gesture_names[NUM_CLASSES];\n\n')
-    f.write('GestureType predict_gesture(const float* features);\n\n')
-    f.write('#endif // EMG_MODEL_H\n')
-
-with open('ml/emg_model_new.c', 'w') as f:
-    f.write('#include "emg_model.h"\n\n')
-    f.write('#include <math.h>\n\n')
-    
-    f.write('const float scaler_mean[NUM_FEATURES] = {\n')
-    for mean_val in scaler.mean_:
-        f.write(f'    {mean_val:.6f}f,\n')
-    f.write('};\n\n')
-    
-    f.write('const float scaler_scale[NUM_FEATURES] = {\n')
-    for scale_val in scaler.scale_:
-        f.write(f'    {scale_val:.6f}f,\n')
-    f.write('};\n\n')
-    
-    f.write('const float lr_coefficients[NUM_CLASSES][NUM_FEATURES] = {\n')
-    for class_idx in range(len(coef)):
-        f.write('    {\n')
-        for feat_idx in range(len(coef[class_idx])):
-            f.write(f'        {coef[class_idx][feat_idx]:.6f}f,\n')
-        f.write('    },\n')
-    f.write('};\n\n')
-    
-    f.write('const float lr_intercept[NUM_CLASSES] = {\n')
-    for intercept_val in intercept:
-        f.write(f'    {intercept_val:.6f}f,\n')
-    f.write('};\n\n')
-    
-    f.write('const char* gesture_names[NUM_CLASSES] = {\n')
-    for gesture in gesture_mapping.keys():
-        f.write(f'    "{gesture}",\n')
-    f.write('};\n\n')
-    
-    f.write('''
-GestureType predict_gesture(const float* features) {
-    float scores[NUM_CLASSES] = {0};
-    float max_score = -INFINITY;
-    int predicted_class = 0;
-    
-    float scaled_features[NUM_FEATURES];
-    for (int i = 0; i < NUM_FEATURES; i++) {
-        scaled_features[i] = (features[i] - scaler_mean[i]) / scaler_scale[i];
-    }
-    
-    for (int class_idx = 0; class_idx < NUM_CLASSES; class_idx++) {
-        scores[class_idx] = lr_intercept[class_idx];
-        for (int feat_idx = 0; feat_idx < NUM_FEATURES; feat_idx++) {
-            scores[class_idx] += lr_coefficients[class_idx][feat_idx] * scaled_features[feat_idx];
-        }
-        if (scores[class_idx] > max_score) {
-            max_score = scores[class_idx];
-            predicted_class = class_idx;
-        }
-    }
-    
-    return (GestureType)predicted_class;
-}
-''')
+write_model_header('ml/emg_model_new.h', gesture_mapping, len(scaler_mean), exported,
+                   prefilter=firmware_prefilter(), spectral=firmware_spectral(),
+                   time_features=time_features)
+write_model_source('ml/emg_model_new.c', scaler_mean, scaler_scale, exported,
+                   gesture_mapping, WINDOW_SIZE, spectral=firmware_spectral(),
+                   time_features=time_features)
 
 # Save Python model
 joblib.dump({
@@ -0,0 +1,88 @@
+#include "adc_acquisition.h"
+#include "adc_decimator.h"
+#include "main.h"
+#include "events.h"
+#include <string.h>
+
+#if ADC_OVERSAMPLE > ADC_DECIM_MAX_FACTOR
+#error "ADC_OVERSAMPLE is above ADC_DECIM_MAX_FACTOR"
+#endif
+
+#define ADC_SCAN_HALF (ADC_SCAN_LENGTH / 2)
+
+// The DMA target. The DMA owns the half it is writing, the interrupt the other one
+// until it has moved it into the queue.
+__attribute__((aligned(4))) static uint16_t adc_scan_buffer[ADC_SCAN_LENGTH];
+static FrameQueue adc_queue;
+#if ADC_OVERSAMPLE > 1
+static AdcDecimator adc_decimator;
+#endif
+// Timestamp of the next frame (interrupt only)
+static uint32_t adc_next_timestamp = 0;
+static ADC_AcqStats adc_stats;
+
+void adc_acq_start(void) {
+    frame_queue_init(&adc_queue);
+    adc_next_timestamp = 0;
+    adc_stats.frames_read = 0;
+    adc_stats.frames_lost = 0;
+    adc_stats.overruns = 0;
+    adc_stats.max_backlog = 0;
+#if ADC_OVERSAMPLE > 1
+    adc_decimator_init(&adc_decimator, NULL);
+#endif
+    HAL_ADC_Start_DMA(&hadc1, (uint32_t*)adc_scan_buffer, ADC_SCAN_LENGTH);
+}
+
+// The DMA has finished half 0 or 1 of the scan buffer
+static void adc_acq_half_done(uint32_t half) {
+    const uint16_t* scans = &adc_scan_buffer[half * ADC_SCAN_HALF];
+    AdcFrame frames[ADC_HALF_FRAMES];
+#if ADC_OVERSAMPLE > 1
+    // Each half is a whole number of output frames, so this yields ADC_HALF_FRAMES
+    uint16_t decimated[ADC_HALF_FRAMES][ADC_CHANNELS];
+    uint32_t count = adc_decimator_process(&adc_decimator, scans, ADC_SCAN_FRAMES / 2, decimated);
+    scans = &decimated[0][0];
+#else
+    uint32_t count = ADC_HALF_FRAMES;
+#endif
+    for (uint32_t i = 0; i < count; i++) {
+        frames[i].timestamp = adc_next_timestamp++;
+        memcpy(frames[i].ch, &scans[i * ADC_CHANNELS], sizeof(frames[i].ch));
+    }
+
+    // The DMA should be in the other half; if it is back in this one, it has been
+    // overwriting scans while they were copied
+    uint32_t pos = (ADC_SCAN_LENGTH - hdma_adc1.Instance->NDTR) % ADC_SCAN_LENGTH;
+    if (pos / ADC_SCAN_HALF == half) {
+        adc_stats.overruns++;
+    }
+
+    frame_queue_push(&adc_queue, frames, count);
+    events_post(EVT_ADC_DATA);
+}
+
+void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef* hadc) {
+    if (hadc->Instance == ADC1) {
+        adc_acq_half_done(0);
+    }
+}
+
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef* hadc) {
+    if (hadc->Instance == ADC1) {
+        adc_acq_half_done(1);
+    }
+}
+
+uint32_t adc_acq_read(AdcFrame* frames, uint32_t max_frames) {
+    uint32_t count = frame_queue_pop(&adc_queue, frames, max_frames);
+    adc_stats.frames_read += count;
+    return count;
+}
+
+const ADC_AcqStats* adc_acq_get_stats(void) {
+    // The producer's counters, as of the last push
+    adc_stats.frames_lost = adc_queue.dropped;
+    adc_stats.max_backlog = adc_queue.high_water;
+    return &adc_stats;
+}
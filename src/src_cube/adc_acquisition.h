@@ -0,0 +1,46 @@
+#ifndef ADC_ACQUISITION_H
+#define ADC_ACQUISITION_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "common_defs.h"
+#include "frame_queue.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+// TIM3 triggers ADC1 scans, and the DMA writes them to a small circular scan buffer.
+// Each half-transfer/complete interrupt owns the half the DMA has just left. It
+// turns that half into ADC_HALF_FRAMES timestamped frames (decimating by
+// ADC_OVERSAMPLE if that is above 1) and pushes them into a FRAME_QUEUE_FRAMES
+// queue, which the main loop drains. The main loop never touches memory the DMA
+// writes. 512 queued frames is ~340ms at 1500Hz, so the loop can block (UART, I2C)
+// for well over 100ms without losing a conversion. Frames arrive in bursts of
+// ADC_HALF_FRAMES (5.3ms at 1500Hz).
+#define ADC_HALF_FRAMES 8
+#define ADC_SCAN_FRAMES (2 * ADC_HALF_FRAMES * ADC_OVERSAMPLE)
+#define ADC_SCAN_LENGTH (ADC_SCAN_FRAMES * ADC_CHANNELS)
+
+// A scan of 4 conversions at 15 + 12 ADC clocks (PCLK2 / 2 = 25MHz) takes 4.3us
+#if ADC_SCAN_RATE_HZ > 100000
+#error "ADC_SCAN_RATE_HZ leaves too little time for a 4-channel scan"
+#endif
+
+typedef struct {
+    uint32_t frames_read;   // Frames handed to the consumer
+    uint32_t frames_lost;   // Frames dropped because the queue was full
+    uint32_t overruns;      // DMA halves handled after the DMA had come back into them
+    uint32_t max_backlog;   // Most frames ever waiting in the queue
+} ADC_AcqStats;
+
+void adc_acq_start(void);
+// Pops up to max_frames frames, oldest first; returns the count
+uint32_t adc_acq_read(AdcFrame* frames, uint32_t max_frames);
+const ADC_AcqStats* adc_acq_get_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ADC_ACQUISITION_H
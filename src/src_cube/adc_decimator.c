@@ -0,0 +1,146 @@
+#include "adc_decimator.h"
+#include <math.h>
+#include <string.h>
+
+#define PI_F 3.14159265f
+#define ADC_FULL_SCALE 4095
+#define MAX_EXTRA_BITS 2   // 4095 << 2 stays inside the emg_dsp lane limit
+#define COMP_ONE (1 << ADC_DECIM_COMP_BITS)
+
+// |sin(pi f R / fs) / (R sin(pi f / fs))|^N with fs the scan rate
+static float cic_gain(uint32_t factor, uint32_t order, float freq_hz) {
+    float x = PI_F * freq_hz / ((float)SAMPLING_RATE_HZ * factor);
+    float s = sinf(x);
+    float h = fabsf(s) < 1e-6f ? 1.0f : fabsf(sinf(x * factor) / (factor * s));
+    float gain = 1.0f;
+    for (uint32_t st = 0; st < order; st++) {
+        gain *= h;
+    }
+    return gain;
+}
+
+void adc_decimator_init(AdcDecimator* dec, const AdcDecimatorConfig* config) {
+    static const AdcDecimatorConfig defaults = ADC_DECIMATOR_DEFAULTS;
+    AdcDecimatorConfig c = config ? *config : defaults;
+    if (c.factor < 1) c.factor = 1;
+    if (c.factor > ADC_DECIM_MAX_FACTOR) c.factor = ADC_DECIM_MAX_FACTOR;
+    if (c.order < 1) c.order = 1;
+    if (c.order > ADC_DECIM_MAX_ORDER) c.order = ADC_DECIM_MAX_ORDER;
+    if (c.extra_bits > MAX_EXTRA_BITS) c.extra_bits = MAX_EXTRA_BITS;
+    dec->config = c;
+    dec->out_max = (uint16_t)(ADC_FULL_SCALE << c.extra_bits);
+
+    // 2^(norm_shift + extra_bits) / factor^order, rounded, in (2^29, 2^30]
+    uint64_t gain = 1;
+    for (uint32_t st = 0; st < c.order; st++) {
+        gain *= c.factor;
+    }
+    uint32_t bits = 0;
+    while ((1ull << bits) < gain) {
+        bits++;
+    }
+    dec->norm_shift = (uint8_t)(30 + bits - c.extra_bits);
+    dec->norm_mul = (int32_t)(((1ull << (30 + bits)) + gain / 2) / gain);
+
+    // Side tap a of [-a, 1 + 2a, -a] so that the cascade is 1 at ADC_DECIM_FLAT_HZ;
+    // 1 - cos(w) scales the compensator's lift at that frequency
+    dec->comp_tap = 0;
+    if (c.compensate && c.factor > 1) {
+        float droop = cic_gain(c.factor, c.order, ADC_DECIM_FLAT_HZ);
+        float lift = 2.0f * (1.0f - cosf(2.0f * PI_F * ADC_DECIM_FLAT_HZ / SAMPLING_RATE_HZ));
+        dec->comp_tap = (int32_t)lrintf((1.0f / droop - 1.0f) / lift * COMP_ONE);
+    }
+    adc_decimator_reset(dec);
+}
+
+void adc_decimator_reset(AdcDecimator* dec) {
+    memset(dec->offset, 0, sizeof(dec->offset));
+    memset(dec->integrator, 0, sizeof(dec->integrator));
+    memset(dec->comb, 0, sizeof(dec->comb));
+    memset(dec->history, 0, sizeof(dec->history));
+    dec->phase = 0;
+    dec->primed = false;
+}
+
+// Combs, compensator and scaling for one channel: v is the last integrator, in
+// scan counts relative to offset times factor^order (modulo 2^32)
+static inline uint16_t output_sample(AdcDecimator* dec, int ch, uint32_t v) {
+    for (uint32_t st = 0; st < dec->config.order; st++) {
+        uint32_t d = v - dec->comb[ch][st];
+        dec->comb[ch][st] = v;
+        v = d;
+    }
+    // The true value is within +/-4095 * 64^3, so the wrapped difference is exact
+    int32_t y = (int32_t)v;
+
+    int64_t z = y;
+    if (dec->comp_tap != 0) {
+        int32_t* h = dec->history[ch];
+        int64_t acc = (int64_t)(COMP_ONE + 2 * dec->comp_tap) * h[0] - (int64_t)dec->comp_tap * ((int64_t)y + h[1]);
+        z = (acc + (COMP_ONE / 2)) >> ADC_DECIM_COMP_BITS;
+        h[1] = h[0];
+        h[0] = y;
+    }
+
+    int64_t scaled = (z * dec->norm_mul + (1ll << (dec->norm_shift - 1))) >> dec->norm_shift;
+    int32_t out = ((int32_t)dec->offset[ch] << dec->config.extra_bits) + (int32_t)scaled;
+    if (out < 0) return 0;
+    if (out > dec->out_max) return dec->out_max;
+    return (uint16_t)out;
+}
+
+uint32_t adc_decimator_process(AdcDecimator* dec, const uint16_t* scans, uint32_t n,
+                               uint16_t out[][ADC_CHANNELS]) {
+    if (n == 0) {
+        return 0;
+    }
+    if (!dec->primed) {
+        for (int ch = 0; ch < ADC_CHANNELS; ch++) {
+            dec->offset[ch] = scans[ch];
+        }
+        dec->primed = true;
+    }
+
+    // Channel by channel, so a channel's integrators stay in registers over the block
+    const uint32_t factor = dec->config.factor;
+    const uint32_t order = dec->config.order;
+    uint32_t phase = dec->phase;
+    uint32_t frames = 0;
+    for (int ch = 0; ch < ADC_CHANNELS; ch++) {
+        uint32_t acc[ADC_DECIM_MAX_ORDER];
+        memcpy(acc, dec->integrator[ch], sizeof(acc));
+        const uint32_t offset = dec->offset[ch];
+        const uint16_t* x = scans + ch;
+        phase = dec->phase;
+        frames = 0;
+        for (uint32_t i = 0; i < n; i++, x += ADC_CHANNELS) {
+            uint32_t v = *x - offset;
+            for (uint32_t st = 0; st < order; st++) {
+                acc[st] += v;
+                v = acc[st];
+            }
+            if (++phase == factor) {
+                phase = 0;
+                out[frames++][ch] = output_sample(dec, ch, v);
+            }
+        }
+        memcpy(dec->integrator[ch], acc, sizeof(acc));
+    }
+    dec->phase = (uint8_t)phase;
+    return frames;
+}
+
+float adc_decimator_gain(const AdcDecimator* dec, float freq_hz) {
+    float gain = cic_gain(dec->config.factor, dec->config.order, freq_hz);
+    if (dec->comp_tap != 0) {
+        // The compensator runs at the output rate, so an aliased tone sees it at its alias
+        float w = 2.0f * PI_F * freq_hz / SAMPLING_RATE_HZ;
+        gain *= fabsf((float)(COMP_ONE + 2 * dec->comp_tap) - 2.0f * dec->comp_tap * cosf(w)) / COMP_ONE;
+    }
+    return gain;
+}
+
+uint32_t adc_decimator_budget_cycles(const AdcDecimator* dec) {
+    uint32_t per_scan = ADC_DECIM_SCAN_CYCLES + ADC_DECIM_STAGE_CYCLES * dec->config.order;
+    return ADC_CHANNELS * (dec->config.factor * per_scan + ADC_DECIM_OUTPUT_CYCLES);
+}
@@ -0,0 +1,78 @@
+#ifndef ADC_DECIMATOR_H
+#define ADC_DECIMATOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "common_defs.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+// Decimator between the oversampled ADC scans (ADC_SCAN_RATE_HZ) and the frames the
+// pipeline sees (SAMPLING_RATE_HZ): an integer CIC filter of ADC_DECIM_ORDER stages
+// decimating by ADC_OVERSAMPLE, then a 3-tap FIR at the output rate that lifts the
+// CIC's sinc^N droop back to flat at ADC_DECIM_FLAT_HZ. Averaging the extra scans
+// lowers the ADC noise, and the CIC nulls at multiples of SAMPLING_RATE_HZ suppress
+// what would otherwise alias into the EMG band.
+#define ADC_DECIM_ORDER 3
+#define ADC_DECIM_MAX_ORDER 3
+// 12-bit scans times ADC_OVERSAMPLE^ADC_DECIM_ORDER must fit the 32-bit registers
+#define ADC_DECIM_MAX_FACTOR 64
+#define ADC_DECIM_FLAT_HZ 450.0f
+
+// Fixed point: the compensator taps are Q14. The 1 / factor^order gain normalisation
+// is a multiply by a Q30-sized constant and a rounding shift, exact for powers of two.
+#define ADC_DECIM_COMP_BITS 14
+
+// Cortex-M4 budget: each integrator stage is a load-free ADD per channel and scan
+// (the states stay in registers across a block), plus the loop and the load of the
+// scan; the combs, compensator and scaling run once per channel and output frame.
+#define ADC_DECIM_STAGE_CYCLES 1
+#define ADC_DECIM_SCAN_CYCLES 3
+#define ADC_DECIM_OUTPUT_CYCLES 30
+
+typedef struct {
+    uint8_t factor;       // Scans per output frame, 1..ADC_DECIM_MAX_FACTOR
+    uint8_t order;        // CIC stages, 1..ADC_DECIM_MAX_ORDER
+    bool compensate;      // Droop compensator on the output
+    uint8_t extra_bits;   // Fractional bits kept in the output (0 = ADC counts)
+} AdcDecimatorConfig;
+
+#define ADC_DECIMATOR_DEFAULTS { ADC_OVERSAMPLE, ADC_DECIM_ORDER, true, 0 }
+
+typedef struct {
+    AdcDecimatorConfig config;
+    int32_t comp_tap;     // Q14 side tap of [-a, 1 + 2a, -a]
+    int32_t norm_mul;
+    uint8_t norm_shift;
+    uint16_t out_max;     // Full scale of the output, 4095 << extra_bits
+    uint8_t phase;        // Scans into the current output frame
+    bool primed;
+    // Scans are integrated relative to the first one, so the CIC and the
+    // compensator start in steady state instead of stepping up from 0
+    uint16_t offset[ADC_CHANNELS];
+    uint32_t integrator[ADC_CHANNELS][ADC_DECIM_MAX_ORDER];
+    uint32_t comb[ADC_CHANNELS][ADC_DECIM_MAX_ORDER];      // Previous comb inputs
+    int32_t history[ADC_CHANNELS][2];                      // Previous CIC outputs
+} AdcDecimator;
+
+// config may be NULL for ADC_DECIMATOR_DEFAULTS; out-of-range fields are clamped
+void adc_decimator_init(AdcDecimator* dec, const AdcDecimatorConfig* config);
+// Clears the state; the next scan primes it again
+void adc_decimator_reset(AdcDecimator* dec);
+// Feeds n scans of ADC_CHANNELS interleaved 12-bit samples and writes an output frame
+// every factor scans; returns the number of frames written (at most n / factor + 1).
+// Any split of a scan stream into calls gives the same output.
+uint32_t adc_decimator_process(AdcDecimator* dec, const uint16_t* scans, uint32_t n,
+                               uint16_t out[][ADC_CHANNELS]);
+// |H| from the scan input to the output at freq_hz (input rate), CIC and compensator
+float adc_decimator_gain(const AdcDecimator* dec, float freq_hz);
+// Cortex-M4 cycles per output frame
+uint32_t adc_decimator_budget_cycles(const AdcDecimator* dec);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ADC_DECIMATOR_H
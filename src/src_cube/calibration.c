@@ -0,0 +1,271 @@
+#include "calibration.h"
+#include "telemetry.h"
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+#define CALIB_MAGIC 0x314C4143U  // "CAL1"
+// Added to the diagonal of the standardised covariance; keeps the Cholesky factor
+// well conditioned when features are nearly collinear or constant
+#define CALIB_SHRINKAGE 0.01f
+
+typedef struct {
+    uint32_t magic;
+    uint16_t num_features;
+    uint16_t num_classes;
+    CalibratedModel model;
+    uint32_t crc;            // telemetry_crc16 of everything above
+} CalibrationRecord;
+
+// Fit scratch, kept off the stack
+static float fit_cov[TOTAL_FEATURES][TOTAL_FEATURES];
+static float fit_mu[NUM_CLASSES][TOTAL_FEATURES];
+static CalibrationRecord staged_record;
+
+void calibration_init(Calibration* cal) {
+    memset(cal, 0, sizeof(*cal));
+    cal->mode = MODE_IDLE;
+}
+
+void calibration_start(Calibration* cal, uint8_t trials, CalibrationFit fit, uint32_t now_ms) {
+    calibration_init(cal);
+    cal->trials = trials < 1 ? 1 : (trials > TRIALS_PER_GESTURE ? TRIALS_PER_GESTURE : trials);
+    cal->fit = fit;
+    cal->mode = MODE_COLLECTING;
+    cal->phase_start_ms = now_ms;
+}
+
+CalibrationEvent calibration_tick(Calibration* cal, uint32_t now_ms) {
+    if (cal->mode != MODE_COLLECTING) {
+        return CALIB_EVT_NONE;
+    }
+    uint32_t elapsed = now_ms - cal->phase_start_ms;
+    if (!cal->recording) {
+        if (elapsed < CALIB_PROMPT_MS) {
+            return CALIB_EVT_NONE;
+        }
+        cal->recording = true;
+        cal->phase_start_ms = now_ms;
+        return CALIB_EVT_RECORD;
+    }
+    if (elapsed < CALIB_TRIAL_MS) {
+        return CALIB_EVT_NONE;
+    }
+
+    cal->recording = false;
+    cal->phase_start_ms = now_ms;
+    if (++cal->trial < cal->trials) {
+        return CALIB_EVT_PROMPT;
+    }
+    cal->trial = 0;
+    if (++cal->gesture < NUM_CLASSES) {
+        return CALIB_EVT_PROMPT;
+    }
+    cal->mode = MODE_PROCESSING;
+    return CALIB_EVT_DONE;
+}
+
+GestureType calibration_gesture(const Calibration* cal) {
+    return (GestureType)(cal->gesture < NUM_CLASSES ? cal->gesture : NUM_CLASSES - 1);
+}
+
+void calibration_add_window(Calibration* cal, const float* features) {
+    if (cal->mode != MODE_COLLECTING || !cal->recording) {
+        return;
+    }
+    float* mean = cal->mean[cal->gesture];
+    float n = (float)++cal->windows[cal->gesture];
+    float delta[TOTAL_FEATURES];
+
+    for (int i = 0; i < TOTAL_FEATURES; i++) {
+        delta[i] = features[i] - mean[i];
+        mean[i] += delta[i] / n;
+    }
+    // delta_i * (x_j - new mean_j) is the co-moment increment; summing it over all
+    // classes gives the pooled within-class scatter directly
+    for (int i = 0; i < TOTAL_FEATURES; i++) {
+        for (int j = i; j < TOTAL_FEATURES; j++) {
+            cal->scatter[i][j] += delta[i] * (features[j] - mean[j]);
+        }
+    }
+}
+
+// In-place lower Cholesky factor of a symmetric positive definite matrix
+static bool cholesky(float a[TOTAL_FEATURES][TOTAL_FEATURES]) {
+    for (int j = 0; j < TOTAL_FEATURES; j++) {
+        float d = a[j][j];
+        for (int k = 0; k < j; k++) {
+            d -= a[j][k] * a[j][k];
+        }
+        if (!(d > 0.0f)) {
+            return false;
+        }
+        a[j][j] = sqrtf(d);
+        for (int i = j + 1; i < TOTAL_FEATURES; i++) {
+            float v = a[i][j];
+            for (int k = 0; k < j; k++) {
+                v -= a[i][k] * a[j][k];
+            }
+            a[i][j] = v / a[j][j];
+        }
+    }
+    return true;
+}
+
+// Solves L L^T x = b with the factor from cholesky()
+static void cholesky_solve(const float l[TOTAL_FEATURES][TOTAL_FEATURES], const float* b, float* x) {
+    for (int i = 0; i < TOTAL_FEATURES; i++) {
+        float v = b[i];
+        for (int k = 0; k < i; k++) {
+            v -= l[i][k] * x[k];
+        }
+        x[i] = v / l[i][i];
+    }
+    for (int i = TOTAL_FEATURES - 1; i >= 0; i--) {
+        float v = x[i];
+        for (int k = i + 1; k < TOTAL_FEATURES; k++) {
+            v -= l[k][i] * x[k];
+        }
+        x[i] = v / l[i][i];
+    }
+}
+
+bool calibration_fit(const Calibration* cal, CalibratedModel* model) {
+    uint32_t total = 0;
+    for (int c = 0; c < NUM_CLASSES; c++) {
+        if (cal->windows[c] < 2) {
+            return false;
+        }
+        total += cal->windows[c];
+    }
+
+    // Grand mean and standard deviation: within-class scatter plus the spread of the
+    // class means. Constant features (e.g. an unconnected channel) keep scale 1.
+    for (int i = 0; i < TOTAL_FEATURES; i++) {
+        float m = 0.0f;
+        for (int c = 0; c < NUM_CLASSES; c++) {
+            m += cal->windows[c] * cal->mean[c][i];
+        }
+        m /= (float)total;
+        float ss = cal->scatter[i][i];
+        for (int c = 0; c < NUM_CLASSES; c++) {
+            float d = cal->mean[c][i] - m;
+            ss += cal->windows[c] * d * d;
+        }
+        float s = sqrtf(ss / (float)total);
+        model->scaler_mean[i] = m;
+        model->scaler_scale[i] = s > 1e-6f ? s : 1.0f;
+    }
+    for (int c = 0; c < NUM_CLASSES; c++) {
+        for (int i = 0; i < TOTAL_FEATURES; i++) {
+            fit_mu[c][i] = (cal->mean[c][i] - model->scaler_mean[i]) / model->scaler_scale[i];
+        }
+    }
+
+    model->fit = cal->fit;
+    if (cal->fit == CALIB_LDA) {
+        float dof = (float)(total - NUM_CLASSES);
+        for (int i = 0; i < TOTAL_FEATURES; i++) {
+            for (int j = i; j < TOTAL_FEATURES; j++) {
+                float v = cal->scatter[i][j] / dof / (model->scaler_scale[i] * model->scaler_scale[j]);
+                fit_cov[i][j] = v;
+                fit_cov[j][i] = v;
+            }
+            fit_cov[i][i] += CALIB_SHRINKAGE;
+        }
+        if (!cholesky(fit_cov)) {
+            model->fit = CALIB_CENTROID;
+        }
+    }
+
+    for (int c = 0; c < NUM_CLASSES; c++) {
+        float* w = model->weights[c];
+        if (model->fit == CALIB_LDA) {
+            // w = S^-1 mu, b = -mu^T S^-1 mu / 2 + log prior
+            cholesky_solve(fit_cov, fit_mu[c], w);
+            float q = 0.0f;
+            for (int i = 0; i < TOTAL_FEATURES; i++) {
+                q += fit_mu[c][i] * w[i];
+            }
+            model->bias[c] = -0.5f * q + logf((float)cal->windows[c] / (float)total);
+        } else {
+            // argmax of mu.x - |mu|^2 / 2 is the nearest centroid
+            float q = 0.0f;
+            for (int i = 0; i < TOTAL_FEATURES; i++) {
+                w[i] = fit_mu[c][i];
+                q += w[i] * w[i];
+            }
+            model->bias[c] = -0.5f * q;
+        }
+    }
+    return true;
+}
+
+void calibration_descriptor(const CalibratedModel* model, ModelDescriptor* desc) {
+    memset(desc, 0, sizeof(*desc));
+    desc->type = MODEL_LDA;  // Both fits are linear with softmax probabilities
+    desc->num_features = TOTAL_FEATURES;
+    desc->num_classes = NUM_CLASSES;
+    desc->scaler_mean = model->scaler_mean;
+    desc->scaler_scale = model->scaler_scale;
+    desc->weights = &model->weights[0][0];
+    desc->bias = model->bias;
+}
+
+static const CalibrationRecord* flash_record(void) {
+#ifdef HAL_SHIM
+    return (const CalibrationRecord*)hal_shim_flash_ptr(CALIB_FLASH_ADDR);
+#else
+    return (const CalibrationRecord*)CALIB_FLASH_ADDR;
+#endif
+}
+
+static bool erase_sector(void) {
+    FLASH_EraseInitTypeDef erase = { 0 };
+    uint32_t sector_error = 0;
+    erase.TypeErase = FLASH_TYPEERASE_SECTORS;
+    erase.Sector = CALIB_FLASH_SECTOR;
+    erase.NbSectors = 1;
+    erase.VoltageRange = FLASH_VOLTAGE_RANGE_3;
+    return HAL_FLASHEx_Erase(&erase, &sector_error) == HAL_OK;
+}
+
+bool calibration_save(const CalibratedModel* model) {
+    CalibrationRecord* rec = &staged_record;
+    memset(rec, 0, sizeof(*rec));
+    rec->magic = CALIB_MAGIC;
+    rec->num_features = TOTAL_FEATURES;
+    rec->num_classes = NUM_CLASSES;
+    rec->model = *model;
+    rec->crc = telemetry_crc16((const uint8_t*)rec, offsetof(CalibrationRecord, crc));
+
+    HAL_FLASH_Unlock();
+    bool ok = erase_sector();
+    const uint32_t* words = (const uint32_t*)rec;
+    for (uint32_t i = 0; ok && i < sizeof(*rec) / 4; i++) {
+        ok = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, CALIB_FLASH_ADDR + 4 * i, words[i]) == HAL_OK;
+    }
+    HAL_FLASH_Lock();
+    return ok && calibration_stored() != NULL;
+}
+
+bool calibration_clear(void) {
+    HAL_FLASH_Unlock();
+    bool ok = erase_sector();
+    HAL_FLASH_Lock();
+    return ok;
+}
+
+const CalibratedModel* calibration_stored(void) {
+    const CalibrationRecord* rec = flash_record();
+    if (rec->magic != CALIB_MAGIC || rec->num_features != TOTAL_FEATURES
+        || rec->num_classes != NUM_CLASSES
+        || rec->crc != telemetry_crc16((const uint8_t*)rec, offsetof(CalibrationRecord, crc))) {
+        return NULL;
+    }
+    return &rec->model;
+}
+
+const char* calibration_fit_name(CalibrationFit fit) {
+    return fit == CALIB_LDA ? "lda" : "centroid";
+}
@@ -0,0 +1,88 @@
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f4xx_hal.h"
+#include "common_defs.h"
+#include "emg_classifier.h"
+#include "model_runtime.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+// On-device calibration. The user is prompted through every gesture; each window of
+// a trial updates that class's mean and the pooled within-class scatter (Welford), so
+// nothing but the statistics is kept. The fit standardises the features and solves
+// LDA (or takes the class centroids) into a linear ModelDescriptor, which is stored in
+// the last flash sector and picked up again at boot.
+
+#define CALIB_PROMPT_MS 2000                 // Lead-in before each trial, windows unused
+#define CALIB_TRIAL_MS COLLECTION_DURATION_MS
+
+// Last 128 KB sector of the F401CC. The application must stay below it
+// (board_upload.maximum_size in platformio.ini).
+#define CALIB_FLASH_SECTOR FLASH_SECTOR_5
+#define CALIB_FLASH_ADDR 0x08020000U
+
+typedef enum {
+    CALIB_LDA = 0,    // Shared covariance, w_c = S^-1 mu_c
+    CALIB_CENTROID,   // Nearest class mean in standardised units
+} CalibrationFit;
+
+typedef enum {
+    CALIB_EVT_NONE = 0,
+    CALIB_EVT_PROMPT,   // Show the next gesture (calibration_gesture())
+    CALIB_EVT_RECORD,   // Trial started
+    CALIB_EVT_DONE,     // All trials collected, mode is MODE_PROCESSING
+} CalibrationEvent;
+
+typedef struct {
+    CollectionMode mode;
+    CalibrationFit fit;
+    uint8_t trials;          // Per gesture, 1..TRIALS_PER_GESTURE
+    uint8_t trial;
+    uint8_t gesture;
+    bool recording;          // False during the prompt lead-in
+    uint32_t phase_start_ms;
+    uint32_t windows[NUM_CLASSES];
+    float mean[NUM_CLASSES][TOTAL_FEATURES];
+    // Sum over windows of (x - mean_c)(x - mean_c)^T, upper triangle only
+    float scatter[TOTAL_FEATURES][TOTAL_FEATURES];
+} Calibration;
+
+// The fitted model; a linear ModelDescriptor points into it
+typedef struct {
+    uint32_t fit;   // CalibrationFit actually used (LDA falls back to centroids)
+    float scaler_mean[TOTAL_FEATURES];
+    float scaler_scale[TOTAL_FEATURES];
+    float weights[NUM_CLASSES][TOTAL_FEATURES];
+    float bias[NUM_CLASSES];
+} CalibratedModel;
+
+void calibration_init(Calibration* cal);
+void calibration_start(Calibration* cal, uint8_t trials, CalibrationFit fit, uint32_t now_ms);
+// Advances the prompt/trial schedule; call at least every hop
+CalibrationEvent calibration_tick(Calibration* cal, uint32_t now_ms);
+// Raw (unnormalised) features of one window; used only while a trial is recording
+void calibration_add_window(Calibration* cal, const float* features);
+GestureType calibration_gesture(const Calibration* cal);
+
+// Fits cal->fit; false if a gesture has fewer than two windows
+bool calibration_fit(const Calibration* cal, CalibratedModel* model);
+void calibration_descriptor(const CalibratedModel* model, ModelDescriptor* desc);
+
+// Erases the sector and programs the model (blocks for the sector erase, ~1-2s)
+bool calibration_save(const CalibratedModel* model);
+bool calibration_clear(void);
+// The model in flash if its header and CRC check out, otherwise NULL
+const CalibratedModel* calibration_stored(void);
+
+const char* calibration_fit_name(CalibrationFit fit);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CALIBRATION_H
@@ -9,6 +9,12 @@ extern "C" {
 
 #define ADC_CHANNELS 4
 #define SAMPLING_RATE_HZ 1500
+// ADC scans per frame: TIM3 triggers ADC1 at ADC_SCAN_RATE_HZ and adc_decimator.c
+// brings the scans down to SAMPLING_RATE_HZ. 1 = one scan per frame, no decimator.
+#ifndef ADC_OVERSAMPLE
+#define ADC_OVERSAMPLE 1
+#endif
+#define ADC_SCAN_RATE_HZ (SAMPLING_RATE_HZ * ADC_OVERSAMPLE)
 #define BUFFER_SIZE_MS 1000
 #define BUFFER_SAMPLES ((SAMPLING_RATE_HZ * BUFFER_SIZE_MS) / 1000)
 
@@ -0,0 +1,58 @@
+#include "console.h"
+#include "events.h"
+#include "telemetry.h"
+#include <string.h>
+
+static UART_HandleTypeDef *rx_uart = NULL;
+static uint8_t rx_byte;
+
+// Line being received in the interrupt, and the last complete one for the main loop
+static char rx_line[CONSOLE_LINE_MAX];
+static uint32_t rx_len = 0;
+static char ready_line[CONSOLE_LINE_MAX];
+static volatile bool line_ready = false;
+
+void console_init(UART_HandleTypeDef *huart) {
+    rx_uart = huart;
+    rx_len = 0;
+    line_ready = false;
+    HAL_UART_Receive_IT(rx_uart, &rx_byte, 1);
+}
+
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart) {
+    if (huart != rx_uart) {
+        return;
+    }
+    if (rx_byte == '\n' || rx_byte == '\r') {
+        // A line arriving before the previous one was read is dropped
+        if (rx_len > 0 && !line_ready) {
+            memcpy(ready_line, rx_line, rx_len);
+            ready_line[rx_len] = '\0';
+            line_ready = true;
+            events_post(EVT_CONSOLE_LINE);
+        }
+        rx_len = 0;
+    } else if (rx_len < CONSOLE_LINE_MAX - 1) {
+        rx_line[rx_len++] = (char)rx_byte;
+    }
+    HAL_UART_Receive_IT(rx_uart, &rx_byte, 1);
+}
+
+// Console and telemetry share the UART, so the error may hit either direction
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart) {
+    if (huart == rx_uart) {
+        rx_len = 0;
+        HAL_UART_Receive_IT(rx_uart, &rx_byte, 1);
+    }
+    telemetry_uart_error(huart);
+}
+
+bool console_read_line(char *line, uint32_t size) {
+    if (!line_ready || size == 0) {
+        return false;
+    }
+    strncpy(line, ready_line, size - 1);
+    line[size - 1] = '\0';
+    line_ready = false;
+    return true;
+}
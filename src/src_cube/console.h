@@ -0,0 +1,23 @@
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f4xx_hal.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+// Line-based commands received on the UART one byte at a time by interrupt
+#define CONSOLE_LINE_MAX 32
+
+void console_init(UART_HandleTypeDef *huart);
+// Copies the next complete line (without CR/LF) and returns true, or returns false
+bool console_read_line(char *line, uint32_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CONSOLE_H
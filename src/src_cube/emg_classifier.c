@@ -1,24 +1,99 @@
 #include "emg_classifier.h"
 #include "emg_model.h"
+#include <assert.h>
+#include <string.h>
+
+// Features of filtered samples are on a different scale from the raw counts
+#if !defined(EMG_FEATURES_ONLY) && EMG_PREFILTER != EMG_MODEL_PREFILTER
+#warning "EMG_PREFILTER differs from the exported model's; retrain (ml/) or calibrate on the device"
+#endif
 
 // Initialize EMG buffer
 void emg_buffer_init(EMG_Buffer* buffer) {
     buffer->write_index = 0;
     buffer->is_full = false;
-    for (int i = 0; i < WINDOW_SIZE; i++) {
-        for (int ch = 0; ch < NUM_CHANNELS; ch++) {
-            buffer->data[i][ch] = 0;
+    for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+        for (int i = 0; i < 2 * WINDOW_SIZE; i++) {
+            buffer->data[ch][i] = 0;
         }
     }
+    memset(buffer->sums, 0, sizeof(buffer->sums));
+#if EMG_PREFILTER
+    emg_filter_init(&buffer->filter, NULL);
+#endif
+}
+
+static inline int32_t abs_i32(int32_t v) {
+    return v < 0 ? -v : v;
+}
+
+// Same tests as emg_dsp_channel_stats(). Zero crossing: one sample >= 0, the other
+// < 0, and far enough apart that noise around zero does not count.
+static inline int32_t is_zero_crossing(int16_t prev, int16_t val) {
+    return (prev < 0) != (val < 0) && abs_i32((int32_t)val - prev) >= EMG_ZC_DEADBAND;
+}
+
+// Slope sign change at mid: a local peak or trough of at least the threshold
+static inline int32_t is_slope_change(int16_t before, int16_t mid, int16_t after) {
+    return ((int32_t)mid - before) * ((int32_t)mid - after) >= EMG_SSC_THRESHOLD;
+}
+
+static inline int32_t is_willison(int16_t prev, int16_t val) {
+    return abs_i32((int32_t)val - prev) >= EMG_WAMP_THRESHOLD;
 }
 
 // Add a new sample to the buffer
 void emg_buffer_add_sample(EMG_Buffer* buffer, int16_t ch1, int16_t ch2, int16_t ch3, int16_t ch4) {
-    buffer->data[buffer->write_index][0] = ch1;
-    buffer->data[buffer->write_index][1] = ch2;
-    buffer->data[buffer->write_index][2] = ch3;
-    buffer->data[buffer->write_index][3] = ch4;
-    
+    int16_t sample[NUM_CHANNELS] = { ch1, ch2, ch3, ch4 };
+#if EMG_PREFILTER
+    emg_filter_process(&buffer->filter, sample, sample);
+#endif
+    emg_buffer_push(buffer, sample);
+}
+
+// The EMG_TIME_STATS tests are constant, so disabled features cost nothing here
+void emg_buffer_push(EMG_Buffer* buffer, const int16_t sample[NUM_CHANNELS]) {
+    const uint32_t stats = EMG_TIME_STATS;
+    uint16_t idx = buffer->write_index;
+    bool has_prev = buffer->is_full || idx > 0;
+    bool has_prev2 = buffer->is_full || idx > 1;
+
+    for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+        EMG_ChannelSums* s = &buffer->sums[ch];
+        // The window oldest first starts at idx; the newest sample is at idx + WINDOW_SIZE - 1
+        const int16_t* w = &buffer->data[ch][idx];
+
+        if (buffer->is_full) {
+            // The oldest sample leaves, with its pair and the triple centred on the next one
+            int16_t old = w[0];
+            int16_t after = w[1];
+            if (stats & EMG_DSP_SUM_ABS) s->sum_abs -= abs_i32(old);
+            if (stats & EMG_DSP_SUM_SQR) s->sum_sqr -= (int32_t)old * old;
+            if (stats & EMG_DSP_SUM) s->sum -= old;
+            if (stats & EMG_DSP_SUM_DIFF) s->sum_diff -= abs_i32((int32_t)after - old);
+            if (stats & EMG_DSP_ZC) s->zero_crossings -= is_zero_crossing(old, after);
+            if (stats & EMG_DSP_WAMP) s->willison -= is_willison(old, after);
+            if (stats & EMG_DSP_SSC) s->slope_changes -= is_slope_change(old, after, w[2]);
+        }
+
+        int16_t val = sample[ch];
+        if (stats & EMG_DSP_SUM_ABS) s->sum_abs += abs_i32(val);
+        if (stats & EMG_DSP_SUM_SQR) s->sum_sqr += (int32_t)val * val;
+        if (stats & EMG_DSP_SUM) s->sum += val;
+        if (has_prev) {
+            int16_t before = w[WINDOW_SIZE - 1];
+            if (stats & EMG_DSP_SUM_DIFF) s->sum_diff += abs_i32((int32_t)val - before);
+            if (stats & EMG_DSP_ZC) s->zero_crossings += is_zero_crossing(before, val);
+            if (stats & EMG_DSP_WAMP) s->willison += is_willison(before, val);
+            if ((stats & EMG_DSP_SSC) && has_prev2) {
+                s->slope_changes += is_slope_change(w[WINDOW_SIZE - 2], before, val);
+            }
+        }
+
+        buffer->data[ch][idx] = val;
+        buffer->data[ch][idx + WINDOW_SIZE] = val;
+    }
+
     buffer->write_index++;
     if (buffer->write_index >= WINDOW_SIZE) {
         buffer->write_index = 0;
@@ -26,60 +101,78 @@ void emg_buffer_add_sample(EMG_Buffer* buffer, int16_t ch1, int16_t ch2, int16_t
     }
 }
 
-// Extract features from window (optimized for STM32)
-void extract_features_from_window(const int16_t window[WINDOW_SIZE][NUM_CHANNELS], float* features) {
+static const EmgDspThresholds feature_thresholds = EMG_FEATURE_THRESHOLDS;
+
+// Window sums of one channel in one pass, two samples per instruction (see emg_dsp.h)
+static void channel_window_sums(const int16_t* x, EMG_ChannelSums* s) {
+    emg_dsp_channel_stats(x, WINDOW_SIZE, EMG_TIME_STATS, &feature_thresholds, s);
+}
+
+// IMPORTANT: Feature order MUST match Python training
+// Python order: the enabled ones of [mav, rms, var, wl, zc, ssc, wamp] for each channel
+static void features_from_sums(const EMG_ChannelSums* s, float* features) {
+    float* f = features;
+#if EMG_TIME_FEATURES & FEATURE_MAV
+    // Mean Absolute Value (MAV)
+    *f++ = (float)s->sum_abs / WINDOW_SIZE;
+#endif
+#if EMG_TIME_FEATURES & FEATURE_RMS
+    // Root Mean Square (RMS)
+    *f++ = sqrtf((float)s->sum_sqr / WINDOW_SIZE);
+#endif
+#if EMG_TIME_FEATURES & FEATURE_VAR
+    // Variance: the integer sums are exact, so N*sum(x^2) - sum(x)^2 in 64 bits has
+    // none of the cancellation of the float single-pass formula
+    int64_t var_num = (int64_t)WINDOW_SIZE * s->sum_sqr - (int64_t)s->sum * s->sum;
+    *f++ = (float)var_num / ((float)WINDOW_SIZE * WINDOW_SIZE);
+#endif
+#if EMG_TIME_FEATURES & FEATURE_WL
+    // Waveform Length (WL)
+    *f++ = (float)s->sum_diff;
+#endif
+#if EMG_TIME_FEATURES & FEATURE_ZC
+    // Zero Crossings (ZC) outside the deadband
+    *f++ = (float)s->zero_crossings;
+#endif
+#if EMG_TIME_FEATURES & FEATURE_SSC
+    // Slope Sign Changes (SSC)
+    *f++ = (float)s->slope_changes;
+#endif
+#if EMG_TIME_FEATURES & FEATURE_WAMP
+    // Willison Amplitude (WAMP)
+    *f++ = (float)s->willison;
+#endif
+    (void)f;
+}
+
+// Extract features from a channel-major window
+void extract_features_from_window(const int16_t window[NUM_CHANNELS][WINDOW_SIZE], float* features) {
     for (int ch = 0; ch < NUM_CHANNELS; ch++) {
-        float sum_abs = 0;
-        float sum_sqr = 0;
-        float sum = 0;
-        float sum_diff = 0;
-        int zero_crossings = 0;
-        
-        // Calculate basic statistics
-        for (int i = 0; i < WINDOW_SIZE; i++) {
-            float val = window[i][ch];
-            sum_abs += fabsf(val);
-            sum_sqr += val * val;
-            sum += val;
-            
-            if (i > 0) {
-                float diff = val - window[i-1][ch];
-                sum_diff += fabsf(diff);
-                
-                // Zero crossing detection
-                if ((val >= 0 && window[i-1][ch] < 0) || (val < 0 && window[i-1][ch] >= 0)) {
-                    zero_crossings++;
-                }
-            }
-        }
-        
-        // IMPORTANT: Feature order MUST match Python training
-        // Python order: [mav, rms, var, wl, zc] for each channel
-        int base_idx = ch * FEATURES_PER_CHANNEL;
-        
-        // Feature 1: Mean Absolute Value (MAV)
-        features[base_idx + 0] = sum_abs / WINDOW_SIZE;
-        
-        // Feature 2: Root Mean Square (RMS)
-        features[base_idx + 1] = sqrtf(sum_sqr / WINDOW_SIZE);
-        
-        // Feature 3: Variance
-        float mean = sum / WINDOW_SIZE;
-        float variance = 0;
-        for (int i = 0; i < WINDOW_SIZE; i++) {
-            float diff = window[i][ch] - mean;
-            variance += diff * diff;
-        }
-        features[base_idx + 2] = variance / WINDOW_SIZE;
-        
-        // Feature 4: Waveform Length (WL)
-        features[base_idx + 3] = sum_diff;
-        
-        // Feature 5: Zero Crossing (ZC)
-        features[base_idx + 4] = zero_crossings;
+        EMG_ChannelSums s;
+        channel_window_sums(window[ch], &s);
+        features_from_sums(&s, &features[ch * FEATURES_PER_CHANNEL]);
+#if EMG_SPECTRAL_FEATURES
+        emg_spectrum_features(window[ch], WINDOW_SIZE,
+                              &features[ch * FEATURES_PER_CHANNEL + TIME_FEATURES_PER_CHANNEL]);
+#endif
     }
 }
 
+// Model fitted on the device (calibration.c), NULL for the exported emg_model
+static const ModelDescriptor* active_model = NULL;
+
+// A descriptor over the MODEL_MAX_* limits would overrun model_predict()'s stack
+// scratch; without assert() checking, the exported model stays in use instead
+void classifier_set_model(const ModelDescriptor* model) {
+    bool valid = model == NULL || model_descriptor_valid(model);
+    assert(valid);
+    active_model = valid ? model : NULL;
+}
+
+const ModelDescriptor* classifier_get_model(void) {
+    return active_model ? active_model : &emg_model_descriptor;
+}
+
 // Classify gesture using logistic regression model
 GestureType classify_gesture(const float* features) {
     // Verify feature count
@@ -87,28 +180,132 @@ GestureType classify_gesture(const float* features) {
         // Debug error
         return GESTURE_REST;
     }
+    if (active_model) {
+        return (GestureType)model_predict(active_model, features, NULL);
+    }
     return predict_gesture(features);
 }
 
+GestureType classify_gesture_proba(const float* features, float* probs) {
+    if (active_model) {
+        return (GestureType)model_predict_proba(active_model, features, probs);
+    }
+    return predict_gesture_proba(features, probs);
+}
+
+// The integer tables are folded for the time-domain features only
+#if EMG_MODEL_FIXED_POINT && !EMG_SPECTRAL_FEATURES
+// Integer version of the fixed-point path
+GestureType classify_gesture_q(const int32_t* q_features) {
+    return predict_gesture_q(q_features);
+}
+
+GestureType classify_gesture_q_proba(const int32_t* q_features, float* probs) {
+    return predict_gesture_q_proba(q_features, probs);
+}
+
+#if EMG_TIME_FEATURES & FEATURE_RMS
+// Bitwise integer square root, floor(sqrt(v))
+static uint32_t isqrt_u64(uint64_t v) {
+    if (v == 0) {
+        return 0;
+    }
+    uint64_t result = 0;
+    // Highest even power of two <= v, so the loop only runs for the result's bits
+    uint64_t bit = 1ULL << ((63 - __builtin_clzll(v)) & ~1);
+    while (bit != 0) {
+        if (v >= result + bit) {
+            v -= result + bit;
+            result = (result >> 1) + bit;
+        } else {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)result;
+}
+#endif
+
+// Process a window into integer features (no float, no division)
+bool emg_buffer_process_window_q(const EMG_Buffer* buffer, int32_t* q_features) {
+    if (!buffer->is_full) {
+        return false;
+    }
+
+    for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+        const EMG_ChannelSums* s = &buffer->sums[ch];
+        int i = ch * FEATURES_PER_CHANNEL;
+        int64_t sqr_n = (int64_t)WINDOW_SIZE * s->sum_sqr;
+        (void)sqr_n;
+
+#if EMG_TIME_FEATURES & FEATURE_MAV
+        q_features[i] = s->sum_abs >> feature_q_shift[i];
+        i++;
+#endif
+#if EMG_TIME_FEATURES & FEATURE_RMS
+        q_features[i] = (int32_t)(isqrt_u64((uint64_t)sqr_n) >> feature_q_shift[i]);
+        i++;
+#endif
+#if EMG_TIME_FEATURES & FEATURE_VAR
+        int64_t var_n2 = sqr_n - (int64_t)s->sum * s->sum;
+        q_features[i] = (int32_t)(var_n2 >> feature_q_shift[i]);
+        i++;
+#endif
+#if EMG_TIME_FEATURES & FEATURE_WL
+        q_features[i] = s->sum_diff >> feature_q_shift[i];
+        i++;
+#endif
+#if EMG_TIME_FEATURES & FEATURE_ZC
+        q_features[i] = s->zero_crossings >> feature_q_shift[i];
+        i++;
+#endif
+#if EMG_TIME_FEATURES & FEATURE_SSC
+        q_features[i] = s->slope_changes >> feature_q_shift[i];
+        i++;
+#endif
+#if EMG_TIME_FEATURES & FEATURE_WAMP
+        q_features[i] = s->willison >> feature_q_shift[i];
+        i++;
+#endif
+        (void)i;
+    }
+
+    return true;
+}
+#endif
+
 // Process a window and extract features if available
 bool emg_buffer_process_window(EMG_Buffer* buffer, float* features) {
     if (!buffer->is_full) {
         return false;
     }
-    
-    // Create a window starting from the oldest data
-    int16_t window[WINDOW_SIZE][NUM_CHANNELS];
-    uint16_t start_idx = buffer->write_index;  // Oldest data
-    
-    for (int i = 0; i < WINDOW_SIZE; i++) {
-        uint16_t idx = (start_idx + i) % WINDOW_SIZE;
-        for (int ch = 0; ch < NUM_CHANNELS; ch++) {
-            window[i][ch] = buffer->data[idx][ch];
-        }
+
+    // Features come straight from the running sums; the spectral block needs the window
+    for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+        features_from_sums(&buffer->sums[ch], &features[ch * FEATURES_PER_CHANNEL]);
+#if EMG_SPECTRAL_FEATURES
+        emg_spectrum_features(emg_buffer_channel_window(buffer, ch), WINDOW_SIZE,
+                              &features[ch * FEATURES_PER_CHANNEL + TIME_FEATURES_PER_CHANNEL]);
+#endif
     }
-    
-    // Extract features
-    extract_features_from_window(window, features);
-    
+
     return true;
-}
\ No newline at end of file
+}
+
+// Oldest-first window of one channel, valid until the next emg_buffer_add_sample()
+const int16_t* emg_buffer_channel_window(const EMG_Buffer* buffer, int ch) {
+    return &buffer->data[ch][buffer->write_index];
+}
+
+// Copy the window oldest-first, e.g. for extract_features_from_window()
+void emg_buffer_get_window(const EMG_Buffer* buffer, int16_t window[NUM_CHANNELS][WINDOW_SIZE]) {
+    for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+        memcpy(window[ch], emg_buffer_channel_window(buffer, ch), sizeof(window[ch]));
+    }
+}
+
+void emg_buffer_window_sums(const EMG_Buffer* buffer, EMG_ChannelSums sums[NUM_CHANNELS]) {
+    for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+        channel_window_sums(emg_buffer_channel_window(buffer, ch), &sums[ch]);
+    }
+}
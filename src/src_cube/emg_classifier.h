@@ -2,37 +2,164 @@
 #ifndef EMG_CLASSIFIER_H
 #define EMG_CLASSIFIER_H
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #include "common_defs.h"
 #include "emg_model.h"
+#include "emg_dsp.h"
+#include "emg_filter.h"
+#include "emg_spectrum.h"
 #include <stdint.h>
 #include <stdbool.h>
 #include <math.h>
 
-#define WINDOW_SIZE 150  // 150 samples at 1000Hz = 150ms
-#define OVERLAP 100      // 100 samples overlap
-#define STEP_SIZE (WINDOW_SIZE - OVERLAP)  // 50 samples step
+#define WINDOW_SIZE 150  // 150 samples at 1500Hz = 100ms
+#define OVERLAP 100      // 100 samples overlap (67ms)
+#define STEP_SIZE (WINDOW_SIZE - OVERLAP)  // 50 samples step (33ms)
+#define CLASSIFY_PERIOD_MS 50                // Classification runs every 50ms (20Hz)
+// Samples between classifications, counted on the ADC sample clock
+#define HOP_SAMPLES ((SAMPLING_RATE_HZ * CLASSIFY_PERIOD_MS) / 1000)
+
+// Set to 1 to run feature extraction and inference in integer arithmetic only
+#ifndef EMG_FIXED_POINT
+#define EMG_FIXED_POINT 0
+#endif
+
+// Only linear exports (LR, LDA) carry the integer tables
+#if EMG_FIXED_POINT && !EMG_MODEL_FIXED_POINT
+#error "EMG_FIXED_POINT needs a linear model export (lr or lda)"
+#endif
 
 #define NUM_CHANNELS 4
-#define FEATURES_PER_CHANNEL 5
-#define TOTAL_FEATURES NUM_FEATURES  // Use from emg_model.h
+#if NUM_CHANNELS != EMG_FILTER_CHANNELS
+#error "The prefilter runs on every ADC channel"
+#endif
 
-// IMPORTANT: Verify TOTAL_FEATURES equals NUM_CHANNELS × FEATURES_PER_CHANNEL
-#if TOTAL_FEATURES != (NUM_CHANNELS * FEATURES_PER_CHANNEL)
+// Time-domain features per channel, in this order when enabled. The exported model
+// selects them (EMG_MODEL_TIME_FEATURES), so features it does not use cost nothing.
+#define FEATURE_MAV (1u << 0)   // Mean absolute value
+#define FEATURE_RMS (1u << 1)   // Root mean square
+#define FEATURE_VAR (1u << 2)   // Variance
+#define FEATURE_WL (1u << 3)    // Waveform length
+#define FEATURE_ZC (1u << 4)    // Zero crossings outside the deadband
+#define FEATURE_SSC (1u << 5)   // Slope sign changes
+#define FEATURE_WAMP (1u << 6)  // Willison amplitude
+#define FEATURE_COUNT(mask)                                                                 \
+    (((mask) & 1) + (((mask) >> 1) & 1) + (((mask) >> 2) & 1) + (((mask) >> 3) & 1)      \
+     + (((mask) >> 4) & 1) + (((mask) >> 5) & 1) + (((mask) >> 6) & 1))
+// Position of an enabled feature within its channel
+#define FEATURE_INDEX(feature) FEATURE_COUNT(EMG_TIME_FEATURES & ((feature) - 1u))
+
+// The feature set and thresholds (ADC counts, SSC in counts^2) come from the export;
+// the trainer's library is built with the ones it is about to train on
+#ifndef EMG_TIME_FEATURES
+#define EMG_TIME_FEATURES EMG_MODEL_TIME_FEATURES
+#endif
+#ifndef EMG_ZC_DEADBAND
+#define EMG_ZC_DEADBAND EMG_MODEL_ZC_DEADBAND
+#endif
+#ifndef EMG_SSC_THRESHOLD
+#define EMG_SSC_THRESHOLD EMG_MODEL_SSC_THRESHOLD
+#endif
+#ifndef EMG_WAMP_THRESHOLD
+#define EMG_WAMP_THRESHOLD EMG_MODEL_WAMP_THRESHOLD
+#endif
+#define EMG_FEATURE_THRESHOLDS { EMG_ZC_DEADBAND, EMG_WAMP_THRESHOLD, EMG_SSC_THRESHOLD }
+
+// Signal validation and the scaler adaptation read MAV as each channel's first feature
+#if !(EMG_TIME_FEATURES & FEATURE_MAV) || (EMG_TIME_FEATURES & ~0x7Fu)
+#error "EMG_TIME_FEATURES must include FEATURE_MAV and only FEATURE_* bits"
+#endif
+
+// Window statistics the enabled features are computed from
+#define EMG_TIME_STATS                                                                      \
+    (((EMG_TIME_FEATURES & FEATURE_MAV) ? EMG_DSP_SUM_ABS : 0)                                \
+     | ((EMG_TIME_FEATURES & (FEATURE_RMS | FEATURE_VAR)) ? EMG_DSP_SUM_SQR : 0)             \
+     | ((EMG_TIME_FEATURES & FEATURE_VAR) ? EMG_DSP_SUM : 0)                                  \
+     | ((EMG_TIME_FEATURES & FEATURE_WL) ? EMG_DSP_SUM_DIFF : 0)                              \
+     | ((EMG_TIME_FEATURES & FEATURE_ZC) ? EMG_DSP_ZC : 0)                                    \
+     | ((EMG_TIME_FEATURES & FEATURE_SSC) ? EMG_DSP_SSC : 0)                                  \
+     | ((EMG_TIME_FEATURES & FEATURE_WAMP) ? EMG_DSP_WAMP : 0))
+
+#define TIME_FEATURES_PER_CHANNEL FEATURE_COUNT(EMG_TIME_FEATURES)
+#if EMG_SPECTRAL_FEATURES
+#define FEATURES_PER_CHANNEL (TIME_FEATURES_PER_CHANNEL + SPECTRAL_FEATURES_PER_CHANNEL)
+#else
+#define FEATURES_PER_CHANNEL TIME_FEATURES_PER_CHANNEL
+#endif
+#define TOTAL_FEATURES (NUM_CHANNELS * FEATURES_PER_CHANNEL)
+
+#if EMG_FIXED_POINT && EMG_SPECTRAL_FEATURES
+#error "EMG_SPECTRAL_FEATURES is float only"
+#endif
+
+// IMPORTANT: Verify TOTAL_FEATURES equals the exported model's NUM_FEATURES. The
+// trainer's feature library (EMG_FEATURES_ONLY) computes features for a model that
+// does not exist yet, so it skips the checks against the export.
+#ifndef EMG_FEATURES_ONLY
+#if TOTAL_FEATURES != NUM_FEATURES
 #error "Feature count mismatch! Check emg_model.h"
 #endif
+#if EMG_SPECTRAL_FEATURES != EMG_MODEL_SPECTRAL_FEATURES
+#error "EMG_SPECTRAL_FEATURES differs from the exported model's, re-export it"
+#endif
+#if EMG_TIME_FEATURES != EMG_MODEL_TIME_FEATURES || EMG_ZC_DEADBAND != EMG_MODEL_ZC_DEADBAND \
+    || EMG_SSC_THRESHOLD != EMG_MODEL_SSC_THRESHOLD || EMG_WAMP_THRESHOLD != EMG_MODEL_WAMP_THRESHOLD
+#error "Time-domain feature set differs from the exported model's, re-export it"
+#endif
+#endif
+
+// Running sums over the samples currently in the window. They are updated as each
+// sample enters and the oldest one leaves, so features are available at any hop
+// without touching the window. Only the EMG_TIME_STATS members are kept (the rest
+// stay 0). Integer sums are exact and must equal what emg_dsp_channel_stats()
+// computes over the whole window (emg_buffer_window_sums()).
+typedef EmgDspStats EMG_ChannelSums;
 
 // EMG buffer structure
 typedef struct {
-    int16_t data[WINDOW_SIZE][NUM_CHANNELS];
+    // Channel-major ring. Each sample is stored at write_index and write_index +
+    // WINDOW_SIZE, so the window of a channel (oldest first) is always the
+    // contiguous run data[ch][write_index .. write_index + WINDOW_SIZE)
+    int16_t data[NUM_CHANNELS][2 * WINDOW_SIZE];
     uint16_t write_index;
     bool is_full;
+    EMG_ChannelSums sums[NUM_CHANNELS];
+#if EMG_PREFILTER
+    EmgFilter filter;  // Applied by emg_buffer_add_sample(), ahead of the window
+#endif
 } EMG_Buffer;
 
 // Function prototypes
 void emg_buffer_init(EMG_Buffer* buffer);
+// Raw ADC counts; runs them through the prefilter (EMG_PREFILTER) and pushes the result
 void emg_buffer_add_sample(EMG_Buffer* buffer, int16_t ch1, int16_t ch2, int16_t ch3, int16_t ch4);
+// Pushes an already filtered frame (main.cpp traces the filter on its own)
+void emg_buffer_push(EMG_Buffer* buffer, const int16_t sample[NUM_CHANNELS]);
 bool emg_buffer_process_window(EMG_Buffer* buffer, float* features);
+// Integer features for predict_gesture_q(), per channel and before feature_q_shift:
+// sum|x| (= N*MAV), isqrt(N*sum x^2) (= N*RMS), N*sum x^2 - (sum x)^2 (= N^2*VAR), WL,
+// and the ZC, SSC and WAMP counts, as enabled
+bool emg_buffer_process_window_q(const EMG_Buffer* buffer, int32_t* q_features);
+const int16_t* emg_buffer_channel_window(const EMG_Buffer* buffer, int ch);
+void emg_buffer_get_window(const EMG_Buffer* buffer, int16_t window[NUM_CHANNELS][WINDOW_SIZE]);
+// Recomputes the sums from the stored window with emg_dsp_channel_stats()
+void emg_buffer_window_sums(const EMG_Buffer* buffer, EMG_ChannelSums sums[NUM_CHANNELS]);
 GestureType classify_gesture(const float* features);
-void extract_features_from_window(const int16_t window[WINDOW_SIZE][NUM_CHANNELS], float* features);
+GestureType classify_gesture_q(const int32_t* q_features);
+// As above, also filling probs[NUM_CLASSES] for gesture_decision_push()
+GestureType classify_gesture_proba(const float* features, float* probs);
+GestureType classify_gesture_q_proba(const int32_t* q_features, float* probs);
+// Float path only: switches classify_gesture() to a model fitted on the device
+// (calibration.c); NULL goes back to the exported emg_model
+void classifier_set_model(const ModelDescriptor* model);
+const ModelDescriptor* classifier_get_model(void);
+void extract_features_from_window(const int16_t window[NUM_CHANNELS][WINDOW_SIZE], float* features);
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif // EMG_CLASSIFIER_H
\ No newline at end of file
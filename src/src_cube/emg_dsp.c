@@ -0,0 +1,232 @@
+#include "emg_dsp.h"
+#include "stm32f4xx_hal.h"
+#include <stdbool.h>
+#include <string.h>
+
+// Packed 2 x int16 helpers: the DSP instructions on the M4, plain C anywhere else
+#if defined(__ARM_FEATURE_DSP) && __ARM_FEATURE_DSP == 1
+
+static inline uint32_t ssub16(uint32_t a, uint32_t b) {
+    return __SSUB16(a, b);
+}
+
+static inline int32_t smlad(uint32_t x, uint32_t y, int32_t acc) {
+    return (int32_t)__SMLAD(x, y, (uint32_t)acc);
+}
+
+static inline int64_t smlald(uint32_t x, uint32_t y, int64_t acc) {
+    return (int64_t)__SMLALD(x, y, (uint64_t)acc);
+}
+
+#else
+
+static inline int32_t lo16(uint32_t w) {
+    return (int16_t)(w & 0xFFFF);
+}
+
+static inline int32_t hi16(uint32_t w) {
+    return (int16_t)(w >> 16);
+}
+
+static inline uint32_t pack16x2(int32_t lo, int32_t hi) {
+    return ((uint32_t)lo & 0xFFFF) | ((uint32_t)hi << 16);
+}
+
+static inline uint32_t ssub16(uint32_t a, uint32_t b) {
+    return pack16x2(lo16(a) - lo16(b), hi16(a) - hi16(b));
+}
+
+static inline int32_t smlad(uint32_t x, uint32_t y, int32_t acc) {
+    return acc + lo16(x) * lo16(y) + hi16(x) * hi16(y);
+}
+
+static inline int64_t smlald(uint32_t x, uint32_t y, int64_t acc) {
+    return acc + (int64_t)lo16(x) * lo16(y) + (int64_t)hi16(x) * hi16(y);
+}
+
+#endif
+
+// |lo|, |hi|: m is 0xFFFF (-1) in the negative lanes, where (x ^ m) - m = ~x + 1 = -x
+static inline uint32_t abs16x2(uint32_t x) {
+    uint32_t m = ((x & 0x80008000u) >> 15) * 0xFFFFu;
+    return ssub16(x ^ m, m);
+}
+
+// 0xFFFF in the lanes where a >= b. Both operands are in [0, 2^15), so a lane's
+// difference cannot overflow and its sign bit is set exactly where a < b.
+static inline uint32_t ge16x2(uint32_t a, uint32_t b) {
+    return ((~ssub16(a, b) & 0x80008000u) >> 15) * 0xFFFFu;
+}
+
+// Both lanes set to 1, so smlad(x, ONES, acc) adds the two samples
+#define ONES 0x00010001u
+
+// x[0] in the low half, x[1] in the high half; x need not be word aligned
+static inline uint32_t load_pair(const int16_t* x) {
+    uint32_t w;
+    memcpy(&w, x, sizeof(w));
+    return w;
+}
+
+static inline int32_t abs_i32(int32_t v) {
+    return v < 0 ? -v : v;
+}
+
+int32_t emg_dsp_sum(const int16_t* x, uint32_t n) {
+    int32_t acc = 0;
+    uint32_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        acc = smlad(load_pair(x + i), ONES, acc);
+    }
+    if (i < n) {
+        acc += x[i];
+    }
+    return acc;
+}
+
+int32_t emg_dsp_sum_abs(const int16_t* x, uint32_t n) {
+    int32_t acc = 0;
+    uint32_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        acc = smlad(abs16x2(load_pair(x + i)), ONES, acc);
+    }
+    if (i < n) {
+        acc += abs_i32(x[i]);
+    }
+    return acc;
+}
+
+int64_t emg_dsp_sum_sqr(const int16_t* x, uint32_t n) {
+    int64_t acc = 0;
+    uint32_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        uint32_t w = load_pair(x + i);
+        acc = smlald(w, w, acc);
+    }
+    if (i < n) {
+        acc += (int32_t)x[i] * x[i];
+    }
+    return acc;
+}
+
+// Pairs (x[i], x[i+1]) and (x[i+1], x[i+2]) are handled by one subtract of the
+// word at x + i + 1 and the word at x + i
+int32_t emg_dsp_sum_abs_diff(const int16_t* x, uint32_t n) {
+    int32_t acc = 0;
+    uint32_t i = 0;
+    for (; i + 3 <= n; i += 2) {
+        uint32_t d = ssub16(load_pair(x + i + 1), load_pair(x + i));
+        acc = smlad(abs16x2(d), ONES, acc);
+    }
+    if (i + 2 == n) {
+        acc += abs_i32((int32_t)x[i + 1] - x[i]);
+    }
+    return acc;
+}
+
+int32_t emg_dsp_zero_crossings(const int16_t* x, uint32_t n) {
+    int32_t count = 0;
+    uint32_t i = 0;
+    for (; i + 3 <= n; i += 2) {
+        // Sign bits that differ between each sample and its successor
+        uint32_t v = (load_pair(x + i) ^ load_pair(x + i + 1)) & 0x80008000u;
+        count += (int32_t)((v >> 15) & 1) + (int32_t)(v >> 31);
+    }
+    if (i + 2 == n) {
+        count += (x[i] < 0) != (x[i + 1] < 0);
+    }
+    return count;
+}
+
+// Both lanes set to v
+static inline uint32_t splat16(int16_t v) {
+    return ((uint32_t)(uint16_t)v << 16) | (uint16_t)v;
+}
+
+// Lanes of a 0xFFFF-per-lane mask, or of the sign bits of a 0x80008000 mask
+static inline int32_t lane_count(uint32_t mask) {
+    return (int32_t)((mask >> 15) & 1) + (int32_t)(mask >> 31);
+}
+
+// Sample j, the difference d = x[j+1] - x[j] when has_next, and the slope change at
+// j from the previous difference when has_prev_diff: the scalar tail of the pair loop
+static inline void stats_step(EmgDspStats* s, const EmgDspThresholds* t, int32_t x, int32_t d,
+                              bool has_next, int32_t d_prev, bool has_prev_diff) {
+    s->sum_abs += abs_i32(x);
+    s->sum_sqr += x * x;
+    s->sum += x;
+    if (!has_next) {
+        return;
+    }
+    int32_t ad = abs_i32(d);
+    s->sum_diff += ad;
+    s->zero_crossings += (x < 0) != (x + d < 0) && ad >= t->zc_deadband;
+    s->willison += ad >= t->wamp_threshold;
+    if (has_prev_diff) {
+        s->slope_changes += -d_prev * d >= t->ssc_threshold;
+    }
+}
+
+// The pair loop takes x[i], x[i+1] from one word and builds the neighbour word
+// x[i+1], x[i+2] from it and the next one, so each sample is loaded once. The
+// differences of both lanes come from one subtract, and the deadband and threshold
+// tests from one compare each.
+void emg_dsp_channel_stats(const int16_t* x, uint32_t n, uint32_t stats,
+                           const EmgDspThresholds* thresholds, EmgDspStats* out) {
+    const bool want_abs = (stats & EMG_DSP_SUM_ABS) != 0;
+    const bool want_sqr = (stats & EMG_DSP_SUM_SQR) != 0;
+    const bool want_sum = (stats & EMG_DSP_SUM) != 0;
+    const bool want_wl = (stats & EMG_DSP_SUM_DIFF) != 0;
+    const bool want_zc = (stats & EMG_DSP_ZC) != 0;
+    const bool want_ssc = (stats & EMG_DSP_SSC) != 0;
+    const bool want_wamp = (stats & EMG_DSP_WAMP) != 0;
+    const uint32_t zc_band = splat16(thresholds->zc_deadband);
+    const uint32_t wamp_band = splat16(thresholds->wamp_threshold);
+    const int32_t ssc_threshold = thresholds->ssc_threshold;
+
+    EmgDspStats s;
+    memset(&s, 0, sizeof(s));
+    int32_t d_prev = 0;  // x[i] - x[i-1]
+    uint32_t i = 0;
+
+    if (n >= 4) {
+        uint32_t w = load_pair(x);
+        for (; i + 4 <= n; i += 2) {
+            uint32_t w_next = load_pair(x + i + 2);
+            uint32_t shifted = (w >> 16) | (w_next << 16);
+            if (want_abs) s.sum_abs = smlad(abs16x2(w), ONES, s.sum_abs);
+            if (want_sqr) s.sum_sqr = smlald(w, w, s.sum_sqr);
+            if (want_sum) s.sum = smlad(w, ONES, s.sum);
+
+            uint32_t d = ssub16(shifted, w);  // x[i+1] - x[i], x[i+2] - x[i+1]
+            uint32_t ad = abs16x2(d);
+            if (want_wl) s.sum_diff = smlad(ad, ONES, s.sum_diff);
+            if (want_zc) s.zero_crossings += lane_count((w ^ shifted) & ge16x2(ad, zc_band) & 0x80008000u);
+            if (want_wamp) s.willison += lane_count(ge16x2(ad, wamp_band));
+            int32_t d_lo = (int16_t)d;
+            int32_t d_hi = (int16_t)(d >> 16);
+            if (want_ssc) {
+                s.slope_changes += (i > 0 && -d_prev * d_lo >= ssc_threshold) + (-d_lo * d_hi >= ssc_threshold);
+            }
+            d_prev = d_hi;
+            w = w_next;
+        }
+    }
+
+    // Up to three samples left, the first of them with a predecessor when i > 0
+    EmgDspStats tail;
+    memset(&tail, 0, sizeof(tail));
+    for (; i < n; i++) {
+        bool has_next = i + 1 < n;
+        int32_t d = has_next ? (int32_t)x[i + 1] - x[i] : 0;
+        stats_step(&tail, thresholds, x[i], d, has_next, d_prev, i > 0);
+        d_prev = d;
+    }
+    out->sum_abs = want_abs ? s.sum_abs + tail.sum_abs : 0;
+    out->sum_sqr = want_sqr ? s.sum_sqr + tail.sum_sqr : 0;
+    out->sum = want_sum ? s.sum + tail.sum : 0;
+    out->sum_diff = want_wl ? s.sum_diff + tail.sum_diff : 0;
+    out->zero_crossings = want_zc ? s.zero_crossings + tail.zero_crossings : 0;
+    out->slope_changes = want_ssc ? s.slope_changes + tail.slope_changes : 0;
+    out->willison = want_wamp ? s.willison + tail.willison : 0;
+}
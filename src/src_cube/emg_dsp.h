@@ -0,0 +1,59 @@
+#ifndef EMG_DSP_H
+#define EMG_DSP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+// Window statistics over one channel's contiguous int16 samples. On the Cortex-M4
+// the samples are loaded two per 32-bit word and reduced with the DSP extension
+// (__SSUB16, __SEL, __SMLAD, __SMLALD); elsewhere the same kernels run on portable
+// C versions of those instructions. Samples must stay within +/-16383 so that
+// neighbour differences fit a 16-bit lane (ADC data is 12-bit).
+int32_t emg_dsp_sum(const int16_t* x, uint32_t n);
+int32_t emg_dsp_sum_abs(const int16_t* x, uint32_t n);
+int64_t emg_dsp_sum_sqr(const int16_t* x, uint32_t n);
+// sum |x[i] - x[i-1]| over the n-1 neighbouring pairs
+int32_t emg_dsp_sum_abs_diff(const int16_t* x, uint32_t n);
+// Neighbouring pairs where exactly one sample is negative
+int32_t emg_dsp_zero_crossings(const int16_t* x, uint32_t n);
+
+// Everything the time-domain features need from one window, in a single pass that
+// loads each sample pair once
+typedef struct {
+    int32_t sum_abs;         // sum |x|
+    int64_t sum_sqr;         // sum x^2
+    int32_t sum;             // sum x
+    int32_t sum_diff;        // sum |x[i] - x[i-1]| over the window
+    int32_t zero_crossings;  // sign changes between neighbours at least zc_deadband apart
+    int32_t slope_changes;   // (x[i] - x[i-1]) * (x[i] - x[i+1]) >= ssc_threshold
+    int32_t willison;        // |x[i] - x[i-1]| >= wamp_threshold
+} EmgDspStats;
+
+// Members of EmgDspStats to compute; the others are left at 0
+#define EMG_DSP_SUM_ABS (1u << 0)
+#define EMG_DSP_SUM_SQR (1u << 1)
+#define EMG_DSP_SUM (1u << 2)
+#define EMG_DSP_SUM_DIFF (1u << 3)
+#define EMG_DSP_ZC (1u << 4)
+#define EMG_DSP_SSC (1u << 5)
+#define EMG_DSP_WAMP (1u << 6)
+#define EMG_DSP_ALL 0x7Fu
+
+// In ADC counts (ssc_threshold in counts^2), none negative. A zero zc_deadband is the plain sign test.
+typedef struct {
+    int16_t zc_deadband;
+    int16_t wamp_threshold;
+    int32_t ssc_threshold;
+} EmgDspThresholds;
+
+void emg_dsp_channel_stats(const int16_t* x, uint32_t n, uint32_t stats,
+                           const EmgDspThresholds* thresholds, EmgDspStats* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EMG_DSP_H
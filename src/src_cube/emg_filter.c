@@ -0,0 +1,207 @@
+#include "emg_filter.h"
+#include "emg_classifier.h"
+#include <math.h>
+#include <string.h>
+
+#define PI_F 3.14159265f
+#define BUTTERWORTH_Q 0.70710678f
+#define SAMPLE_LIMIT 16383  // emg_dsp lane limit
+
+typedef enum {
+    SECTION_HIGH_PASS,
+    SECTION_LOW_PASS,
+    SECTION_NOTCH
+} SectionType;
+
+// Audio EQ cookbook sections, normalised to a0 = 1
+static EmgBiquad design_section(SectionType type, float freq_hz, float q) {
+    float w0 = 2.0f * PI_F * freq_hz / (float)SAMPLING_RATE_HZ;
+    float c = cosf(w0);
+    float alpha = sinf(w0) / (2.0f * q);
+    float a0 = 1.0f + alpha;
+    EmgBiquad k;
+
+    switch (type) {
+    case SECTION_HIGH_PASS:
+        k.b0 = (1.0f + c) / 2.0f;
+        k.b1 = -(1.0f + c);
+        k.b2 = k.b0;
+        break;
+    case SECTION_LOW_PASS:
+        k.b0 = (1.0f - c) / 2.0f;
+        k.b1 = 1.0f - c;
+        k.b2 = k.b0;
+        break;
+    default:
+        k.b0 = 1.0f;
+        k.b1 = -2.0f * c;
+        k.b2 = 1.0f;
+        break;
+    }
+    k.b0 /= a0;
+    k.b1 /= a0;
+    k.b2 /= a0;
+    k.a1 = -2.0f * c / a0;
+    k.a2 = (1.0f - alpha) / a0;
+    k.dc_gain = (k.b0 + k.b1 + k.b2) / (1.0f + k.a1 + k.a2);
+    return k;
+}
+
+// All coefficients of these sections are within (-2, 2)
+static int32_t to_q30(float v) {
+    return (int32_t)lrintf(v * (float)(1 << EMG_FILTER_Q_COEFF_BITS));
+}
+
+static void add_section(EmgFilter* filter, SectionType type, float freq_hz, float q) {
+    if (freq_hz <= 0.0f || freq_hz >= SAMPLING_RATE_HZ / 2 || filter->stages >= EMG_FILTER_MAX_STAGES) {
+        return;
+    }
+    EmgBiquad k = design_section(type, freq_hz, q);
+    EmgBiquadQ* kq = &filter->q_coeffs[filter->stages];
+    kq->b0 = to_q30(k.b0);
+    kq->b1 = to_q30(k.b1);
+    kq->b2 = to_q30(k.b2);
+    kq->a1 = to_q30(k.a1);
+    kq->a2 = to_q30(k.a2);
+    kq->dc_gain = to_q30(k.dc_gain);
+    filter->coeffs[filter->stages++] = k;
+}
+
+void emg_filter_init(EmgFilter* filter, const EmgFilterConfig* config) {
+    static const EmgFilterConfig defaults = EMG_FILTER_DEFAULTS;
+    static const EmgFilterConfig band_pass = EMG_FILTER_BAND_PASS_DEFAULTS;
+    if (config == NULL) {
+        config = EMG_PREFILTER == 2 ? &band_pass : &defaults;
+    }
+    filter->config = *config;
+    filter->stages = 0;
+    add_section(filter, SECTION_HIGH_PASS, config->dc_cutoff_hz, BUTTERWORTH_Q);
+    add_section(filter, SECTION_NOTCH, config->notch_hz, config->notch_q);
+    add_section(filter, SECTION_HIGH_PASS, config->band_low_hz, BUTTERWORTH_Q);
+    add_section(filter, SECTION_LOW_PASS, config->band_high_hz, BUTTERWORTH_Q);
+    emg_filter_reset(filter);
+}
+
+void emg_filter_reset(EmgFilter* filter) {
+    memset(filter->state, 0, sizeof(filter->state));
+    memset(filter->q_state, 0, sizeof(filter->q_state));
+    memset(filter->level, 0, sizeof(filter->level));
+    filter->primed = false;
+}
+
+// Steady state for a constant input equal to the first frame: every section's
+// output is its DC gain times its input, so the electrode offset does not start
+// a step response that would take seconds to die out.
+static void prime(EmgFilter* filter, const int16_t in[EMG_FILTER_CHANNELS]) {
+    for (int ch = 0; ch < EMG_FILTER_CHANNELS; ch++) {
+        float x = in[ch];
+        int32_t xq = (int32_t)in[ch] << EMG_FILTER_Q_GUARD;
+        filter->level[ch] = xq;
+        for (int st = 0; st < filter->stages; st++) {
+            const EmgBiquad* k = &filter->coeffs[st];
+            float y = k->dc_gain * x;
+            filter->state[ch][st][1] = k->b2 * x - k->a2 * y;
+            filter->state[ch][st][0] = k->b1 * x - k->a1 * y + filter->state[ch][st][1];
+            x = y;
+
+            int32_t yq = (int32_t)(((int64_t)filter->q_coeffs[st].dc_gain * xq
+                                    + (1 << (EMG_FILTER_Q_COEFF_BITS - 1))) >> EMG_FILTER_Q_COEFF_BITS);
+            int32_t* z = filter->q_state[ch][st];
+            z[0] = xq;
+            z[1] = xq;
+            z[2] = yq;
+            z[3] = yq;
+            xq = yq;
+        }
+    }
+    filter->primed = true;
+}
+
+// Integer in both paths, so float and fixed-point builds validate identically
+static inline void track_level(EmgFilter* filter, int ch, int16_t in) {
+    int32_t x = (int32_t)in << EMG_FILTER_Q_GUARD;
+    filter->level[ch] += (x - filter->level[ch]) >> EMG_FILTER_LEVEL_SHIFT;
+}
+
+static inline int16_t clamp_sample(int32_t v) {
+    if (v > SAMPLE_LIMIT) return SAMPLE_LIMIT;
+    if (v < -SAMPLE_LIMIT) return -SAMPLE_LIMIT;
+    return (int16_t)v;
+}
+
+void emg_filter_process_f(EmgFilter* filter, const int16_t in[EMG_FILTER_CHANNELS],
+                          int16_t out[EMG_FILTER_CHANNELS]) {
+    if (!filter->primed) {
+        prime(filter, in);
+    }
+    for (int ch = 0; ch < EMG_FILTER_CHANNELS; ch++) {
+        track_level(filter, ch, in[ch]);
+        float x = in[ch];
+        for (int st = 0; st < filter->stages; st++) {
+            const EmgBiquad* k = &filter->coeffs[st];
+            float* s = filter->state[ch][st];
+            float y = k->b0 * x + s[0];
+            s[0] = k->b1 * x - k->a1 * y + s[1];
+            s[1] = k->b2 * x - k->a2 * y;
+            x = y;
+        }
+        out[ch] = clamp_sample((int32_t)lrintf(x));
+    }
+}
+
+void emg_filter_process_q(EmgFilter* filter, const int16_t in[EMG_FILTER_CHANNELS],
+                          int16_t out[EMG_FILTER_CHANNELS]) {
+    if (!filter->primed) {
+        prime(filter, in);
+    }
+    for (int ch = 0; ch < EMG_FILTER_CHANNELS; ch++) {
+        track_level(filter, ch, in[ch]);
+        int32_t x = (int32_t)in[ch] << EMG_FILTER_Q_GUARD;
+        for (int st = 0; st < filter->stages; st++) {
+            const EmgBiquadQ* k = &filter->q_coeffs[st];
+            int32_t* z = filter->q_state[ch][st];
+            int64_t acc = (int64_t)k->b0 * x + (int64_t)k->b1 * z[0] + (int64_t)k->b2 * z[1]
+                          - (int64_t)k->a1 * z[2] - (int64_t)k->a2 * z[3];
+            int32_t y = (int32_t)((acc + (1 << (EMG_FILTER_Q_COEFF_BITS - 1))) >> EMG_FILTER_Q_COEFF_BITS);
+            z[1] = z[0];
+            z[0] = x;
+            z[3] = z[2];
+            z[2] = y;
+            x = y;
+        }
+        out[ch] = clamp_sample((x + (1 << (EMG_FILTER_Q_GUARD - 1))) >> EMG_FILTER_Q_GUARD);
+    }
+}
+
+void emg_filter_process(EmgFilter* filter, const int16_t in[EMG_FILTER_CHANNELS],
+                        int16_t out[EMG_FILTER_CHANNELS]) {
+#if EMG_FIXED_POINT
+    emg_filter_process_q(filter, in, out);
+#else
+    emg_filter_process_f(filter, in, out);
+#endif
+}
+
+float emg_filter_level(const EmgFilter* filter, int ch) {
+    return filter->level[ch] / (float)(1 << EMG_FILTER_Q_GUARD);
+}
+
+float emg_filter_gain(const EmgFilter* filter, float freq_hz) {
+    float w = 2.0f * PI_F * freq_hz / (float)SAMPLING_RATE_HZ;
+    float c1 = cosf(w), s1 = sinf(w), c2 = cosf(2.0f * w), s2 = sinf(2.0f * w);
+    float gain = 1.0f;
+    for (int st = 0; st < filter->stages; st++) {
+        const EmgBiquad* k = &filter->coeffs[st];
+        float num_re = k->b0 + k->b1 * c1 + k->b2 * c2;
+        float num_im = k->b1 * s1 + k->b2 * s2;
+        float den_re = 1.0f + k->a1 * c1 + k->a2 * c2;
+        float den_im = k->a1 * s1 + k->a2 * s2;
+        gain *= sqrtf((num_re * num_re + num_im * num_im) / (den_re * den_re + den_im * den_im));
+    }
+    return gain;
+}
+
+uint32_t emg_filter_budget_cycles(const EmgFilter* filter, bool fixed_point) {
+    uint32_t per_biquad = fixed_point ? EMG_FILTER_BIQUAD_CYCLES_Q : EMG_FILTER_BIQUAD_CYCLES_F;
+    return EMG_FILTER_FRAME_CYCLES + per_biquad * EMG_FILTER_CHANNELS * filter->stages;
+}
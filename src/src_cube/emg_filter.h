@@ -0,0 +1,100 @@
+#ifndef EMG_FILTER_H
+#define EMG_FILTER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "common_defs.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+// Per-channel preprocessing between the ADC and the sample window: the ADC delivers
+// offset-binary counts, so without it MAV/RMS measure the electrode offset and ZC
+// never fires. Cascaded biquads at SAMPLING_RATE_HZ:
+//   0 = off, raw ADC counts (what the exported model was trained on)
+//   1 = 2nd-order high-pass DC blocker + 50Hz mains notch
+//   2 = 50Hz notch + 20-450Hz band-pass (its 20Hz high-pass also blocks DC)
+// The host trainer (ml/emg_features.py) builds with the same setting, and the model
+// export records it in EMG_MODEL_PREFILTER.
+#ifndef EMG_PREFILTER
+#define EMG_PREFILTER 0
+#endif
+
+#define EMG_FILTER_CHANNELS ADC_CHANNELS
+#define EMG_FILTER_MAX_STAGES 4
+
+// Corner frequencies in Hz; 0 leaves a section out
+typedef struct {
+    float dc_cutoff_hz;    // Butterworth high-pass
+    float notch_hz;        // Mains notch centre
+    float notch_q;         // Centre / -3dB bandwidth
+    float band_low_hz;     // Butterworth high-pass edge of the band-pass
+    float band_high_hz;    // Butterworth low-pass edge of the band-pass
+} EmgFilterConfig;
+
+#define EMG_FILTER_DEFAULTS { 5.0f, 50.0f, 10.0f, 0.0f, 0.0f }
+#define EMG_FILTER_BAND_PASS_DEFAULTS { 0.0f, 50.0f, 10.0f, 20.0f, 450.0f }
+
+// Cycle budget on the Cortex-M4 per biquad and channel, plus a fixed cost per frame.
+// The float path is transposed direct form II (5 VFMA); the fixed-point path is
+// direct form I with Q30 coefficients and 64-bit accumulation (5 SMLAL), which keeps
+// low corners like the 5Hz DC blocker stable without float.
+#define EMG_FILTER_BIQUAD_CYCLES_F 24
+#define EMG_FILTER_BIQUAD_CYCLES_Q 30
+#define EMG_FILTER_FRAME_CYCLES 40
+
+// Fixed point: Q30 coefficients, EMG_FILTER_Q_GUARD fractional bits on the samples
+// between sections
+#define EMG_FILTER_Q_COEFF_BITS 30
+#define EMG_FILTER_Q_GUARD 8
+// Input level tracker: EWMA over about 2^EMG_FILTER_LEVEL_SHIFT samples (a window)
+#define EMG_FILTER_LEVEL_SHIFT 7
+
+typedef struct {
+    float b0, b1, b2, a1, a2;   // a0 normalised to 1
+    float dc_gain;
+} EmgBiquad;
+
+typedef struct {
+    int32_t b0, b1, b2, a1, a2;
+    int32_t dc_gain;
+} EmgBiquadQ;
+
+typedef struct {
+    EmgFilterConfig config;
+    uint8_t stages;
+    bool primed;   // State set from the first frame, so the offset does not ring
+    EmgBiquad coeffs[EMG_FILTER_MAX_STAGES];
+    EmgBiquadQ q_coeffs[EMG_FILTER_MAX_STAGES];
+    float state[EMG_FILTER_CHANNELS][EMG_FILTER_MAX_STAGES][2];        // s1, s2
+    int32_t q_state[EMG_FILTER_CHANNELS][EMG_FILTER_MAX_STAGES][4];    // x1, x2, y1, y2
+    // Raw input level (electrode offset), ADC counts << EMG_FILTER_Q_GUARD. The
+    // filtered window no longer carries it, so signal validation checks this instead.
+    int32_t level[EMG_FILTER_CHANNELS];
+} EmgFilter;
+
+// config may be NULL for the EMG_PREFILTER setting (DEFAULTS when it is 0)
+void emg_filter_init(EmgFilter* filter, const EmgFilterConfig* config);
+// Clears the state; the next frame primes it again
+void emg_filter_reset(EmgFilter* filter);
+// One frame of raw ADC counts in, filtered samples out (clamped to +/-16383 for the
+// emg_dsp kernels). in and out may alias.
+void emg_filter_process_f(EmgFilter* filter, const int16_t in[EMG_FILTER_CHANNELS],
+                          int16_t out[EMG_FILTER_CHANNELS]);
+void emg_filter_process_q(EmgFilter* filter, const int16_t in[EMG_FILTER_CHANNELS],
+                          int16_t out[EMG_FILTER_CHANNELS]);
+// The one selected by EMG_FIXED_POINT
+void emg_filter_process(EmgFilter* filter, const int16_t in[EMG_FILTER_CHANNELS],
+                        int16_t out[EMG_FILTER_CHANNELS]);
+// Input level of a channel in ADC counts
+float emg_filter_level(const EmgFilter* filter, int ch);
+// |H| of the designed cascade at freq_hz
+float emg_filter_gain(const EmgFilter* filter, float freq_hz);
+uint32_t emg_filter_budget_cycles(const EmgFilter* filter, bool fixed_point);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EMG_FILTER_H
@@ -1,7 +1,12 @@
 #include "emg_model.h"
 
+#include <stddef.h>
 #include <math.h>
 
+// model_predict() sizes its stack scratch by the MODEL_MAX_* limits
+_Static_assert(NUM_FEATURES <= MODEL_MAX_FEATURES, "NUM_FEATURES exceeds MODEL_MAX_FEATURES");
+_Static_assert(NUM_CLASSES <= MODEL_MAX_CLASSES, "NUM_CLASSES exceeds MODEL_MAX_CLASSES");
+
 const float scaler_mean[NUM_FEATURES] = {
     870.249096f,
     877.757712f,
@@ -284,6 +289,280 @@ const float lr_intercept[NUM_CLASSES] = {
     -5.802713f,
 };
 
+#define LR_Q_FRAC_BITS 30
+
+const uint8_t feature_q_shift[NUM_FEATURES] = {
+    0,
+    0,
+    10,
+    0,
+    0,
+    0,
+    0,
+    10,
+    0,
+    0,
+    0,
+    0,
+    10,
+    0,
+    0,
+    0,
+    0,
+    10,
+    0,
+    0,
+};
+
+const int32_t lr_q_coefficients[NUM_CLASSES][NUM_FEATURES] = {
+    {
+        28740,
+        27971,
+        -113,
+        -451560,
+        0,
+        -10295,
+        -6971,
+        109,
+        282225,
+        2315728,
+        52734,
+        98067,
+        -1126,
+        -439233,
+        0,
+        -2227,
+        -1668,
+        -361,
+        135285,
+        0,
+    },
+    {
+        -33715,
+        -31689,
+        -376,
+        -404371,
+        0,
+        -12764,
+        -13828,
+        6,
+        464598,
+        4641161,
+        -66958,
+        -2135,
+        3306,
+        354972,
+        0,
+        9361,
+        9170,
+        411,
+        -1325124,
+        0,
+    },
+    {
+        -8331,
+        -7943,
+        27,
+        251667,
+        0,
+        13629,
+        14038,
+        -413,
+        -805085,
+        -393596908,
+        62801,
+        -45502,
+        -6487,
+        362390,
+        0,
+        24592,
+        24543,
+        14,
+        218867,
+        0,
+    },
+    {
+        -2363,
+        5536,
+        1266,
+        -599799,
+        0,
+        7360,
+        -3553,
+        41,
+        169158,
+        86074263,
+        -34348,
+        -23920,
+        -6642,
+        871341,
+        0,
+        6623,
+        7548,
+        -505,
+        -185556,
+        0,
+    },
+    {
+        15138,
+        14572,
+        -208,
+        -186379,
+        0,
+        -30829,
+        -31003,
+        -68,
+        484518,
+        132740247,
+        -173485,
+        -55232,
+        4000,
+        123460,
+        0,
+        11159,
+        11280,
+        -62,
+        -414793,
+        0,
+    },
+    {
+        26126,
+        25282,
+        -2999,
+        228863,
+        0,
+        -12453,
+        -134,
+        50,
+        589607,
+        -53638815,
+        -153654,
+        -76534,
+        -6000,
+        567541,
+        0,
+        4180,
+        3673,
+        575,
+        28914,
+        0,
+    },
+    {
+        -26384,
+        -25891,
+        -2603,
+        1370605,
+        0,
+        28557,
+        29127,
+        25,
+        -1338348,
+        -744972838,
+        79046,
+        -34699,
+        -14933,
+        -249853,
+        0,
+        9904,
+        8470,
+        -291,
+        -1009897,
+        0,
+    },
+    {
+        7818,
+        7218,
+        -1310,
+        774963,
+        0,
+        21055,
+        19837,
+        47,
+        -1531052,
+        6532697,
+        144684,
+        -74800,
+        -9354,
+        207209,
+        0,
+        26734,
+        26553,
+        329,
+        -883537,
+        0,
+    },
+    {
+        40646,
+        37472,
+        -4607,
+        690305,
+        0,
+        12665,
+        11630,
+        -243,
+        -125211,
+        -31888573,
+        -57090,
+        -120954,
+        -8837,
+        -173179,
+        0,
+        -9706,
+        -10930,
+        194,
+        1002214,
+        0,
+    },
+    {
+        -29963,
+        -28483,
+        1115,
+        -538457,
+        0,
+        -17067,
+        -14532,
+        126,
+        108921,
+        116664613,
+        -19569,
+        -18299,
+        4253,
+        -154697,
+        0,
+        -37286,
+        -36059,
+        373,
+        190563,
+        0,
+    },
+};
+
+const int64_t lr_q_intercept[NUM_CLASSES] = {
+    -11313972996LL,
+    8034168270LL,
+    -8272040564LL,
+    -2482076243LL,
+    -4118980450LL,
+    -8005889570LL,
+    1200206874LL,
+    -12595703186LL,
+    -10930609094LL,
+    13150414339LL,
+};
+
+const ModelDescriptor emg_model_descriptor = {
+    .type = MODEL_LR,
+    .num_features = NUM_FEATURES,
+    .num_classes = NUM_CLASSES,
+    .num_hidden = 0,
+    .scaler_mean = scaler_mean,
+    .scaler_scale = scaler_scale,
+    .weights = &lr_coefficients[0][0],
+    .bias = lr_intercept,
+    .out_weights = NULL,
+    .out_bias = NULL,
+};
+
 const char* gesture_names[NUM_CLASSES] = {
     "rock",
     "scissors",
@@ -299,25 +578,45 @@ const char* gesture_names[NUM_CLASSES] = {
 
 
 GestureType predict_gesture(const float* features) {
-    float scores[NUM_CLASSES] = {0};
-    float max_score = -INFINITY;
+    return (GestureType)model_predict(&emg_model_descriptor, features, NULL);
+}
+
+GestureType predict_gesture_proba(const float* features, float* probs) {
+    return (GestureType)model_predict_proba(&emg_model_descriptor, features, probs);
+}
+
+// Integer scores scaled by 2^LR_Q_FRAC_BITS; returns the first maximum
+static int predict_scores_q(const int32_t* q_features, int64_t* scores) {
     int predicted_class = 0;
-    
-    float scaled_features[NUM_FEATURES];
-    for (int i = 0; i < NUM_FEATURES; i++) {
-        scaled_features[i] = (features[i] - scaler_mean[i]) / scaler_scale[i];
-    }
-    
+
     for (int class_idx = 0; class_idx < NUM_CLASSES; class_idx++) {
-        scores[class_idx] = lr_intercept[class_idx];
+        int64_t score = lr_q_intercept[class_idx];
         for (int feat_idx = 0; feat_idx < NUM_FEATURES; feat_idx++) {
-            scores[class_idx] += lr_coefficients[class_idx][feat_idx] * scaled_features[feat_idx];
+            score += (int64_t)lr_q_coefficients[class_idx][feat_idx] * q_features[feat_idx];
         }
-        if (scores[class_idx] > max_score) {
-            max_score = scores[class_idx];
+        scores[class_idx] = score;
+        if (score > scores[predicted_class]) {
             predicted_class = class_idx;
         }
     }
-    
+
+    return predicted_class;
+}
+
+// Integer-only inference on the features from emg_buffer_process_window_q()
+GestureType predict_gesture_q(const int32_t* q_features) {
+    int64_t scores[NUM_CLASSES];
+    return (GestureType)predict_scores_q(q_features, scores);
+}
+
+// The argmax stays integer; only the probabilities go through float
+GestureType predict_gesture_q_proba(const int32_t* q_features, float* probs) {
+    int64_t scores[NUM_CLASSES];
+    float float_scores[NUM_CLASSES];
+    int predicted_class = predict_scores_q(q_features, scores);
+    for (int class_idx = 0; class_idx < NUM_CLASSES; class_idx++) {
+        float_scores[class_idx] = ldexpf((float)scores[class_idx], -LR_Q_FRAC_BITS);
+    }
+    model_scores_to_proba(emg_model_descriptor.type, float_scores, NUM_CLASSES, probs);
     return (GestureType)predicted_class;
 }
@@ -1,7 +1,12 @@
 #ifndef EMG_MODEL_H
 #define EMG_MODEL_H
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #include <stdint.h>
+#include "model_runtime.h"
 
 typedef enum {
     GESTURE_ROCK = 0,           // all closed
@@ -19,6 +24,19 @@ typedef enum {
 #define NUM_FEATURES 20
 #define NUM_CLASSES 10
 
+// Linear models also come with integer tables for EMG_FIXED_POINT
+#define EMG_MODEL_FIXED_POINT 1
+
+// EMG_PREFILTER setting the training features were computed with
+#define EMG_MODEL_PREFILTER 0
+// Spectral block (EMG_SPECTRAL_FEATURES) in the features
+#define EMG_MODEL_SPECTRAL_FEATURES 0
+// Time-domain features (FEATURE_* bits) and their thresholds in ADC counts
+#define EMG_MODEL_TIME_FEATURES 0x1F
+#define EMG_MODEL_ZC_DEADBAND 0
+#define EMG_MODEL_SSC_THRESHOLD 3600
+#define EMG_MODEL_WAMP_THRESHOLD 200
+
 // Channel mapping:
 // ch1: flexor carpi radialis (a0)
 // ch2: brachioradialis (a1)
@@ -31,8 +49,25 @@ extern const float scaler_scale[NUM_FEATURES];
 extern const float lr_coefficients[NUM_CLASSES][NUM_FEATURES];
 extern const float lr_intercept[NUM_CLASSES];
 
+// Fixed-point model (EMG_FIXED_POINT): scaler folded into the coefficients,
+// scores are scaled by 2^LR_Q_FRAC_BITS (see emg_model.c)
+extern const uint8_t feature_q_shift[NUM_FEATURES];
+extern const int32_t lr_q_coefficients[NUM_CLASSES][NUM_FEATURES];
+extern const int64_t lr_q_intercept[NUM_CLASSES];
+
+// Evaluated by model_runtime.c
+extern const ModelDescriptor emg_model_descriptor;
+
 extern const char* gesture_names[NUM_CLASSES];
 
 GestureType predict_gesture(const float* features);
+// Also fills probs[NUM_CLASSES] with the class probabilities
+GestureType predict_gesture_proba(const float* features, float* probs);
+GestureType predict_gesture_q(const int32_t* q_features);
+GestureType predict_gesture_q_proba(const int32_t* q_features, float* probs);
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif // EMG_MODEL_H
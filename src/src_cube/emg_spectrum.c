@@ -0,0 +1,162 @@
+#include "emg_spectrum.h"
+#include <math.h>
+#include <stdbool.h>
+
+#define HALF (SPECTRUM_FFT_SIZE / 2)
+#define HALF_BITS 6
+#define PI_F 3.14159265f
+#define BIN_HZ ((float)SAMPLING_RATE_HZ / SPECTRUM_FFT_SIZE)
+
+// e^(-j 2 pi k / SPECTRUM_FFT_SIZE); the half-size FFT uses every other entry
+static float twiddle_re[HALF];
+static float twiddle_im[HALF];
+static float hann[SPECTRUM_FFT_SIZE];
+static uint8_t bit_reverse[HALF];
+static float power_scale;
+static bool tables_ready = false;
+
+static void init_tables(void) {
+    float window_energy = 0.0f;
+    for (int i = 0; i < SPECTRUM_FFT_SIZE; i++) {
+        hann[i] = 0.5f - 0.5f * cosf(2.0f * PI_F * i / SPECTRUM_FFT_SIZE);
+        window_energy += hann[i] * hann[i];
+    }
+    for (int k = 0; k < HALF; k++) {
+        twiddle_re[k] = cosf(2.0f * PI_F * k / SPECTRUM_FFT_SIZE);
+        twiddle_im[k] = -sinf(2.0f * PI_F * k / SPECTRUM_FFT_SIZE);
+        uint8_t r = 0;
+        for (int b = 0; b < HALF_BITS; b++) {
+            r |= (uint8_t)(((k >> b) & 1) << (HALF_BITS - 1 - b));
+        }
+        bit_reverse[k] = r;
+    }
+    // One-sided mean square per bin: |X|^2 * 2 / (N * sum w^2), Parseval with the window
+    power_scale = 2.0f / (SPECTRUM_FFT_SIZE * window_energy);
+    tables_ready = true;
+}
+
+// In-place radix-2 decimation-in-time FFT of HALF complex points
+static void fft_half(float* re, float* im) {
+    for (int i = 0; i < HALF; i++) {
+        int j = bit_reverse[i];
+        if (j > i) {
+            float t = re[i];
+            re[i] = re[j];
+            re[j] = t;
+            t = im[i];
+            im[i] = im[j];
+            im[j] = t;
+        }
+    }
+    for (int len = 2; len <= HALF; len <<= 1) {
+        int stride = SPECTRUM_FFT_SIZE / len;  // Twiddle step in the full-size table
+        for (int start = 0; start < HALF; start += len) {
+            for (int k = 0; k < len / 2; k++) {
+                float wr = twiddle_re[k * stride];
+                float wi = twiddle_im[k * stride];
+                int a = start + k;
+                int b = a + len / 2;
+                float tr = re[b] * wr - im[b] * wi;
+                float ti = re[b] * wi + im[b] * wr;
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+            }
+        }
+    }
+}
+
+void emg_spectrum_power(const int16_t* x, uint32_t n, float power[SPECTRUM_BINS]) {
+    if (!tables_ready) {
+        init_tables();
+    }
+    x += n - SPECTRUM_FFT_SIZE;
+
+    int32_t sum = 0;
+    for (int i = 0; i < SPECTRUM_FFT_SIZE; i++) {
+        sum += x[i];
+    }
+    float mean = (float)sum / SPECTRUM_FFT_SIZE;
+
+    // Even samples as the real part, odd ones as the imaginary part
+    float re[HALF], im[HALF];
+    for (int i = 0; i < HALF; i++) {
+        re[i] = (x[2 * i] - mean) * hann[2 * i];
+        im[i] = (x[2 * i + 1] - mean) * hann[2 * i + 1];
+    }
+    fft_half(re, im);
+
+    // Split: X[k] = E[k] + W^k O[k], with E and O recovered from Z[k] and conj(Z[HALF-k])
+    power[0] = 0.0f;  // Mean removed
+    for (int k = 1; k <= HALF; k++) {
+        int m = k == HALF ? 0 : HALF - k;
+        int z = k == HALF ? 0 : k;
+        float er = 0.5f * (re[z] + re[m]);
+        float ei = 0.5f * (im[z] - im[m]);
+        float or_ = 0.5f * (im[z] + im[m]);
+        float oi = -0.5f * (re[z] - re[m]);
+        float wr = k == HALF ? -1.0f : twiddle_re[k];
+        float wi = k == HALF ? 0.0f : twiddle_im[k];
+        float xr = er + or_ * wr - oi * wi;
+        float xi = ei + or_ * wi + oi * wr;
+        float scale = k == HALF ? power_scale / 2.0f : power_scale;
+        power[k] = (xr * xr + xi * xi) * scale;
+    }
+}
+
+// Sum of power over [lo_hz, hi_hz), whole bins by centre frequency
+static float band_power(const float* power, float lo_hz, float hi_hz) {
+    float total = 0.0f;
+    for (int k = 1; k < SPECTRUM_BINS; k++) {
+        float f = k * BIN_HZ;
+        if (f >= lo_hz && f < hi_hz) {
+            total += power[k];
+        }
+    }
+    return total;
+}
+
+static float to_db(float p) {
+    return 10.0f * log10f(p + 1.0f);
+}
+
+void emg_spectrum_features(const int16_t* x, uint32_t n, float* features) {
+    float power[SPECTRUM_BINS];
+    emg_spectrum_power(x, n, power);
+
+    float total = 0.0f, moment = 0.0f;
+    int first = -1, last = 0;
+    for (int k = 1; k < SPECTRUM_BINS; k++) {
+        float f = k * BIN_HZ;
+        if (f < SPECTRUM_BAND_LOW_HZ || f >= SPECTRUM_BAND_TOP_HZ) {
+            continue;
+        }
+        if (first < 0) {
+            first = k;
+        }
+        last = k;
+        total += power[k];
+        moment += f * power[k];
+    }
+
+    // Mean frequency; median frequency interpolated inside the bin that crosses half
+    float mnf = 0.0f, mdf = 0.0f;
+    if (total > 0.0f) {
+        mnf = moment / total;
+        float half = 0.5f * total, cumulative = 0.0f;
+        for (int k = first; k <= last; k++) {
+            if (cumulative + power[k] >= half) {
+                mdf = (k - 0.5f + (half - cumulative) / power[k]) * BIN_HZ;
+                break;
+            }
+            cumulative += power[k];
+        }
+    }
+
+    features[0] = mnf;
+    features[1] = mdf;
+    features[2] = to_db(band_power(power, SPECTRUM_BAND_LOW_HZ, SPECTRUM_BAND_MID_HZ));
+    features[3] = to_db(band_power(power, SPECTRUM_BAND_MID_HZ, SPECTRUM_BAND_HIGH_HZ));
+    features[4] = to_db(band_power(power, SPECTRUM_BAND_HIGH_HZ, SPECTRUM_BAND_TOP_HZ));
+}
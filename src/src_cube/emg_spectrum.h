@@ -0,0 +1,47 @@
+#ifndef EMG_SPECTRUM_H
+#define EMG_SPECTRUM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "common_defs.h"
+#include <stdint.h>
+
+// Spectral feature block, appended to each channel's time-domain features when
+// EMG_SPECTRAL_FEATURES is 1 (float path only). A model has to be exported for it:
+// the trainer (ml/emg_features.py) builds with the same setting and the export
+// records it in EMG_MODEL_SPECTRAL_FEATURES.
+#ifndef EMG_SPECTRAL_FEATURES
+#define EMG_SPECTRAL_FEATURES 0
+#endif
+
+// The newest SPECTRUM_FFT_SIZE samples of the window, mean removed and Hann
+// weighted, through a real FFT (a 64-point complex radix-2 FFT plus the split).
+// Bins are SAMPLING_RATE_HZ / 128 = 11.7Hz wide.
+#define SPECTRUM_FFT_SIZE 128
+#define SPECTRUM_BINS (SPECTRUM_FFT_SIZE / 2 + 1)
+
+// Per channel: mean frequency, median frequency (Hz, over the EMG band), and the
+// power in three sub-bands (dB re 1 LSB^2)
+#define SPECTRAL_FEATURES_PER_CHANNEL 5
+#define SPECTRUM_BAND_LOW_HZ 20
+#define SPECTRUM_BAND_MID_HZ 80
+#define SPECTRUM_BAND_HIGH_HZ 200
+#define SPECTRUM_BAND_TOP_HZ 450
+
+// Cortex-M4 budget per channel: 192 radix-2 butterflies, the split, windowing and
+// the band sums. Four channels stay near 1% of the CLASSIFY_PERIOD_MS hop at 50MHz.
+#define EMG_SPECTRUM_CYCLES_PER_CHANNEL 8000
+
+// One-sided power spectrum (mean square per bin) of the newest SPECTRUM_FFT_SIZE of
+// the n >= SPECTRUM_FFT_SIZE samples in x (oldest first)
+void emg_spectrum_power(const int16_t* x, uint32_t n, float power[SPECTRUM_BINS]);
+// SPECTRAL_FEATURES_PER_CHANNEL features of the same samples
+void emg_spectrum_features(const int16_t* x, uint32_t n, float* features);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EMG_SPECTRUM_H
@@ -0,0 +1,25 @@
+#include "events.h"
+
+static volatile uint32_t pending_events = 0;
+
+void events_post(uint32_t flags) {
+    __atomic_fetch_or(&pending_events, flags, __ATOMIC_RELEASE);
+}
+
+uint32_t events_take(void) {
+    return __atomic_exchange_n(&pending_events, 0, __ATOMIC_ACQUIRE);
+}
+
+uint32_t events_take_some(uint32_t flags) {
+    return __atomic_fetch_and(&pending_events, ~flags, __ATOMIC_ACQUIRE) & flags;
+}
+
+void events_wait(void) {
+    // With interrupts masked an IRQ between the check and __WFI stays pending and
+    // wakes the core immediately, so no event can be slept through
+    __disable_irq();
+    if (pending_events == 0) {
+        __WFI();
+    }
+    __enable_irq();
+}
@@ -0,0 +1,36 @@
+#ifndef EVENTS_H
+#define EVENTS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f4xx_hal.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+// Work the main loop has to do, posted from interrupts (or the loop itself)
+typedef enum {
+    EVT_ADC_DATA     = 1u << 0,  // ADC DMA half/complete: a burst of frames is waiting
+    EVT_HOP_READY    = 1u << 1,  // The window has advanced by HOP_SAMPLES, classify it
+    EVT_SERVO_DONE   = 1u << 2,  // PCA9685 pose burst finished
+    EVT_UART_TX_DONE = 1u << 3,  // Telemetry DMA finished a buffer
+    EVT_CONSOLE_LINE = 1u << 4,  // A command line arrived on the UART
+    EVT_SERVO_TICK   = 1u << 5,  // TIM4: next PWM frame, step the finger trajectories
+} EventFlag;
+
+// Interrupt-safe (atomic OR)
+void events_post(uint32_t flags);
+// Returns and clears all pending events
+uint32_t events_take(void);
+// Returns and clears only the given events; the others stay pending
+uint32_t events_take_some(uint32_t flags);
+// Sleeps (__WFI) until the next interrupt unless an event is already pending.
+// New ADC frames arrive with EVT_ADC_DATA from the DMA half/complete interrupts.
+void events_wait(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EVENTS_H
@@ -0,0 +1,99 @@
+#include "feature_normaliser.h"
+#include <string.h>
+
+// Keeps the gain finite for features that barely move at rest
+#define MIN_SPREAD 1e-3f
+
+void feature_normaliser_init(FeatureNormaliser* norm, const FeatureNormaliserConfig* config) {
+    static const FeatureNormaliserConfig defaults = FEATURE_NORMALISER_DEFAULTS;
+    memset(norm, 0, sizeof(*norm));
+    norm->config = config ? *config : defaults;
+    for (int i = 0; i < TOTAL_FEATURES; i++) {
+        norm->gain[i] = 1.0f;
+    }
+}
+
+static float clampf(float v, float lo, float hi) {
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+// Amplitude check of every channel's MAV against the tracked baseline. Once locked the
+// gate is never narrower than the one the reference was learned with: the rest spread
+// of a channel comes in quiet and busy stretches, and a gate that shrank over a quiet
+// one would drop the busy rest windows the reference still counts.
+static bool near_baseline(const FeatureNormaliser* norm, const float* features) {
+    for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+        int i = ch * FEATURES_PER_CHANNEL;  // MAV
+        float spread = norm->spread[i];
+        if (norm->locked && norm->reference_spread[i] > spread) {
+            spread = norm->reference_spread[i];
+        }
+        if (spread < MIN_SPREAD) {
+            spread = MIN_SPREAD;
+        }
+        if (fabsf(features[i] - norm->baseline[i]) > norm->config.gate * spread) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool feature_normaliser_update(FeatureNormaliser* norm, const float* features, bool at_rest) {
+    const FeatureNormaliserConfig* cfg = &norm->config;
+    uint32_t taken = norm->lock_count + norm->updates;
+
+    // Before locking the classifier picks the rest windows, after it only the amplitude
+    // gate does: the classifier's view of rest is what drift corrupts first. The gate
+    // applies in both phases (the classifier also calls low-effort gesture windows
+    // REST), so reference_spread and spread measure the same population.
+    if (!norm->locked && !at_rest) {
+        return false;
+    }
+    if (taken >= FEATURE_NORMALISER_SEED_WINDOWS && !near_baseline(norm, features)) {
+        return false;
+    }
+
+    // Running mean until 1/alpha windows are in, the EWMA after. The reference is a
+    // snapshot of this same estimator, so with no drift the gain stays near 1.
+    float w = 1.0f / (float)(taken + 1);
+    if (w < cfg->alpha) {
+        w = cfg->alpha;
+    }
+    // The shift limit follows the model in use, which calibration may have replaced
+    const float* scale = classifier_get_model()->scaler_scale;
+    for (int i = 0; i < TOTAL_FEATURES; i++) {
+        float baseline = norm->baseline[i] + w * (features[i] - norm->baseline[i]);
+        if (norm->locked) {
+            float shift_limit = cfg->max_shift * scale[i];
+            baseline = clampf(baseline, norm->reference[i] - shift_limit, norm->reference[i] + shift_limit);
+        }
+        norm->baseline[i] = baseline;
+        norm->spread[i] += w * (fabsf(features[i] - baseline) - norm->spread[i]);
+    }
+
+    if (!norm->locked) {
+        if (++norm->lock_count >= cfg->lock_windows) {
+            memcpy(norm->reference, norm->baseline, sizeof(norm->reference));
+            memcpy(norm->reference_spread, norm->spread, sizeof(norm->reference_spread));
+            norm->locked = true;
+        }
+        return true;
+    }
+
+    for (int i = 0; i < TOTAL_FEATURES; i++) {
+        float spread = norm->spread[i] > MIN_SPREAD ? norm->spread[i] : MIN_SPREAD;
+        float reference_spread = norm->reference_spread[i] > MIN_SPREAD ? norm->reference_spread[i] : MIN_SPREAD;
+        norm->gain[i] = clampf(reference_spread / spread, 1.0f / cfg->max_gain, cfg->max_gain);
+    }
+    norm->updates++;
+    return true;
+}
+
+void feature_normaliser_apply(const FeatureNormaliser* norm, float* features) {
+    if (!norm->locked) {
+        return;
+    }
+    for (int i = 0; i < TOTAL_FEATURES; i++) {
+        features[i] = norm->reference[i] + (features[i] - norm->baseline[i]) * norm->gain[i];
+    }
+}
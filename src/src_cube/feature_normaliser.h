@@ -0,0 +1,57 @@
+#ifndef FEATURE_NORMALISER_H
+#define FEATURE_NORMALISER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "emg_classifier.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+// Drift compensation in front of the classifier. The rest baseline and spread of
+// every feature are followed with a slow EWMA during gated rest windows; after
+// lock_windows of them the estimate is frozen as the reference and tracking goes
+// on. Each window is mapped back onto the reference:
+//   f' = reference + (f - baseline) * reference_spread / spread
+// so the frozen scaler_mean/scaler_scale of the exported model keep fitting while
+// electrode impedance and sweat move the baselines. Float features only; the signal
+// validation ranges are raw ADC levels and are checked before the mapping.
+typedef struct {
+    float alpha;            // EWMA weight of one rest window (0.005 = ~10s of rest at 20Hz)
+    uint16_t lock_windows;  // Rest windows taken before the reference is frozen
+    float gate;             // Rest: every MAV within gate * spread of the baseline
+    float max_shift;        // |baseline - reference| limit, in the active model's scaler_scale
+    float max_gain;         // reference_spread / spread kept within [1/max_gain, max_gain]
+} FeatureNormaliserConfig;
+
+#define FEATURE_NORMALISER_DEFAULTS { 0.005f, 2000, 4.0f, 3.0f, 2.0f }
+// Rest windows taken before the gate applies (the spread is unknown until then)
+#define FEATURE_NORMALISER_SEED_WINDOWS 10
+
+typedef struct {
+    FeatureNormaliserConfig config;
+    float reference[TOTAL_FEATURES];
+    float reference_spread[TOTAL_FEATURES];
+    float baseline[TOTAL_FEATURES];
+    float spread[TOTAL_FEATURES];   // Mean |f - baseline| at rest
+    float gain[TOTAL_FEATURES];     // Clamped reference_spread / spread
+    uint16_t lock_count;
+    bool locked;
+    uint32_t updates;               // Rest windows taken after locking
+} FeatureNormaliser;
+
+// config may be NULL for FEATURE_NORMALISER_DEFAULTS
+void feature_normaliser_init(FeatureNormaliser* norm, const FeatureNormaliserConfig* config);
+// Feeds one window's raw features after classification. at_rest (the window was
+// classified REST) picks the reference windows; once locked, rest is detected from
+// the amplitude gate alone. Returns true when the window was used as a rest window.
+bool feature_normaliser_update(FeatureNormaliser* norm, const float* features, bool at_rest);
+// Maps the features onto the reference in place; unchanged until the reference is locked
+void feature_normaliser_apply(const FeatureNormaliser* norm, float* features);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FEATURE_NORMALISER_H
@@ -0,0 +1,235 @@
+// feature_pipeline.h (C++ only)
+// The sample ring, running sums and per-channel features of emg_classifier.c as a
+// template over window, hop, channel count and feature list, so other
+// configurations can be built and compared side by side (emg_host pipebench).
+// The default instantiation must match the C API and the exported model.
+#ifndef FEATURE_PIPELINE_H
+#define FEATURE_PIPELINE_H
+
+#include "emg_classifier.h"
+#include <math.h>
+#include <string.h>
+#include <type_traits>
+
+namespace emg_features {
+
+// Features computed from one channel's window sums over n samples. kBit is the
+// FEATURE_* bit, kStats the EMG_DSP_* sums it needs.
+struct Mav {
+    static constexpr uint32_t kBit = FEATURE_MAV;
+    static constexpr uint32_t kStats = EMG_DSP_SUM_ABS;
+    static float compute(const EMG_ChannelSums& s, int n) { return (float)s.sum_abs / n; }
+};
+
+struct Rms {
+    static constexpr uint32_t kBit = FEATURE_RMS;
+    static constexpr uint32_t kStats = EMG_DSP_SUM_SQR;
+    static float compute(const EMG_ChannelSums& s, int n) { return sqrtf((float)s.sum_sqr / n); }
+};
+
+struct Var {
+    static constexpr uint32_t kBit = FEATURE_VAR;
+    static constexpr uint32_t kStats = EMG_DSP_SUM | EMG_DSP_SUM_SQR;
+    static float compute(const EMG_ChannelSums& s, int n) {
+        int64_t var_num = (int64_t)n * s.sum_sqr - (int64_t)s.sum * s.sum;
+        return (float)var_num / ((float)n * n);
+    }
+};
+
+struct Wl {
+    static constexpr uint32_t kBit = FEATURE_WL;
+    static constexpr uint32_t kStats = EMG_DSP_SUM_DIFF;
+    static float compute(const EMG_ChannelSums& s, int /*n*/) { return (float)s.sum_diff; }
+};
+
+struct Zc {
+    static constexpr uint32_t kBit = FEATURE_ZC;
+    static constexpr uint32_t kStats = EMG_DSP_ZC;
+    static float compute(const EMG_ChannelSums& s, int /*n*/) { return (float)s.zero_crossings; }
+};
+
+struct Ssc {
+    static constexpr uint32_t kBit = FEATURE_SSC;
+    static constexpr uint32_t kStats = EMG_DSP_SSC;
+    static float compute(const EMG_ChannelSums& s, int /*n*/) { return (float)s.slope_changes; }
+};
+
+struct Wamp {
+    static constexpr uint32_t kBit = FEATURE_WAMP;
+    static constexpr uint32_t kStats = EMG_DSP_WAMP;
+    static float compute(const EMG_ChannelSums& s, int /*n*/) { return (float)s.willison; }
+};
+
+// Union of the sums a feature list needs
+template <typename... Features>
+struct StatsOf;
+
+template <>
+struct StatsOf<> {
+    static constexpr uint32_t value = 0;
+};
+
+template <typename F, typename... Rest>
+struct StatsOf<F, Rest...> {
+    static constexpr uint32_t value = F::kStats | StatsOf<Rest...>::value;
+};
+
+// Thresholds of the firmware build (emg_classifier.h), as compile-time constants
+static constexpr int32_t kZcDeadband = EMG_ZC_DEADBAND;
+static constexpr int32_t kSscThreshold = EMG_SSC_THRESHOLD;
+static constexpr int32_t kWampThreshold = EMG_WAMP_THRESHOLD;
+
+} // namespace emg_features
+
+template <int Window, int Step, int Channels, typename... Features>
+class FeaturePipeline {
+public:
+    static_assert(Window >= 2, "window needs at least two samples");
+    static_assert(Step >= 1 && Step <= Window, "hop must be between 1 and the window length");
+    static_assert(Channels >= 1, "at least one channel");
+    static_assert(sizeof...(Features) >= 1, "at least one feature per channel");
+    // sum |x| and sum |dx| are int32: 12-bit samples leave room for 2^18 samples
+    static_assert(Window <= (1 << 18), "window too long for the int32 sums");
+
+    static constexpr int kWindow = Window;
+    static constexpr int kStep = Step;
+    static constexpr int kChannels = Channels;
+    static constexpr int kFeaturesPerChannel = (int)sizeof...(Features);
+    static constexpr int kFeatureCount = Channels * kFeaturesPerChannel;
+    static constexpr uint32_t kStats = emg_features::StatsOf<Features...>::value;
+
+    FeaturePipeline() { reset(); }
+
+    void reset() {
+        memset(data_, 0, sizeof(data_));
+        memset(sums_, 0, sizeof(sums_));
+        write_index_ = 0;
+        full_ = false;
+        until_hop_ = Window;
+    }
+
+    // Adds one sample per channel; returns true when the window is full and a hop
+    // boundary has been reached (windows start at 0, Step, 2*Step, ...)
+    bool add_sample(const int16_t* sample) {
+        const int idx = write_index_;
+        const bool has_prev = full_ || idx > 0;
+        const bool has_prev2 = full_ || idx > 1;
+
+        for (int ch = 0; ch < Channels; ch++) {
+            EMG_ChannelSums& s = sums_[ch];
+            const int16_t* w = &data_[ch][idx];
+            if (full_) {
+                int16_t old = w[0];
+                int16_t after = w[1];
+                if (kStats & EMG_DSP_SUM_ABS) s.sum_abs -= abs_i32(old);
+                if (kStats & EMG_DSP_SUM_SQR) s.sum_sqr -= (int32_t)old * old;
+                if (kStats & EMG_DSP_SUM) s.sum -= old;
+                if (kStats & EMG_DSP_SUM_DIFF) s.sum_diff -= abs_i32((int32_t)after - old);
+                if (kStats & EMG_DSP_ZC) s.zero_crossings -= zero_crossing(old, after);
+                if (kStats & EMG_DSP_WAMP) s.willison -= willison(old, after);
+                if (kStats & EMG_DSP_SSC) s.slope_changes -= slope_change(old, after, w[2]);
+            }
+
+            int16_t val = sample[ch];
+            if (kStats & EMG_DSP_SUM_ABS) s.sum_abs += abs_i32(val);
+            if (kStats & EMG_DSP_SUM_SQR) s.sum_sqr += (int32_t)val * val;
+            if (kStats & EMG_DSP_SUM) s.sum += val;
+            if (has_prev) {
+                int16_t before = w[Window - 1];
+                if (kStats & EMG_DSP_SUM_DIFF) s.sum_diff += abs_i32((int32_t)val - before);
+                if (kStats & EMG_DSP_ZC) s.zero_crossings += zero_crossing(before, val);
+                if (kStats & EMG_DSP_WAMP) s.willison += willison(before, val);
+                if ((kStats & EMG_DSP_SSC) && has_prev2) s.slope_changes += slope_change(w[Window - 2], before, val);
+            }
+
+            data_[ch][idx] = val;
+            data_[ch][idx + Window] = val;
+        }
+
+        if (++write_index_ == Window) {
+            write_index_ = 0;
+            full_ = true;
+        }
+        if (--until_hop_ == 0) {
+            until_hop_ = Step;
+            return true;
+        }
+        return false;
+    }
+
+    bool full() const { return full_; }
+
+    // Channel-major features, kFeaturesPerChannel per channel in template order
+    void features(float* out) const {
+        for (int ch = 0; ch < Channels; ch++) {
+            channel_features(sums_[ch], &out[ch * kFeaturesPerChannel]);
+        }
+    }
+
+    // Oldest sample first, Window samples
+    const int16_t* channel_window(int ch) const { return &data_[ch][write_index_]; }
+    const EMG_ChannelSums& sums(int ch) const { return sums_[ch]; }
+
+private:
+    static int32_t abs_i32(int32_t v) { return v < 0 ? -v : v; }
+
+    static int32_t zero_crossing(int16_t a, int16_t b) {
+        return (a < 0) != (b < 0) && abs_i32((int32_t)b - a) >= emg_features::kZcDeadband;
+    }
+    static int32_t willison(int16_t a, int16_t b) {
+        return abs_i32((int32_t)b - a) >= emg_features::kWampThreshold;
+    }
+    static int32_t slope_change(int16_t a, int16_t mid, int16_t b) {
+        return ((int32_t)mid - a) * ((int32_t)mid - b) >= emg_features::kSscThreshold;
+    }
+
+    static void channel_features(const EMG_ChannelSums& s, float* out) {
+        int i = 0;
+        // Braced initialisation evaluates the pack in order
+        const int expand[] = { (out[i++] = Features::compute(s, Window), 0)... };
+        (void)expand;
+    }
+
+    int16_t data_[Channels][2 * Window];
+    EMG_ChannelSums sums_[Channels];
+    int write_index_;
+    bool full_;
+    int until_hop_;
+};
+
+namespace emg_features {
+
+// Pipeline (with no features yet) extended by the candidates whose kBit is in Mask,
+// keeping their order
+template <uint32_t Mask, typename Pipeline, typename... Candidates>
+struct SelectFeatures {
+    typedef Pipeline type;
+};
+
+template <uint32_t Mask, int W, int S, int C, typename... Chosen, typename F, typename... Rest>
+struct SelectFeatures<Mask, FeaturePipeline<W, S, C, Chosen...>, F, Rest...> {
+    typedef typename std::conditional<(Mask & F::kBit) != 0,
+                                      typename SelectFeatures<Mask, FeaturePipeline<W, S, C, Chosen..., F>, Rest...>::type,
+                                      typename SelectFeatures<Mask, FeaturePipeline<W, S, C, Chosen...>, Rest...>::type>::type
+        type;
+};
+
+} // namespace emg_features
+
+// The configuration the firmware and the exported model use (EMG_TIME_FEATURES)
+typedef emg_features::SelectFeatures<EMG_TIME_FEATURES, FeaturePipeline<WINDOW_SIZE, STEP_SIZE, NUM_CHANNELS>,
+                                     emg_features::Mav, emg_features::Rms, emg_features::Var, emg_features::Wl,
+                                     emg_features::Zc, emg_features::Ssc, emg_features::Wamp>::type
+    DefaultFeaturePipeline;
+
+static_assert(DefaultFeaturePipeline::kFeaturesPerChannel == TIME_FEATURES_PER_CHANNEL,
+              "feature list and TIME_FEATURES_PER_CHANNEL disagree");
+// The spectral block (emg_spectrum.h) is appended per channel outside the template;
+// with it, the pipeline's features make up the exported model's input
+#ifndef EMG_FEATURES_ONLY
+static_assert(DefaultFeaturePipeline::kFeatureCount
+                  + NUM_CHANNELS * (FEATURES_PER_CHANNEL - TIME_FEATURES_PER_CHANNEL) == NUM_FEATURES,
+              "feature pipeline and emg_model.h NUM_FEATURES disagree, re-export the model");
+#endif
+
+#endif // FEATURE_PIPELINE_H
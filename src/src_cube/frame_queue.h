@@ -0,0 +1,104 @@
+#ifndef FRAME_QUEUE_H
+#define FRAME_QUEUE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "common_defs.h"
+#include "stm32f4xx_hal.h"
+#include <stdint.h>
+
+// Wait-free single-producer/single-consumer ring of timestamped ADC frames. On the
+// target the producer is the ADC DMA interrupt and the consumer the main loop; on
+// the host they are two threads. head is written only by the producer and tail
+// only by the consumer. Each side publishes its index with a release store after
+// touching the slots, and reads the other side's index with an acquire load, so
+// a slot is never read before it is written or overwritten before it is read (DMB
+// on the Cortex-M4, ordered stores on x86). A full queue drops the newest frames;
+// neither side ever waits.
+#ifndef FRAME_QUEUE_FRAMES
+#define FRAME_QUEUE_FRAMES 512
+#endif
+#if (FRAME_QUEUE_FRAMES & (FRAME_QUEUE_FRAMES - 1)) != 0
+#error "FRAME_QUEUE_FRAMES must be a power of two"
+#endif
+
+// The two indices on separate cache lines on the host, so the threads do not
+// bounce one line between cores; the M4 has no data cache
+#ifdef HAL_SHIM
+#define FRAME_QUEUE_ALIGN 64
+#else
+#define FRAME_QUEUE_ALIGN 4
+#endif
+
+typedef struct {
+    uint32_t timestamp;   // Sample clock: frames since adc_acq_start, gaps are drops
+    uint16_t ch[ADC_CHANNELS];
+} AdcFrame;
+
+typedef struct {
+    // Producer side
+    uint32_t head __attribute__((aligned(FRAME_QUEUE_ALIGN)));   // Frames pushed (wraps freely)
+    uint32_t dropped;       // Frames refused because the queue was full
+    uint32_t full_pushes;   // Pushes that dropped at least one frame
+    uint32_t high_water;    // Most frames waiting after a push
+    // Consumer side
+    uint32_t tail __attribute__((aligned(FRAME_QUEUE_ALIGN)));   // Frames popped (wraps freely)
+    AdcFrame frames[FRAME_QUEUE_FRAMES] __attribute__((aligned(FRAME_QUEUE_ALIGN)));
+} FrameQueue;
+
+// Neither side may run during init
+static inline void frame_queue_init(FrameQueue* q) {
+    q->head = 0;
+    q->dropped = 0;
+    q->full_pushes = 0;
+    q->high_water = 0;
+    q->tail = 0;
+}
+
+// Producer: appends up to n frames, drops the rest if the queue fills; returns the
+// number appended
+static inline uint32_t frame_queue_push(FrameQueue* q, const AdcFrame* frames, uint32_t n) {
+    uint32_t head = q->head;
+    uint32_t tail = __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE);
+    uint32_t space = FRAME_QUEUE_FRAMES - (head - tail);
+    uint32_t count = n < space ? n : space;
+    for (uint32_t i = 0; i < count; i++) {
+        q->frames[(head + i) & (FRAME_QUEUE_FRAMES - 1)] = frames[i];
+    }
+    __atomic_store_n(&q->head, head + count, __ATOMIC_RELEASE);
+
+    if (count < n) {
+        q->dropped += n - count;
+        q->full_pushes++;
+    }
+    if (head + count - tail > q->high_water) {
+        q->high_water = head + count - tail;
+    }
+    return count;
+}
+
+// Consumer: moves up to max frames, oldest first, into out; returns the count
+static inline uint32_t frame_queue_pop(FrameQueue* q, AdcFrame* out, uint32_t max) {
+    uint32_t tail = q->tail;
+    uint32_t head = __atomic_load_n(&q->head, __ATOMIC_ACQUIRE);
+    uint32_t count = head - tail < max ? head - tail : max;
+    for (uint32_t i = 0; i < count; i++) {
+        out[i] = q->frames[(tail + i) & (FRAME_QUEUE_FRAMES - 1)];
+    }
+    __atomic_store_n(&q->tail, tail + count, __ATOMIC_RELEASE);
+    return count;
+}
+
+// Frames waiting; exact on either side for its own view, a snapshot otherwise
+static inline uint32_t frame_queue_count(const FrameQueue* q) {
+    uint32_t tail = __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE);
+    return __atomic_load_n(&q->head, __ATOMIC_ACQUIRE) - tail;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FRAME_QUEUE_H
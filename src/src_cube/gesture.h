@@ -1,9 +1,22 @@
 #ifndef GESTURE_H
 #define GESTURE_H
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #include "servo_control.h"
 #include "emg_model.h"
 
+// Pose of a gesture from the const table (REST for out-of-range values)
+const HandPose* gesture_pose(GestureType gesture);
+
+// Reports the gesture and makes its pose the target of servo_motion; the fingers
+// get there over the following PWM frames
 void execute_gesture(GestureType gesture);
 
-#endif // GESTURE_Hs
\ No newline at end of file
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GESTURE_H
@@ -0,0 +1,60 @@
+#include "gesture_decision.h"
+#include <string.h>
+
+void gesture_decision_init(GestureDecision* decision, const GestureDecisionConfig* config) {
+    static const GestureDecisionConfig defaults = GESTURE_DECISION_DEFAULTS;
+    decision->config = config ? *config : defaults;
+    decision->immediate = 0;
+    decision->accumulated = 0;
+    decision->rejected = 0;
+    gesture_decision_reset(decision, GESTURE_REST);
+}
+
+void gesture_decision_reset(GestureDecision* decision, GestureType current) {
+    memset(decision->evidence, 0, sizeof(decision->evidence));
+    decision->current = current;
+}
+
+static bool switch_to(GestureDecision* decision, GestureType best, GestureType* gesture) {
+    memset(decision->evidence, 0, sizeof(decision->evidence));
+    if (best == decision->current) {
+        return false;
+    }
+    decision->current = best;
+    *gesture = best;
+    return true;
+}
+
+bool gesture_decision_push(GestureDecision* decision, const float* probs, GestureType* gesture) {
+    const GestureDecisionConfig* cfg = &decision->config;
+
+    GestureType best = GESTURE_ROCK;
+    for (int c = 1; c < NUM_CLASSES; c++) {
+        if (probs[c] > probs[best]) {
+            best = (GestureType)c;
+        }
+    }
+
+    if (probs[best] >= cfg->accept) {
+        if (best != decision->current) {
+            decision->immediate++;
+        }
+        return switch_to(decision, best, gesture);
+    }
+
+    // Rejected windows add nothing, but old evidence still fades
+    bool rejected = probs[best] < cfg->reject;
+    for (int c = 0; c < NUM_CLASSES; c++) {
+        decision->evidence[c] = decision->evidence[c] * cfg->decay + (rejected ? 0.0f : probs[c]);
+    }
+    if (rejected) {
+        decision->rejected++;
+        return false;
+    }
+
+    if (best != decision->current && decision->evidence[best] >= cfg->evidence_needed) {
+        decision->accumulated++;
+        return switch_to(decision, best, gesture);
+    }
+    return false;
+}
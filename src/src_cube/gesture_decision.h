@@ -0,0 +1,48 @@
+#ifndef GESTURE_DECISION_H
+#define GESTURE_DECISION_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "emg_model.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+// Confidence-gated decisions on the classifier's class probabilities. A window at or
+// above accept switches at once; windows below reject are ignored; anything between
+// adds its probabilities to a decaying per-class evidence total, and a gesture is
+// taken once its evidence reaches evidence_needed.
+typedef struct {
+    float accept;           // Switch immediately at this probability
+    float reject;           // Ignore windows whose best probability is below this
+    float evidence_needed;  // Accumulated probability needed to switch
+    float decay;            // Evidence kept from one window to the next (0..1)
+} GestureDecisionConfig;
+
+// Tuned with emg_host replay --no-validate on the recordings in data/: the exported
+// model puts most windows at 0.3-0.5 on the winning class (10 classes)
+#define GESTURE_DECISION_DEFAULTS { 0.8f, 0.3f, 1.0f, 0.7f }
+
+typedef struct {
+    GestureDecisionConfig config;
+    float evidence[NUM_CLASSES];
+    GestureType current;
+    uint32_t immediate;    // Switches from a single confident window
+    uint32_t accumulated;  // Switches from accumulated evidence
+    uint32_t rejected;     // Low-confidence windows ignored
+} GestureDecision;
+
+// config may be NULL for GESTURE_DECISION_DEFAULTS
+void gesture_decision_init(GestureDecision* decision, const GestureDecisionConfig* config);
+// Sets the current gesture (e.g. REST on an invalid signal) and clears the evidence
+void gesture_decision_reset(GestureDecision* decision, GestureType current);
+// Adds one window's probabilities [NUM_CLASSES]; returns true and sets *gesture when
+// the decided gesture changes
+bool gesture_decision_push(GestureDecision* decision, const float* probs, GestureType* gesture);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GESTURE_DECISION_H
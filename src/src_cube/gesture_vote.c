@@ -0,0 +1,40 @@
+#include "gesture_vote.h"
+
+void gesture_vote_init(GestureVote* vote) {
+    for (int i = 0; i < GESTURE_VOTE_WINDOW; i++) {
+        vote->history[i] = GESTURE_REST;
+    }
+    vote->index = 0;
+    vote->count = 0;
+}
+
+bool gesture_vote_push(GestureVote* vote, GestureType prediction, GestureType* winner) {
+    vote->history[vote->index] = prediction;
+    vote->index = (vote->index + 1) % GESTURE_VOTE_WINDOW;
+    if (vote->count < GESTURE_VOTE_WINDOW) vote->count++;
+
+    if (vote->count < GESTURE_VOTE_MIN) {
+        return false;
+    }
+
+    int count[NUM_CLASSES] = {0};
+    for (int i = 0; i < vote->count; i++) {
+        count[vote->history[i]]++;
+    }
+
+    // Find most frequent gesture
+    GestureType most_frequent = GESTURE_REST;
+    int max_count = 0;
+    for (int i = 0; i < NUM_CLASSES; i++) {
+        if (count[i] > max_count) {
+            max_count = count[i];
+            most_frequent = (GestureType)i;
+        }
+    }
+
+    if (max_count < GESTURE_VOTE_MIN) {
+        return false;
+    }
+    *winner = most_frequent;
+    return true;
+}
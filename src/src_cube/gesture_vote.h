@@ -0,0 +1,30 @@
+#ifndef GESTURE_VOTE_H
+#define GESTURE_VOTE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "emg_model.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define GESTURE_VOTE_WINDOW 5    // Last N predictions kept
+#define GESTURE_VOTE_MIN    3    // Agreeing predictions needed to accept a gesture
+
+// Majority vote over the most recent classifier outputs
+typedef struct {
+    GestureType history[GESTURE_VOTE_WINDOW];
+    uint8_t index;
+    uint8_t count;
+} GestureVote;
+
+void gesture_vote_init(GestureVote* vote);
+// Adds a prediction; returns true and sets *winner when one gesture holds the majority
+bool gesture_vote_push(GestureVote* vote, GestureType prediction, GestureType* winner);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GESTURE_VOTE_H
@@ -1,10 +1,21 @@
 #include "main.h"
 #include "periph_init.h"
 #include "emg_classifier.h"
+#include "feature_pipeline.h"  // Compile-time check of the features against the model
 #include "signal_validation.h"
 #include "gesture.h"
+#include "servo_motion.h"
+#include "gesture_decision.h"
+#include "feature_normaliser.h"
+#include "calibration.h"
+#include "adc_acquisition.h"
+#include "telemetry.h"
+#include "trace.h"
+#include "console.h"
+#include "events.h"
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 EMG_Buffer emg_buffer;
 
@@ -12,17 +23,50 @@ GestureType current_gesture = GESTURE_REST;
 GestureType last_executed_gesture = GESTURE_REST;
 
 // Feature buffer
+#if EMG_FIXED_POINT
+int32_t extracted_features[TOTAL_FEATURES];
+#else
 float extracted_features[TOTAL_FEATURES];
+#endif
 
-#define ADC_CHANNELS 4
-#define BUF_SIZE 8
-__attribute__((aligned(4))) uint16_t adc_buffer[BUF_SIZE] = {0};
+// Frames drained from the ADC DMA buffer per loop pass
+#define ADC_READ_BATCH 32
+static AdcFrame adc_frames[ADC_READ_BATCH];
+
+// Frames left until the next classification; drain_adc() stops exactly on the hop
+// boundary so every classified window ends on it
+static uint32_t samples_to_hop = HOP_SAMPLES;
+
+// Confidence-gated gesture decisions on the class probabilities
+static GestureDecision gesture_decision;
+
+#if !EMG_FIXED_POINT
+// Follows the rest baselines so the frozen model scaler keeps fitting (float path only)
+static FeatureNormaliser feature_normaliser;
+static float raw_features[TOTAL_FEATURES];
+
+// "calib" walks the user through the gestures and fits a model on the device
+static Calibration calibration;
+static CalibratedModel calibrated_model;
+static ModelDescriptor calibrated_descriptor;
+#endif
+
+// When the last trajectory frame was handed to the servo driver, for TRACE_SERVO
+static uint32_t pose_requested_at = 0;
+static bool pose_in_flight = false;
+
+// "trace" report waiting for room in the telemetry buffer
+static bool report_pending = false;
 
 extern ADC_HandleTypeDef hadc1;
 extern DMA_HandleTypeDef hdma_adc1;
+extern DMA_HandleTypeDef hdma_i2c1_tx;
+extern DMA_HandleTypeDef hdma_usart1_tx;
 extern UART_HandleTypeDef huart1;
 extern TIM_HandleTypeDef htim3;
+extern TIM_HandleTypeDef htim4;
 
+#if !TELEMETRY_BINARY
 // Clean output: sensors + gesture only
 void output_sensors_and_gesture(uint16_t ch1, uint16_t ch2, uint16_t ch3, uint16_t ch4, GestureType gesture) {
     // Format: "S1,S2,S3,S4:G" (e.g., "1234,567,890,123:9")
@@ -30,7 +74,142 @@ void output_sensors_and_gesture(uint16_t ch1, uint16_t ch2, uint16_t ch3, uint16
     static char buf[40];
     int len = snprintf(buf, sizeof(buf), "%4d,%4d,%4d,%4d:%d\n",
                       ch1, ch2, ch3, ch4, gesture);
-    HAL_UART_Transmit(&huart1, (uint8_t*)buf, len, 10);
+    telemetry_write((uint8_t*)buf, len);
+}
+#endif
+
+// Runs the selected (float or fixed-point) feature and inference path on the current
+// window. Returns false until the window is full; *valid is false when the signal is
+// out of range and no prediction was made, otherwise probs holds the class probabilities.
+static bool classify_window(bool* valid, float* probs) {
+    uint32_t t = trace_now();
+#if EMG_FIXED_POINT
+    if (!emg_buffer_process_window_q(&emg_buffer, extracted_features)) {
+        return false;
+    }
+    t = trace_record(TRACE_FEATURES, t);
+    *valid = is_window_valid_q(&emg_buffer);
+    if (*valid) {
+        classify_gesture_q_proba(extracted_features, probs);
+    }
+#else
+    if (!emg_buffer_process_window(&emg_buffer, extracted_features)) {
+        return false;
+    }
+    // The validity ranges are raw ADC levels, so they see the features before the
+    // normaliser; only the classifier input is normalised
+    memcpy(raw_features, extracted_features, sizeof(raw_features));
+    *valid = is_window_valid(&emg_buffer, raw_features);
+    feature_normaliser_apply(&feature_normaliser, extracted_features);
+    t = trace_record(TRACE_FEATURES, t);
+    GestureType prediction = GESTURE_REST;
+    if (*valid) {
+        prediction = classify_gesture_proba(extracted_features, probs);
+    }
+    feature_normaliser_update(&feature_normaliser, raw_features, *valid && prediction == GESTURE_REST);
+#endif
+    trace_record(TRACE_PREDICT, t);
+    return true;
+}
+
+// Queues the latency report; if the telemetry buffer is full it is retried on the
+// next EVT_UART_TX_DONE
+static void send_report(void) {
+    static char report[1024];
+    int len = trace_format_report(report, sizeof(report));
+    report_pending = !telemetry_write((const uint8_t*)report, (uint16_t)len);
+}
+
+static void log_text(const char* text) {
+    telemetry_write((const uint8_t*)text, (uint16_t)strlen(text));
+}
+
+#if !EMG_FIXED_POINT
+// Classifies with model (NULL = the exported one) and restarts the normaliser and the
+// decisions, whose state belongs to the previous model
+static void use_model(const CalibratedModel* model) {
+    if (model) {
+        calibration_descriptor(model, &calibrated_descriptor);
+        classifier_set_model(&calibrated_descriptor);
+    } else {
+        classifier_set_model(NULL);
+    }
+    feature_normaliser_init(&feature_normaliser, NULL);
+    gesture_decision_init(&gesture_decision, NULL);
+}
+
+static void calibration_prompt(void) {
+    char buf[48];
+    snprintf(buf, sizeof(buf), "calib: %s in %ds\n", gesture_names[calibration_gesture(&calibration)],
+             CALIB_PROMPT_MS / 1000);
+    log_text(buf);
+}
+
+// "calib [lda|centroid] [trials]" or "calib clear"
+static void calibration_command(const char* args) {
+    if (strcmp(args, " clear") == 0) {
+        calibration_clear();
+        use_model(NULL);
+        log_text("calib: cleared, using the exported model\n");
+        return;
+    }
+    CalibrationFit fit = strstr(args, "centroid") ? CALIB_CENTROID : CALIB_LDA;
+    const char* digits = strpbrk(args, "0123456789");
+    int trials = digits ? atoi(digits) : 1;
+    calibration_start(&calibration, (uint8_t)trials, fit, HAL_GetTick());
+    calibration_prompt();
+}
+
+static void finish_calibration(void) {
+    char buf[64];
+    uint32_t t = trace_now();
+    bool fitted = calibration_fit(&calibration, &calibrated_model);
+    uint32_t fit_us = (trace_now() - t) / trace_ticks_per_us();
+    calibration.mode = MODE_IDLE;
+    if (!fitted) {
+        log_text("calib: failed, too few windows\n");
+        return;
+    }
+
+    // The sector erase stalls flash reads, and with them the CPU, for 1-2s. The ADC
+    // DMA keeps running and the loss shows up in the acquisition counters.
+    bool saved = calibration_save(&calibrated_model);
+    use_model(saved ? calibration_stored() : &calibrated_model);
+    snprintf(buf, sizeof(buf), "calib: %s fitted in %luus, %s\n",
+             calibration_fit_name((CalibrationFit)calibrated_model.fit), (unsigned long)fit_us,
+             saved ? "stored" : "NOT stored");
+    log_text(buf);
+}
+
+static void calibration_step(void) {
+    switch (calibration_tick(&calibration, HAL_GetTick())) {
+    case CALIB_EVT_PROMPT:
+        calibration_prompt();
+        break;
+    case CALIB_EVT_RECORD:
+        log_text("calib: go\n");
+        break;
+    case CALIB_EVT_DONE:
+        finish_calibration();
+        break;
+    default:
+        break;
+    }
+}
+#endif
+
+// UART commands: "trace" dumps the stage latency report, "trace reset" clears it,
+// "calib ..." runs the on-device calibration (float path)
+static void handle_command(const char* cmd) {
+    if (strcmp(cmd, "trace") == 0) {
+        send_report();
+    } else if (strcmp(cmd, "trace reset") == 0) {
+        trace_reset();
+#if !EMG_FIXED_POINT
+    } else if (strncmp(cmd, "calib", 5) == 0 && calibration.mode == MODE_IDLE) {
+        calibration_command(cmd + 5);
+#endif
+    }
 }
 
 // Only output when gesture changes
@@ -38,8 +217,110 @@ void output_gesture_change(GestureType old_gesture, GestureType new_gesture) {
     if (old_gesture != new_gesture) {
         char buf[30];
         int len = snprintf(buf, sizeof(buf), "Gesture: %d -> %d\n", old_gesture, new_gesture);
-        HAL_UART_Transmit(&huart1, (uint8_t*)buf, len, 10);
+        telemetry_write((uint8_t*)buf, len);
+    }
+}
+
+static void actuate(GestureType gesture) {
+    uint32_t t_actuate = trace_now();
+    execute_gesture(gesture);
+    trace_record(TRACE_ACTUATE, t_actuate);
+}
+
+// One PWM frame of the finger trajectories; only frames that move a finger are sent
+static void servo_step(void) {
+    HandPose pose;
+    if (servo_motion_tick(&servo_motion, &pose)) {
+        pose_requested_at = trace_now();
+        pose_in_flight = true;
+        SetHandPose(&pose);
+    }
+}
+
+// One classification step on the window ending at the hop boundary
+static void classify_step(void) {
+    uint32_t t_classify = trace_now();
+
+    // Try to process a window
+    bool valid = false;
+    float probs[NUM_CLASSES];
+    if (!classify_window(&valid, probs)) {
+        return;
+    }
+
+#if !EMG_FIXED_POINT
+    // During calibration the windows feed the statistics, not the decisions
+    if (calibration.mode != MODE_IDLE) {
+        calibration_add_window(&calibration, raw_features);
+        trace_record(TRACE_CLASSIFY, t_classify);
+        return;
     }
+#endif
+
+    // Validate signal
+    if (valid) {
+        // Confident windows switch at once, ambiguous ones accumulate evidence
+        GestureType decided_gesture;
+        uint32_t t_decide = trace_now();
+        bool changed = gesture_decision_push(&gesture_decision, probs, &decided_gesture);
+        trace_record(TRACE_DECIDE, t_decide);
+        if (changed) {
+            // Output gesture change
+            output_gesture_change(current_gesture, decided_gesture);
+
+            // Update and execute
+            current_gesture = decided_gesture;
+            if (current_gesture != last_executed_gesture) {
+                last_executed_gesture = current_gesture;
+                actuate(last_executed_gesture);
+            }
+        }
+    } else {
+        // Invalid signal - reset to REST
+        gesture_decision_reset(&gesture_decision, GESTURE_REST);
+        if (current_gesture != GESTURE_REST) {
+            output_gesture_change(current_gesture, GESTURE_REST);
+            current_gesture = GESTURE_REST;
+            last_executed_gesture = GESTURE_REST;
+            actuate(GESTURE_REST);
+        }
+    }
+    trace_record(TRACE_CLASSIFY, t_classify);
+}
+
+// Moves the conversions the DMA has completed into the window (and telemetry), up to
+// the next hop boundary, where it posts EVT_HOP_READY. Returns the frames read.
+static uint32_t drain_adc(void) {
+    uint32_t want = samples_to_hop < ADC_READ_BATCH ? samples_to_hop : ADC_READ_BATCH;
+    uint32_t count = adc_acq_read(adc_frames, want);
+
+    for (uint32_t i = 0; i < count; i++) {
+        // Add sample to EMG buffer
+        uint32_t t_sample = trace_now();
+#if EMG_PREFILTER
+        int16_t filtered[NUM_CHANNELS];
+        for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+            filtered[ch] = (int16_t)adc_frames[i].ch[ch];
+        }
+        emg_filter_process(&emg_buffer.filter, filtered, filtered);
+        trace_record(TRACE_FILTER, t_sample);
+        emg_buffer_push(&emg_buffer, filtered);
+#else
+        emg_buffer_add_sample(&emg_buffer, adc_frames[i].ch[0], adc_frames[i].ch[1], adc_frames[i].ch[2],
+                              adc_frames[i].ch[3]);
+#endif
+#if TELEMETRY_BINARY
+        telemetry_push_sample(adc_frames[i].ch, (uint8_t)current_gesture);
+#endif
+        trace_record(TRACE_SAMPLE, t_sample);
+    }
+
+    samples_to_hop -= count;
+    if (samples_to_hop == 0) {
+        samples_to_hop = HOP_SAMPLES;
+        events_post(EVT_HOP_READY);
+    }
+    return count;
 }
 
 int main(void) {
@@ -50,131 +331,102 @@ int main(void) {
     MX_DMA_Init();
     MX_ADC1_Init();
     MX_TIM3_Init();
+    MX_TIM4_Init();
     MX_I2C1_Init();
 
     emg_buffer_init(&emg_buffer);
     InitAllServos();
+    const HandPose rest_pose = { { SERVO_REST_ANGLE, SERVO_REST_ANGLE, SERVO_REST_ANGLE, SERVO_REST_ANGLE,
+                                   SERVO_REST_ANGLE } };
+    servo_motion_init(&servo_motion, NULL, &rest_pose);
+    telemetry_init(&huart1);
+    console_init(&huart1);
+    trace_init();
+#if EMG_PREFILTER
+    trace_set_deadline(TRACE_FILTER, emg_filter_budget_cycles(&emg_buffer.filter, EMG_FIXED_POINT));
+#endif
+#if EMG_SPECTRAL_FEATURES
+    // The FFTs dominate the features row; the time-domain features come from the sums
+    trace_set_deadline(TRACE_FEATURES, NUM_CHANNELS * EMG_SPECTRUM_CYCLES_PER_CHANNEL);
+#endif
 
     // Startup message only
     const char* startup_msg = "EMG System Ready\n";
-    HAL_UART_Transmit(&huart1, (uint8_t*)startup_msg, strlen(startup_msg), 100);
+    telemetry_write((const uint8_t*)startup_msg, strlen(startup_msg));
 
+#if !TELEMETRY_BINARY
     // Header for data stream
     const char* header = "S1,S2,S3,S4:GESTURE\n";
-    HAL_UART_Transmit(&huart1, (uint8_t*)header, strlen(header), 100);
+    telemetry_write((const uint8_t*)header, strlen(header));
+#endif
 
     HAL_TIM_Base_Start(&htim3);
-    HAL_ADC_Start_DMA(&hadc1, (uint32_t*)adc_buffer, BUF_SIZE);
+    HAL_TIM_Base_Start_IT(&htim4);
+    adc_acq_start();
 
-    uint32_t last_dma_pos = 0;
-    uint32_t last_classification_time = HAL_GetTick();
+#if !TELEMETRY_BINARY
     uint32_t last_output_time = HAL_GetTick();
+#endif
+
+    gesture_decision_init(&gesture_decision, NULL);
+#if !EMG_FIXED_POINT
+    feature_normaliser_init(&feature_normaliser, NULL);
+    calibration_init(&calibration);
+    // A model fitted earlier on this device replaces the exported one
+    const CalibratedModel* stored = calibration_stored();
+    if (stored) {
+        use_model(stored);
+    }
+#endif
+
+    // Event loop: interrupts post events (ADC DMA half/complete, servo frame tick,
+    // servo burst done, UART TX done, console line) and the core sleeps in __WFI when there is nothing
+    // to do. Each ADC DMA half/complete interrupt queues ADC_HALF_FRAMES frames and posts
+    // EVT_ADC_DATA, which is what wakes the loop to drain them. The events are taken
+    // before the drain, so an EVT_ADC_DATA posted after it stays pending and keeps
+    // events_wait() from sleeping on queued frames.
+    uint32_t t_wake = trace_now();
+    while (1) {
+        uint32_t events = events_take();
+        uint32_t count = drain_adc();
+        events |= events_take_some(EVT_HOP_READY);   // Posted by the drain just now
+
+        if (events & EVT_HOP_READY) {
+            classify_step();
+            trace_record(TRACE_HOP, t_wake);
+#if !EMG_FIXED_POINT
+            calibration_step();
+#endif
+        }
 
-    // Gesture history for consistency (reduced from 10 to 5 for faster response)
-    GestureType gesture_history[5] = {GESTURE_REST};
-    uint8_t history_index = 0;
-    uint8_t history_count = 0;
+        if (events & EVT_SERVO_TICK) {
+            servo_step();
+        }
 
-    // For output throttling
-    uint16_t output_ch1 = 0, output_ch2 = 0, output_ch3 = 0, output_ch4 = 0;
+        if ((events & EVT_SERVO_DONE) && pose_in_flight) {
+            pose_in_flight = false;
+            trace_record(TRACE_SERVO, pose_requested_at);
+        }
 
-    while (1) {
-        uint32_t dma_pos = BUF_SIZE - hdma_adc1.Instance->NDTR;
-
-        if (dma_pos != last_dma_pos) {
-            // Calculate the index of the COMPLETE sample set (4 channels)
-            // DMA_pos points to the NEXT position to fill, so we need the PREVIOUS complete set
-            uint32_t last_complete_set = ((dma_pos / ADC_CHANNELS) - 1) * ADC_CHANNELS;
-            uint32_t sample_idx;
-
-            if (dma_pos >= ADC_CHANNELS) {
-                // Normal case: DMA has at least one complete set
-                sample_idx = last_complete_set;
-            } else {
-                // Wrap-around case: DMA wrapped, get from end of buffer
-                sample_idx = ((BUF_SIZE / ADC_CHANNELS) - 1) * ADC_CHANNELS;
+        if (events & EVT_CONSOLE_LINE) {
+            char cmd[CONSOLE_LINE_MAX];
+            if (console_read_line(cmd, sizeof(cmd))) {
+                handle_command(cmd);
             }
+        }
 
-            // Ensure we have a valid complete set
-            if ((sample_idx + ADC_CHANNELS <= BUF_SIZE) || (sample_idx < BUF_SIZE && ADC_CHANNELS <= BUF_SIZE)) {
-                // Store sensor readings for output
-                output_ch1 = adc_buffer[sample_idx];
-                output_ch2 = adc_buffer[sample_idx + 1];
-                output_ch3 = adc_buffer[sample_idx + 2];
-                output_ch4 = adc_buffer[sample_idx + 3];
-
-                // Add sample to EMG buffer
-                emg_buffer_add_sample(&emg_buffer, output_ch1, output_ch2, output_ch3, output_ch4);
-
-                // Process classification every 50ms (20Hz)
-                uint32_t current_time = HAL_GetTick();
-                if (current_time - last_classification_time >= 50) {
-                    last_classification_time = current_time;
-
-                    // Try to process a window
-                    if (emg_buffer_process_window(&emg_buffer, extracted_features)) {
-
-                        // Validate signal
-                        if (are_features_valid(extracted_features)) {
-                            // Valid signal - classify
-                            GestureType new_gesture = classify_gesture(extracted_features);
-
-                            // Update gesture history
-                            gesture_history[history_index] = new_gesture;
-                            history_index = (history_index + 1) % 5;
-                            if (history_count < 5) history_count++;
-
-                            // Check for consistent gesture (3 out of 5)
-                            if (history_count >= 3) {
-                                int count[10] = {0};
-                                for (int i = 0; i < history_count; i++) {
-                                    count[gesture_history[i]]++;
-                                }
-
-                                // Find most frequent gesture
-                                GestureType most_frequent = GESTURE_REST;
-                                int max_count = 0;
-                                for (int i = 0; i < 10; i++) {
-                                    if (count[i] > max_count) {
-                                        max_count = count[i];
-                                        most_frequent = (GestureType)i;
-                                    }
-                                }
-
-                                // If gesture is consistent (at least 3 of last 5)
-                                if (max_count >= 3 && most_frequent != current_gesture) {
-                                    // Output gesture change
-                                    output_gesture_change(current_gesture, most_frequent);
-
-                                    // Update and execute
-                                    current_gesture = most_frequent;
-                                    if (current_gesture != last_executed_gesture) {
-                                        last_executed_gesture = current_gesture;
-                                        execute_gesture(last_executed_gesture);
-                                    }
-                                }
-                            }
-                        } else {
-                            // Invalid signal - reset to REST
-                            if (current_gesture != GESTURE_REST) {
-                                output_gesture_change(current_gesture, GESTURE_REST);
-                                current_gesture = GESTURE_REST;
-                                last_executed_gesture = GESTURE_REST;
-                                execute_gesture(GESTURE_REST);
-                            }
-                        }
-                    }
-                }
-
-                // Output sensor data at 10Hz (every 100ms)
-                if (current_time - last_output_time >= 100) {
-                    last_output_time = current_time;
-                    output_sensors_and_gesture(output_ch1, output_ch2, output_ch3, output_ch4, current_gesture);
-                }
-            }
+        if ((events & EVT_UART_TX_DONE) && report_pending) {
+            send_report();
+        }
 
-            last_dma_pos = dma_pos;
+#if !TELEMETRY_BINARY
+        // Output sensor data at 10Hz (every 100ms)
+        if (count > 0 && HAL_GetTick() - last_output_time >= 100) {
+            last_output_time = HAL_GetTick();
+            const uint16_t* latest = adc_frames[count - 1].ch;
+            output_sensors_and_gesture(latest[0], latest[1], latest[2], latest[3], current_gesture);
         }
+#endif
 
         // Minimal LED blink (once per second)
         static uint32_t led_timer = 0;
@@ -182,6 +434,12 @@ int main(void) {
             led_timer = HAL_GetTick();
             HAL_GPIO_TogglePin(GPIOC, GPIO_PIN_13);
         }
+
+        // A full batch or a hop boundary may leave frames behind: drain again first
+        if (count == 0) {
+            events_wait();
+            t_wake = trace_now();
+        }
     }
 }
 
@@ -206,4 +464,28 @@ extern "C" {
     void TIM3_IRQHandler(void) {
         HAL_TIM_IRQHandler(&htim3);
     }
+
+    void TIM4_IRQHandler(void) {
+        HAL_TIM_IRQHandler(&htim4);
+    }
+
+    void DMA2_Stream7_IRQHandler(void) {
+        HAL_DMA_IRQHandler(&hdma_usart1_tx);
+    }
+
+    void USART1_IRQHandler(void) {
+        HAL_UART_IRQHandler(&huart1);
+    }
+
+    void DMA1_Stream6_IRQHandler(void) {
+        HAL_DMA_IRQHandler(&hdma_i2c1_tx);
+    }
+
+    void I2C1_EV_IRQHandler(void) {
+        HAL_I2C_EV_IRQHandler(&hi2c1);
+    }
+
+    void I2C1_ER_IRQHandler(void) {
+        HAL_I2C_ER_IRQHandler(&hi2c1);
+    }
 }
\ No newline at end of file
@@ -0,0 +1,128 @@
+#include "model_runtime.h"
+#include <stddef.h>
+#include <math.h>
+
+bool model_descriptor_valid(const ModelDescriptor* model) {
+    if (model->num_features == 0 || model->num_features > MODEL_MAX_FEATURES
+        || model->num_classes == 0 || model->num_classes > MODEL_MAX_CLASSES
+        || model->scaler_mean == NULL || model->scaler_scale == NULL
+        || model->weights == NULL || model->bias == NULL) {
+        return false;
+    }
+    if (model->type == MODEL_MLP) {
+        return model->num_hidden > 0 && model->num_hidden <= MODEL_MAX_HIDDEN
+               && model->out_weights != NULL && model->out_bias != NULL;
+    }
+    return model->type == MODEL_LR || model->type == MODEL_LDA;
+}
+
+// out[r] = bias[r] + sum_c weights[r][c] * in[c]
+static void dense(const float* weights, const float* bias, const float* in, uint32_t cols,
+                  float* out, uint32_t rows) {
+    for (uint32_t r = 0; r < rows; r++) {
+        const float* w = &weights[r * cols];
+        float acc = bias[r];
+        for (uint32_t c = 0; c < cols; c++) {
+            acc += w[c] * in[c];
+        }
+        out[r] = acc;
+    }
+}
+
+int model_predict(const ModelDescriptor* model, const float* features, float* scores) {
+    float scaled[MODEL_MAX_FEATURES];
+    float local_scores[MODEL_MAX_CLASSES];
+    if (scores == NULL) {
+        scores = local_scores;
+    }
+
+    for (uint32_t i = 0; i < model->num_features; i++) {
+        scaled[i] = (features[i] - model->scaler_mean[i]) / model->scaler_scale[i];
+    }
+
+    if (model->type == MODEL_MLP) {
+        float hidden[MODEL_MAX_HIDDEN];
+        dense(model->weights, model->bias, scaled, model->num_features, hidden, model->num_hidden);
+        for (uint32_t h = 0; h < model->num_hidden; h++) {
+            if (hidden[h] < 0.0f) {
+                hidden[h] = 0.0f;
+            }
+        }
+        dense(model->out_weights, model->out_bias, hidden, model->num_hidden, scores,
+              model->num_classes);
+    } else {
+        dense(model->weights, model->bias, scaled, model->num_features, scores, model->num_classes);
+    }
+
+    // First maximum wins, as in the original predict_gesture()
+    int best = 0;
+    for (uint32_t c = 1; c < model->num_classes; c++) {
+        if (scores[c] > scores[best]) {
+            best = (int)c;
+        }
+    }
+    return best;
+}
+
+void model_scores_to_proba(ModelType type, const float* scores, uint32_t num_classes, float* probs) {
+    float sum = 0.0f;
+    if (type == MODEL_LR) {
+        for (uint32_t c = 0; c < num_classes; c++) {
+            probs[c] = 1.0f / (1.0f + expf(-scores[c]));
+            sum += probs[c];
+        }
+    } else {
+        // Shifted by the maximum so expf cannot overflow
+        float max_score = scores[0];
+        for (uint32_t c = 1; c < num_classes; c++) {
+            if (scores[c] > max_score) {
+                max_score = scores[c];
+            }
+        }
+        for (uint32_t c = 0; c < num_classes; c++) {
+            probs[c] = expf(scores[c] - max_score);
+            sum += probs[c];
+        }
+    }
+    for (uint32_t c = 0; c < num_classes; c++) {
+        probs[c] /= sum;
+    }
+}
+
+int model_predict_proba(const ModelDescriptor* model, const float* features, float* probs) {
+    float scores[MODEL_MAX_CLASSES];
+    int best = model_predict(model, features, scores);
+    model_scores_to_proba(model->type, scores, model->num_classes, probs);
+    return best;
+}
+
+uint32_t model_param_bytes(const ModelDescriptor* model) {
+    uint32_t floats = 2u * model->num_features;
+    if (model->type == MODEL_MLP) {
+        floats += (uint32_t)model->num_hidden * (model->num_features + 1);
+        floats += (uint32_t)model->num_classes * (model->num_hidden + 1);
+    } else {
+        floats += (uint32_t)model->num_classes * (model->num_features + 1);
+    }
+    return floats * sizeof(float) + sizeof(ModelDescriptor);
+}
+
+uint32_t model_scratch_bytes(const ModelDescriptor* model) {
+    uint32_t floats = MODEL_MAX_FEATURES + MODEL_MAX_CLASSES;
+    if (model->type == MODEL_MLP) {
+        floats += MODEL_MAX_HIDDEN;
+    }
+    return floats * sizeof(float);
+}
+
+const char* model_type_name(ModelType type) {
+    switch (type) {
+    case MODEL_LR:
+        return "lr";
+    case MODEL_LDA:
+        return "lda";
+    case MODEL_MLP:
+        return "mlp";
+    }
+    return "?";
+}
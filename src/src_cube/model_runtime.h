@@ -0,0 +1,63 @@
+#ifndef MODEL_RUNTIME_H
+#define MODEL_RUNTIME_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Classifier families the runtime can evaluate. LR and LDA are both linear in the
+// scaled features (argmax of W x + b) and share a kernel; the type records how the
+// weights were trained.
+typedef enum {
+    MODEL_LR = 0,   // One-vs-rest logistic regression
+    MODEL_LDA,      // Linear discriminant analysis
+    MODEL_MLP,      // One ReLU hidden layer, linear output
+} ModelType;
+
+// Upper bounds for the scratch arrays on the stack
+#define MODEL_MAX_FEATURES 64
+#define MODEL_MAX_HIDDEN 64
+#define MODEL_MAX_CLASSES 16
+
+// A trained model as emitted by ml/model_export.py. All blobs are row-major float
+// arrays in flash; the scaler is applied as (f - mean) / scale.
+typedef struct {
+    ModelType type;
+    uint16_t num_features;
+    uint16_t num_classes;
+    uint16_t num_hidden;        // MLP only, 0 otherwise
+    const float* scaler_mean;   // [num_features]
+    const float* scaler_scale;  // [num_features]
+    const float* weights;       // LR/LDA: [num_classes][num_features], MLP: [num_hidden][num_features]
+    const float* bias;          // LR/LDA: [num_classes], MLP: [num_hidden]
+    const float* out_weights;   // MLP: [num_classes][num_hidden]
+    const float* out_bias;      // MLP: [num_classes]
+} ModelDescriptor;
+
+// Checks the sizes against the scratch limits and that every blob is present
+bool model_descriptor_valid(const ModelDescriptor* model);
+
+// Returns the winning class; scores (optional, [num_classes]) receives the raw outputs
+int model_predict(const ModelDescriptor* model, const float* features, float* scores);
+
+// Raw scores -> class probabilities summing to 1: per-class logistic then normalised
+// for one-vs-rest LR (as sklearn's predict_proba), softmax for LDA and MLP
+void model_scores_to_proba(ModelType type, const float* scores, uint32_t num_classes, float* probs);
+
+// model_predict() plus probabilities [num_classes]; returns the winning class
+int model_predict_proba(const ModelDescriptor* model, const float* features, float* probs);
+
+// Flash used by the blobs and stack used by model_predict, in bytes
+uint32_t model_param_bytes(const ModelDescriptor* model);
+uint32_t model_scratch_bytes(const ModelDescriptor* model);
+
+const char* model_type_name(ModelType type);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MODEL_RUNTIME_H
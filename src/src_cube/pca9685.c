@@ -7,6 +7,14 @@ bool PCA9685_Init(PCA9685_HandleTypeDef *pca, I2C_HandleTypeDef *hi2c, uint8_t a
     pca->hi2c = hi2c;
     pca->address = address << 1; // Shift address for HAL
     pca->frequency = freq;
+    pca->tx_busy = false;
+    pca->pending = false;
+    pca->block_done = NULL;
+    pca->blocks_written = 0;
+    pca->blocks_coalesced = 0;
+    pca->blocks_skipped = 0;
+    pca->block_errors = 0;
+    pca->shadow_valid = 0;  // Whatever the LEDn registers hold from before a reset
     
     // Reset device
     if (!PCA9685_Reset(pca)) {
@@ -47,9 +55,16 @@ bool PCA9685_SetPWM(PCA9685_HandleTypeDef *pca, uint8_t channel, uint16_t on, ui
     };
     
     if (HAL_I2C_Mem_Write(pca->hi2c, pca->address, reg, I2C_MEMADD_SIZE_8BIT, data, 4, 100) != HAL_OK) {
+        pca->shadow_valid &= ~(1u << channel);
         return false;
     }
-    
+
+    if (on == 0 && off < 4096) {
+        pca->shadow_off[channel] = off;
+        pca->shadow_valid |= 1u << channel;
+    } else {
+        pca->shadow_valid &= ~(1u << channel);
+    }
     return true;
 }
 
@@ -58,12 +73,125 @@ bool PCA9685_SetServoAngle(PCA9685_HandleTypeDef *pca, uint8_t channel, uint8_t
     if (angle > 180) angle = 180;
     
     // Map angle to pulse width
-    uint16_t pulse = SERVO_MIN_PULSE + ((SERVO_MAX_PULSE - SERVO_MIN_PULSE) * angle) / 180;
+    uint16_t pulse = PCA9685_AngleToPulse(angle);
     // printf("Servo %d: Angle=%d° -> Pulse=%dμs\r\n", channel, angle, pulse);
     // Set PWM (always start at 0, end at pulse value)
     return PCA9685_SetPWM(pca, channel, 0, pulse);
 }
 
+uint16_t PCA9685_AngleToPulse(uint8_t angle) {
+    if (angle > 180) angle = 180;
+    return SERVO_MIN_PULSE + ((SERVO_MAX_PULSE - SERVO_MIN_PULSE) * angle) / 180;
+}
+
+static bool PCA9685_ShadowMatches(const PCA9685_HandleTypeDef *pca, uint8_t channel, uint16_t off) {
+    return (pca->shadow_valid & (1u << channel)) && pca->shadow_off[channel] == off;
+}
+
+// Sends the channels of pca->next that differ from the shadow, as one burst from the
+// first to the last of them; a leading channel with a known ON = 0 starts at its
+// LEDn_OFF_L. The caller sets tx_busy; it is cleared again here when nothing was
+// started. Returns false only if the transfer failed to start.
+static bool PCA9685_StartBlock(PCA9685_HandleTypeDef *pca) {
+    const PCA9685_Block *block = &pca->next;
+    int first = -1, last = -1;
+    for (uint8_t i = 0; i < block->count; i++) {
+        if (!PCA9685_ShadowMatches(pca, block->first_channel + i, block->off[i])) {
+            first = first < 0 ? i : first;
+            last = i;
+        }
+    }
+    pca->pending = false;
+    if (first < 0) {
+        pca->blocks_skipped++;
+        pca->tx_busy = false;
+        return true;
+    }
+
+    PCA9685_Block *sending = &pca->sending;
+    sending->first_channel = (uint8_t)(block->first_channel + first);
+    sending->count = (uint8_t)(last - first + 1);
+    for (uint8_t i = 0; i < sending->count; i++) {
+        uint16_t off = block->off[first + i];
+        uint8_t *d = &pca->tx_data[4 * i];
+        sending->off[i] = off;
+        d[0] = 0;                     // LED_ON_L
+        d[1] = 0;                     // LED_ON_H
+        d[2] = off & 0xFF;            // LED_OFF_L
+        d[3] = (off >> 8) & 0x0F;     // LED_OFF_H
+    }
+    const uint8_t *data = pca->tx_data;
+    uint8_t reg = PCA9685_LED0_ON_L + (4 * sending->first_channel);
+    uint16_t size = 4 * sending->count;
+    if (pca->shadow_valid & (1u << sending->first_channel)) {
+        data += 2;
+        reg += 2;
+        size -= 2;
+    }
+
+    if (HAL_I2C_Mem_Write_DMA(pca->hi2c, pca->address, reg, I2C_MEMADD_SIZE_8BIT, (uint8_t *)data, size)
+        != HAL_OK) {
+        pca->block_errors++;
+        pca->tx_busy = false;
+        return false;
+    }
+    return true;
+}
+
+bool PCA9685_SetPWMBlock(PCA9685_HandleTypeDef *pca, uint8_t first_channel, const uint16_t *off,
+                         uint8_t count) {
+    if (count == 0 || first_channel + count > PCA9685_NUM_CHANNELS) {
+        return false;
+    }
+
+    // The completion interrupt may be about to start the pending block
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (pca->pending) {
+        pca->blocks_coalesced++;
+    }
+    pca->next.first_channel = first_channel;
+    pca->next.count = count;
+    for (uint8_t i = 0; i < count; i++) {
+        pca->next.off[i] = off[i];
+    }
+    pca->pending = true;
+    bool start = !pca->tx_busy;
+    pca->tx_busy = true;
+    __set_PRIMASK(primask);
+
+    return start ? PCA9685_StartBlock(pca) : true;
+}
+
+void PCA9685_BlockComplete(PCA9685_HandleTypeDef *pca, bool ok) {
+    if (!pca->tx_busy) {
+        return;  // Not one of ours (e.g. a blocking transfer failed)
+    }
+    const PCA9685_Block *sent = &pca->sending;
+    for (uint8_t i = 0; i < sent->count; i++) {
+        uint8_t channel = sent->first_channel + i;
+        if (ok) {
+            pca->shadow_off[channel] = sent->off[i];
+            pca->shadow_valid |= 1u << channel;
+        } else {
+            pca->shadow_valid &= ~(1u << channel);  // Partially written at best
+        }
+    }
+    if (ok) {
+        pca->blocks_written++;
+    } else {
+        pca->block_errors++;
+    }
+    if (pca->block_done) {
+        pca->block_done(pca, ok);
+    }
+    if (pca->pending) {
+        PCA9685_StartBlock(pca);
+    } else {
+        pca->tx_busy = false;
+    }
+}
+
 bool PCA9685_Sleep(PCA9685_HandleTypeDef *pca, bool sleep) {
     uint8_t mode1;
     
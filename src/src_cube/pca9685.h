@@ -34,15 +34,53 @@ extern "C" {
 #define SERVO_MIN_PULSE  125  //125 // Minimum pulse length (0 degrees)
 #define SERVO_MAX_PULSE  500  //500 // Maximum pulse length (180 degrees)
 
+#define PCA9685_NUM_CHANNELS 16
+
+// Consecutive channels written by one PCA9685_SetPWMBlock() burst (ON = 0, OFF = off[i])
 typedef struct {
+    uint8_t first_channel;
+    uint8_t count;
+    uint16_t off[PCA9685_NUM_CHANNELS];
+} PCA9685_Block;
+
+typedef struct PCA9685_HandleTypeDef {
     I2C_HandleTypeDef *hi2c;
     uint8_t address;
     float frequency;
+
+    // Non-blocking block writes. Only one I2C DMA transfer is in flight; a block
+    // requested meanwhile waits in 'next', and a newer request replaces it.
+    volatile bool tx_busy;
+    volatile bool pending;
+    PCA9685_Block next;
+    PCA9685_Block sending;      // The channels of the transfer in flight
+    uint8_t tx_data[4 * PCA9685_NUM_CHANNELS];
+
+    // Shadow of the LEDn registers: channels whose bit is set in shadow_valid are
+    // known to hold ON = 0, OFF = shadow_off. A block is trimmed to the contiguous
+    // range of channels that differ, and skipped when none do.
+    uint16_t shadow_off[PCA9685_NUM_CHANNELS];
+    uint16_t shadow_valid;
+    // Called from the I2C interrupt when a block has been written (ok) or failed
+    void (*block_done)(struct PCA9685_HandleTypeDef *pca, bool ok);
+    uint32_t blocks_written;
+    uint32_t blocks_coalesced;  // Requests replaced by a newer one before being sent
+    uint32_t blocks_skipped;    // Requests that matched the shadow, nothing sent
+    uint32_t block_errors;
 } PCA9685_HandleTypeDef;
 
 bool PCA9685_Init(PCA9685_HandleTypeDef *pca, I2C_HandleTypeDef *hi2c, uint8_t address, float freq);
 bool PCA9685_SetPWM(PCA9685_HandleTypeDef *pca, uint8_t channel, uint16_t on, uint16_t off);
 bool PCA9685_SetServoAngle(PCA9685_HandleTypeDef *pca, uint8_t channel, uint8_t angle);
+uint16_t PCA9685_AngleToPulse(uint8_t angle);
+// Queues LEDn_ON/OFF for 'count' channels from first_channel as one auto-increment
+// burst over I2C DMA and returns without waiting. Only the range of channels that
+// differ from the shadow registers is sent. Returns false if the request is invalid
+// or the transfer could not be started.
+bool PCA9685_SetPWMBlock(PCA9685_HandleTypeDef *pca, uint8_t first_channel, const uint16_t *off,
+                         uint8_t count);
+// Hook for HAL_I2C_MemTxCpltCallback / HAL_I2C_ErrorCallback of pca->hi2c
+void PCA9685_BlockComplete(PCA9685_HandleTypeDef *pca, bool ok);
 bool PCA9685_Sleep(PCA9685_HandleTypeDef *pca, bool sleep);
 bool PCA9685_Reset(PCA9685_HandleTypeDef *pca);
 
@@ -5,9 +5,12 @@ ADC_HandleTypeDef hadc1;
 UART_HandleTypeDef huart1;
 DMA_HandleTypeDef hdma_adc1;
 DMA_HandleTypeDef hdma_tim2_ch2_ch4;
+DMA_HandleTypeDef hdma_i2c1_tx;
+DMA_HandleTypeDef hdma_usart1_tx;
 TIM_HandleTypeDef htim2;
 I2C_HandleTypeDef hi2c1;
 TIM_HandleTypeDef htim3;
+TIM_HandleTypeDef htim4;
 
 void MX_I2C1_Init(void)
 {
@@ -42,6 +45,32 @@ void HAL_I2C_MspInit(I2C_HandleTypeDef *hi2c)
 
         G.Pin = GPIO_PIN_8 | GPIO_PIN_9; // PB8 SCL, PB9 SDA
         HAL_GPIO_Init(GPIOB, &G);
+
+        // I2C1_TX on DMA1 Stream6 Channel1 for the PCA9685 pose bursts
+        __HAL_RCC_DMA1_CLK_ENABLE();
+        hdma_i2c1_tx.Instance = DMA1_Stream6;
+        hdma_i2c1_tx.Init.Channel = DMA_CHANNEL_1;
+        hdma_i2c1_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+        hdma_i2c1_tx.Init.PeriphInc = DMA_PINC_DISABLE;
+        hdma_i2c1_tx.Init.MemInc = DMA_MINC_ENABLE;
+        hdma_i2c1_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+        hdma_i2c1_tx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+        hdma_i2c1_tx.Init.Mode = DMA_NORMAL;
+        hdma_i2c1_tx.Init.Priority = DMA_PRIORITY_LOW;
+        hdma_i2c1_tx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+        if (HAL_DMA_Init(&hdma_i2c1_tx) != HAL_OK)
+        {
+            Error_Handler();
+        }
+        __HAL_LINKDMA(hi2c, hdmatx, hdma_i2c1_tx);
+
+        // Below the ADC DMA (priority 0) so sampling is never delayed
+        HAL_NVIC_SetPriority(DMA1_Stream6_IRQn, 2, 0);
+        HAL_NVIC_EnableIRQ(DMA1_Stream6_IRQn);
+        HAL_NVIC_SetPriority(I2C1_EV_IRQn, 2, 0);
+        HAL_NVIC_EnableIRQ(I2C1_EV_IRQn);
+        HAL_NVIC_SetPriority(I2C1_ER_IRQn, 2, 0);
+        HAL_NVIC_EnableIRQ(I2C1_ER_IRQn);
     }
 }
 
@@ -137,6 +166,29 @@ void HAL_UART_MspInit(UART_HandleTypeDef *huart)
         GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
         GPIO_InitStruct.Alternate = GPIO_AF7_USART1;
         HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+
+        // USART1_TX on DMA2 Stream7 Channel4 for telemetry
+        __HAL_RCC_DMA2_CLK_ENABLE();
+        hdma_usart1_tx.Instance = DMA2_Stream7;
+        hdma_usart1_tx.Init.Channel = DMA_CHANNEL_4;
+        hdma_usart1_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+        hdma_usart1_tx.Init.PeriphInc = DMA_PINC_DISABLE;
+        hdma_usart1_tx.Init.MemInc = DMA_MINC_ENABLE;
+        hdma_usart1_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+        hdma_usart1_tx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+        hdma_usart1_tx.Init.Mode = DMA_NORMAL;
+        hdma_usart1_tx.Init.Priority = DMA_PRIORITY_LOW;
+        hdma_usart1_tx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+        if (HAL_DMA_Init(&hdma_usart1_tx) != HAL_OK)
+        {
+            Error_Handler();
+        }
+        __HAL_LINKDMA(huart, hdmatx, hdma_usart1_tx);
+
+        HAL_NVIC_SetPriority(DMA2_Stream7_IRQn, 1, 0);
+        HAL_NVIC_EnableIRQ(DMA2_Stream7_IRQn);
+        HAL_NVIC_SetPriority(USART1_IRQn, 1, 0);
+        HAL_NVIC_EnableIRQ(USART1_IRQn);
     }
 }
 
@@ -229,14 +281,16 @@ void MX_DMA_Init(void)
 void MX_TIM2_Init(void) {}
 
 void MX_TIM3_Init(void) {
-    // Timer for 2000Hz ADC triggering
+    // ADC1 scan trigger (TRGO) at ADC_SCAN_RATE_HZ. The timer counts at PCLK1 (APB1 is
+    // undivided), so at 50MHz the 16-bit period covers scan rates down to 763Hz and
+    // the rounding keeps the rate within 0.05% of the target up to ADC_DECIM_MAX_FACTOR.
     TIM_ClockConfigTypeDef sClockSourceConfig = {0};
     TIM_MasterConfigTypeDef sMasterConfig = {0};
 
     htim3.Instance = TIM3;
-    htim3.Init.Prescaler = 84 - 1;  // 84MHz/84 = 1MHz timer clock
+    htim3.Init.Prescaler = 0;
     htim3.Init.CounterMode = TIM_COUNTERMODE_UP;
-    htim3.Init.Period = 500 - 1;    // 1MHz/500 = 2000Hz
+    htim3.Init.Period = (HAL_RCC_GetPCLK1Freq() + ADC_SCAN_RATE_HZ / 2) / ADC_SCAN_RATE_HZ - 1;
     htim3.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
     htim3.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_ENABLE;
     
@@ -256,8 +310,35 @@ void MX_TIM3_Init(void) {
     }
 }
 
+void MX_TIM4_Init(void) {
+    // Servo frame tick (EVT_SERVO_TICK) at the PCA9685 PWM rate. APB1 is undivided,
+    // so the timer clock is PCLK1; count at 10kHz.
+    TIM_ClockConfigTypeDef sClockSourceConfig = {0};
+
+    htim4.Instance = TIM4;
+    htim4.Init.Prescaler = HAL_RCC_GetPCLK1Freq() / 10000 - 1;
+    htim4.Init.CounterMode = TIM_COUNTERMODE_UP;
+    htim4.Init.Period = 10000 / SERVO_FRAME_HZ - 1;
+    htim4.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+    htim4.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_ENABLE;
+
+    if (HAL_TIM_Base_Init(&htim4) != HAL_OK) {
+        Error_Handler();
+    }
+
+    sClockSourceConfig.ClockSource = TIM_CLOCKSOURCE_INTERNAL;
+    if (HAL_TIM_ConfigClockSource(&htim4, &sClockSourceConfig) != HAL_OK) {
+        Error_Handler();
+    }
+}
+
 void HAL_TIM_Base_MspInit(TIM_HandleTypeDef* htim_base) {
     if (htim_base->Instance == TIM3) {
         __HAL_RCC_TIM3_CLK_ENABLE();
+    } else if (htim_base->Instance == TIM4) {
+        __HAL_RCC_TIM4_CLK_ENABLE();
+        // Lowest priority: the tick only posts an event
+        HAL_NVIC_SetPriority(TIM4_IRQn, 3, 0);
+        HAL_NVIC_EnableIRQ(TIM4_IRQn);
     }
 }
\ No newline at end of file
@@ -17,6 +17,7 @@ void MX_DMA_Init(void);
 void MX_ADC1_Init(void);
 void MX_TIM2_Init(void);
 void MX_TIM3_Init(void);
+void MX_TIM4_Init(void);
 void MX_I2C1_Init(void);
 
 #ifdef __cplusplus
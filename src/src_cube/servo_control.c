@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include <math.h>
 #include "main.h" 
+#include "events.h"
 
 extern I2C_HandleTypeDef hi2c1;
 PCA9685_HandleTypeDef pca9685;
@@ -9,24 +10,59 @@ PCA9685_HandleTypeDef pca9685;
 void InitAllServos(void) {
     printf("Initializing PCA9685...\r\n");
     
-    // Initialize PCA9685 with 50Hz frequency
-    if (!PCA9685_Init(&pca9685, &hi2c1, PCA9685_I2C_ADDRESS, 50.0f)) {
+    // Initialize PCA9685 with the 50Hz servo frame
+    if (!PCA9685_Init(&pca9685, &hi2c1, PCA9685_I2C_ADDRESS, (float)SERVO_FRAME_HZ)) {
         printf("PCA9685 initialization failed!\r\n");
         return;
     }
     
     printf("PCA9685 initialized successfully\r\n");
     
-    SetServo1Angle(20);
-    SetServo2Angle(20);
-    SetServo3Angle(20);
-    SetServo4Angle(20);
-    SetServo5Angle(20);
+    SetServo1Angle(SERVO_REST_ANGLE);
+    SetServo2Angle(SERVO_REST_ANGLE);
+    SetServo3Angle(SERVO_REST_ANGLE);
+    SetServo4Angle(SERVO_REST_ANGLE);
+    SetServo5Angle(SERVO_REST_ANGLE);
     
     HAL_Delay(1000);
     printf("Servos initialized to rest position\r\n");
 }
 
+void ClampHandPose(HandPose* pose) {
+    static const uint8_t min_angle[SERVO_COUNT] = { SERVO1_MIN, SERVO2_MIN, SERVO3_MIN, SERVO4_MIN, SERVO5_MIN };
+    static const uint8_t max_angle[SERVO_COUNT] = { SERVO1_MAX, SERVO2_MAX, SERVO3_MAX, SERVO4_MAX, SERVO5_MAX };
+
+    for (int i = 0; i < SERVO_COUNT; i++) {
+        pose->angle[i] = CLAMP_ANGLE(pose->angle[i], min_angle[i], max_angle[i]);
+    }
+}
+
+bool SetHandPose(const HandPose* pose) {
+    HandPose clamped = *pose;
+    uint16_t pulse[SERVO_COUNT];
+
+    ClampHandPose(&clamped);
+    for (int i = 0; i < SERVO_COUNT; i++) {
+        pulse[i] = PCA9685_AngleToPulse(clamped.angle[i]);
+    }
+    return PCA9685_SetPWMBlock(&pca9685, SERVO_THUMB_CHANNEL, pulse, SERVO_COUNT);
+}
+
+// Completion of the pose bursts started by SetHandPose()
+void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c) {
+    if (hi2c == pca9685.hi2c) {
+        PCA9685_BlockComplete(&pca9685, true);
+        events_post(EVT_SERVO_DONE);
+    }
+}
+
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c) {
+    if (hi2c == pca9685.hi2c) {
+        PCA9685_BlockComplete(&pca9685, false);
+        events_post(EVT_SERVO_DONE);
+    }
+}
+
 // Individual servo angle setting with your optimized clamping
 void SetServo1Angle(uint8_t angle) {
     angle = CLAMP_ANGLE(angle, SERVO1_MIN, SERVO1_MAX);
@@ -128,56 +164,38 @@ void SetAllServosNormalized(uint8_t normalized_angle) {
 
 void OpenHand(void) {
     printf("Gesture: Open Hand\r\n");
-    SetServo1Angle(SERVO1_OPEN);    
-    SetServo2Angle(SERVO2_OPEN); 
-    SetServo3Angle(SERVO3_OPEN);  
-    SetServo4Angle(SERVO4_OPEN);  
-    SetServo5Angle(SERVO5_OPEN);   
+    const HandPose pose = { { SERVO1_OPEN, SERVO2_OPEN, SERVO3_OPEN, SERVO4_OPEN, SERVO5_OPEN } };
+    SetHandPose(&pose);
 }
 
 void HalfGrip(void) {
     printf("Gesture: Half Grip\r\n");
-    SetServo2Angle(SERVO2_HALF);     
-    SetServo1Angle(SERVO1_HALF);     
-    SetServo3Angle(SERVO3_HALF);     
-    SetServo4Angle(SERVO4_HALF);     
-    SetServo5Angle(SERVO5_HALF);     
+    const HandPose pose = { { SERVO1_HALF, SERVO2_HALF, SERVO3_HALF, SERVO4_HALF, SERVO5_HALF } };
+    SetHandPose(&pose);
 }
 
 void CloseHand(void) {
     printf("Gesture: Close Hand/Fist\r\n");
-    SetServo1Angle(SERVO1_CLOSED);   
-    SetServo2Angle(SERVO2_CLOSED);  
-    SetServo3Angle(SERVO3_CLOSED);   
-    SetServo4Angle(SERVO4_CLOSED);  
-    SetServo5Angle(SERVO5_CLOSED);  
+    const HandPose pose = { { SERVO1_CLOSED, SERVO2_CLOSED, SERVO3_CLOSED, SERVO4_CLOSED, SERVO5_CLOSED } };
+    SetHandPose(&pose);
 }
 
 void FourClosedThumbOpen(void) {
     printf("Gesture: 4 Fingers Closed, Thumb Open\r\n");
-    SetServo1Angle(SERVO1_OPEN);     
-    SetServo2Angle(SERVO2_CLOSED);   
-    SetServo3Angle(SERVO3_CLOSED);   
-    SetServo4Angle(SERVO4_CLOSED);   
-    SetServo5Angle(SERVO5_CLOSED);   
+    const HandPose pose = { { SERVO1_OPEN, SERVO2_CLOSED, SERVO3_CLOSED, SERVO4_CLOSED, SERVO5_CLOSED } };
+    SetHandPose(&pose);
 }
 
 void PointGesture(void) {
     printf("Gesture: Point (Index extended)\r\n");
-    SetServo1Angle(SERVO1_CLOSED);   
-    SetServo2Angle(SERVO2_OPEN);    
-    SetServo3Angle(SERVO3_CLOSED);   
-    SetServo4Angle(SERVO4_CLOSED);   
-    SetServo5Angle(SERVO5_CLOSED);   
+    const HandPose pose = { { SERVO1_CLOSED, SERVO2_OPEN, SERVO3_CLOSED, SERVO4_CLOSED, SERVO5_CLOSED } };
+    SetHandPose(&pose);
 }
 
 void OKGesture(void) {
     printf("Gesture: OK (Thumb and index making a circle)\r\n");
-    SetServo1Angle(60);             
-    SetServo2Angle(60);             
-    SetServo3Angle(SERVO3_CLOSED);  
-    SetServo4Angle(SERVO4_CLOSED);   
-    SetServo5Angle(SERVO5_CLOSED);  
+    const HandPose pose = { { 60, 60, SERVO3_CLOSED, SERVO4_CLOSED, SERVO5_CLOSED } };
+    SetHandPose(&pose);
 }
 
 void TestServoSequence(void) {
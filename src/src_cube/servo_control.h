@@ -45,6 +45,22 @@ extern "C" {
 #define CLAMP_ANGLE(angle, min, max) \
     ((angle) < (min) ? (min) : ((angle) > (max) ? (max) : (angle)))
 
+// Servo channels 0..4 are consecutive, so a whole hand is one PCA9685 block
+#define SERVO_COUNT 5
+
+// PCA9685 PWM frame rate; the outputs change at most once per frame, so finger
+// trajectories (servo_motion.c) are stepped at the same rate
+#define SERVO_FRAME_HZ 50
+#define SERVO_FRAME_MS (1000 / SERVO_FRAME_HZ)
+
+// All fingers slightly bent: start-up and REST
+#define SERVO_REST_ANGLE 20
+
+// Angles in the order of the channels: thumb, index, middle, ring, pinky
+typedef struct {
+    uint8_t angle[SERVO_COUNT];
+} HandPose;
+
 void InitAllServos(void);
 void SetServo1Angle(uint8_t angle);
 void SetServo2Angle(uint8_t angle);
@@ -59,6 +75,12 @@ void SetServo4Normalized(uint8_t normalized_angle);
 void SetServo5Normalized(uint8_t normalized_angle);
 void SetAllServosNormalized(uint8_t normalized_angle);  
 
+// Limits each finger to its SERVOn_MIN..SERVOn_MAX range in place
+void ClampHandPose(HandPose* pose);
+// Clamps each finger to its range and queues all five in one non-blocking I2C burst.
+// If the previous pose is still being sent, only the latest queued pose follows it.
+bool SetHandPose(const HandPose* pose);
+
 void OpenHand(void);
 void CloseHand(void);
 void HalfGrip(void);
@@ -0,0 +1,112 @@
+#include "servo_motion.h"
+#include "events.h"
+#include <math.h>
+#include <string.h>
+
+// Below this distance and speed a finger counts as arrived and snaps to the target
+#define ARRIVE_DEG 0.5f
+
+ServoMotion servo_motion;
+
+void servo_motion_init(ServoMotion* motion, const ServoMotionConfig* config, const HandPose* start) {
+    static const ServoMotionConfig defaults = SERVO_MOTION_DEFAULTS;
+    memset(motion, 0, sizeof(*motion));
+    motion->config = config ? *config : defaults;
+    motion->output = *start;
+    ClampHandPose(&motion->output);
+    for (int i = 0; i < SERVO_COUNT; i++) {
+        motion->position[i] = motion->output.angle[i];
+        motion->target[i] = motion->output.angle[i];
+    }
+}
+
+static bool finger_idle(const ServoMotion* motion, int i) {
+    return motion->velocity[i] == 0.0f && motion->start_delay[i] == 0
+           && fabsf(motion->position[i] - motion->target[i]) < ARRIVE_DEG;
+}
+
+void servo_motion_set_target(ServoMotion* motion, const HandPose* target) {
+    HandPose pose = *target;
+    ClampHandPose(&pose);
+    uint32_t stagger_frames = (uint32_t)motion->config.stagger_ms * SERVO_FRAME_HZ / 1000;
+    uint32_t slot = 0;
+
+    for (int i = 0; i < SERVO_COUNT; i++) {
+        if (pose.angle[i] == motion->target[i]) {
+            continue;
+        }
+        // Moving fingers are re-planned on the next frame; only fingers at rest
+        // draw a start slot, so a pre-empted motion is never paused
+        if (finger_idle(motion, i)) {
+            uint32_t delay = slot++ * stagger_frames;
+            motion->start_delay[i] = (uint8_t)(delay < UINT8_MAX ? delay : UINT8_MAX);
+        }
+        motion->target[i] = pose.angle[i];
+    }
+}
+
+static void move_finger(ServoMotion* motion, int i, float dt) {
+    const float accel = motion->config.accel;
+    float error = motion->target[i] - motion->position[i];
+    float v = motion->velocity[i];
+
+    if (fabsf(error) < ARRIVE_DEG && fabsf(v) <= accel * dt) {
+        motion->position[i] = motion->target[i];
+        motion->velocity[i] = 0.0f;
+        return;
+    }
+
+    // Fastest speed that can still stop on the target, capped by the finger's limit
+    float v_stop = sqrtf(2.0f * accel * fabsf(error));
+    float v_max = motion->config.max_speed[i];
+    float v_want = copysignf(v_stop < v_max ? v_stop : v_max, error);
+    float dv = v_want - v;
+    float dv_max = accel * dt;
+    v += dv > dv_max ? dv_max : (dv < -dv_max ? -dv_max : dv);
+
+    float step = v * dt;
+    // Snap instead of overshooting on the last frame of the approach
+    if ((error > 0.0f && step >= error) || (error < 0.0f && step <= error)) {
+        motion->position[i] = motion->target[i];
+        motion->velocity[i] = 0.0f;
+        return;
+    }
+    motion->position[i] += step;
+    motion->velocity[i] = v;
+}
+
+bool servo_motion_tick(ServoMotion* motion, HandPose* pose) {
+    const float dt = 1.0f / SERVO_FRAME_HZ;
+    bool changed = false;
+
+    motion->frames++;
+    for (int i = 0; i < SERVO_COUNT; i++) {
+        if (motion->start_delay[i] > 0) {
+            motion->start_delay[i]--;
+            continue;
+        }
+        move_finger(motion, i, dt);
+        uint8_t angle = (uint8_t)lrintf(motion->position[i]);
+        if (angle != motion->output.angle[i]) {
+            motion->output.angle[i] = angle;
+            changed = true;
+        }
+    }
+    *pose = motion->output;
+    return changed;
+}
+
+int servo_motion_active(const ServoMotion* motion) {
+    int active = 0;
+    for (int i = 0; i < SERVO_COUNT; i++) {
+        active += finger_idle(motion, i) ? 0 : 1;
+    }
+    return active;
+}
+
+// TIM4 update, one per PWM frame (MX_TIM4_Init)
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef* htim) {
+    if (htim->Instance == TIM4) {
+        events_post(EVT_SERVO_TICK);
+    }
+}
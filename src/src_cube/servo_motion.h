@@ -0,0 +1,53 @@
+#ifndef SERVO_MOTION_H
+#define SERVO_MOTION_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "servo_control.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+// Finger trajectories. A new pose only sets the targets; every PWM frame (TIM4 at
+// SERVO_FRAME_HZ posts EVT_SERVO_TICK) each finger moves toward its target with a
+// trapezoidal velocity profile: accelerate up to its speed limit, brake so it stops
+// on the target. Fingers that start from standstill are started stagger_ms apart in
+// channel order, so the five stall currents do not add up. A target change while
+// fingers are moving re-plans from the current position and velocity (pre-emption):
+// the finger brakes and reverses instead of jumping.
+typedef struct {
+    float max_speed[SERVO_COUNT];  // deg/s, thumb first
+    float accel;                   // deg/s^2, used for speeding up and braking
+    uint16_t stagger_ms;           // Start offset between fingers leaving standstill
+} ServoMotionConfig;
+
+#define SERVO_MOTION_DEFAULTS { { 300.0f, 450.0f, 450.0f, 450.0f, 450.0f }, 3000.0f, 60 }
+
+typedef struct {
+    ServoMotionConfig config;
+    float position[SERVO_COUNT];   // deg
+    float velocity[SERVO_COUNT];   // deg/s, signed
+    uint8_t target[SERVO_COUNT];   // Clamped to each finger's range
+    uint8_t start_delay[SERVO_COUNT];  // Frames until the finger may start
+    HandPose output;               // Last pose returned by servo_motion_tick
+    uint32_t frames;
+} ServoMotion;
+
+// The hand driven by the firmware (execute_gesture, main loop)
+extern ServoMotion servo_motion;
+
+// config may be NULL for SERVO_MOTION_DEFAULTS; start is the pose the servos are at
+void servo_motion_init(ServoMotion* motion, const ServoMotionConfig* config, const HandPose* start);
+// New target pose; takes effect on the next frame
+void servo_motion_set_target(ServoMotion* motion, const HandPose* target);
+// Advances one frame. Returns true and the pose to send when a rounded angle changed.
+bool servo_motion_tick(ServoMotion* motion, HandPose* pose);
+// Fingers that are moving or waiting for their staggered start
+int servo_motion_active(const ServoMotion* motion);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SERVO_MOTION_H
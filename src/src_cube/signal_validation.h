@@ -1,8 +1,10 @@
 #ifndef SIGNAL_VALIDATION_H
 #define SIGNAL_VALIDATION_H
 
+#include <stdint.h>
 #include <stdbool.h>
 #include <math.h>
+#include "emg_classifier.h"
 
 // Based on your new data statistics
 #define CH1_MIN_VALID 500   // flexor carpi radialis minimum
@@ -11,7 +13,7 @@
 #define CH4_MAX_VALID 1300  // flexor digitorum superficialis maximum
 
 // Check if raw ADC values are valid based on new data ranges
-bool is_valid_signal_range(uint16_t ch1, uint16_t ch2, uint16_t ch3, uint16_t ch4) {
+static inline bool is_valid_signal_range(uint16_t ch1, uint16_t ch2, uint16_t ch3, uint16_t ch4) {
     // Check each channel is within expected range
     if (ch1 < CH1_MIN_VALID || ch1 > CH1_MAX_VALID) return false;
     if (ch4 < CH4_MIN_VALID || ch4 > CH4_MAX_VALID) return false;
@@ -24,10 +26,10 @@ bool is_valid_signal_range(uint16_t ch1, uint16_t ch2, uint16_t ch3, uint16_t ch
 }
 
 // Check if features are valid before classification
-bool are_features_valid(const float* features) {
-    // Check MAV values (features 0, 5, 10, 15)
+static inline bool are_features_valid(const float* features) {
+    // Check MAV values (the first feature of each channel)
     float ch1_mav = features[0];
-    float ch4_mav = features[15];
+    float ch4_mav = features[3 * FEATURES_PER_CHANNEL];
     
     // Convert MAV to approximate ADC range
     // MAV ~= average absolute value, so multiply by ~1.5 for max range
@@ -44,4 +46,59 @@ bool are_features_valid(const float* features) {
     return true;
 }
 
+// Integer form of are_features_valid() for the fixed-point path:
+// MAV * 1.5 in [min, max]  <=>  3 * sum|x| in [2 * N * min, 2 * N * max]
+static inline bool are_window_sums_valid(const EMG_ChannelSums* sums) {
+    int32_t ch1 = 3 * sums[0].sum_abs;
+    int32_t ch4 = 3 * sums[3].sum_abs;
+
+    if (ch1 < 2 * WINDOW_SIZE * CH1_MIN_VALID || ch1 > 2 * WINDOW_SIZE * CH1_MAX_VALID) {
+        return false;
+    }
+    if (ch4 < 2 * WINDOW_SIZE * CH4_MIN_VALID || ch4 > 2 * WINDOW_SIZE * CH4_MAX_VALID) {
+        return false;
+    }
+
+    return true;
+}
+
+#if EMG_PREFILTER
+// The prefilter removes the electrode offset these ranges were drawn from, so the
+// filtered features no longer carry it. The raw window MAV is the offset, which the
+// filter tracks as the input level: level * 1.5 in [min, max], in Q EMG_FILTER_Q_GUARD.
+static inline bool is_input_level_valid(const EmgFilter* filter) {
+    int32_t ch1 = 3 * filter->level[0];
+    int32_t ch4 = 3 * filter->level[3];
+
+    if (ch1 < (2 * CH1_MIN_VALID << EMG_FILTER_Q_GUARD) || ch1 > (2 * CH1_MAX_VALID << EMG_FILTER_Q_GUARD)) {
+        return false;
+    }
+    if (ch4 < (2 * CH4_MIN_VALID << EMG_FILTER_Q_GUARD) || ch4 > (2 * CH4_MAX_VALID << EMG_FILTER_Q_GUARD)) {
+        return false;
+    }
+    return true;
+}
+#endif
+
+// The check for the window in buffer: its float features, or the input level when
+// the window is prefiltered
+static inline bool is_window_valid(const EMG_Buffer* buffer, const float* features) {
+#if EMG_PREFILTER
+    (void)features;
+    return is_input_level_valid(&buffer->filter);
+#else
+    (void)buffer;
+    return are_features_valid(features);
+#endif
+}
+
+// Fixed-point form of is_window_valid()
+static inline bool is_window_valid_q(const EMG_Buffer* buffer) {
+#if EMG_PREFILTER
+    return is_input_level_valid(&buffer->filter);
+#else
+    return are_window_sums_valid(buffer->sums);
+#endif
+}
+
 #endif // SIGNAL_VALIDATION_H
\ No newline at end of file
@@ -0,0 +1,159 @@
+#include "telemetry.h"
+#include "events.h"
+#include <string.h>
+
+static UART_HandleTypeDef *tx_uart = NULL;
+
+// Double buffer: tx_fill is being appended to, the other half may be on the wire
+static uint8_t tx_buffer[2][TELEMETRY_TX_BUFFER_BYTES];
+static uint8_t tx_fill = 0;
+static uint16_t tx_fill_len = 0;
+static volatile bool tx_busy = false;
+
+// Frame being assembled
+static uint8_t frame[TELEMETRY_FRAME_BYTES];
+static uint8_t frame_count = 0;
+static uint16_t frame_seq = 0;
+static uint32_t sample_index = 0;
+static uint8_t frame_gesture = 0;
+
+static TelemetryStats stats;
+
+void telemetry_init(UART_HandleTypeDef *huart) {
+    tx_uart = huart;
+    tx_fill = 0;
+    tx_fill_len = 0;
+    tx_busy = false;
+    frame_count = 0;
+    frame_seq = 0;
+    sample_index = 0;
+    memset(&stats, 0, sizeof(stats));
+}
+
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF), four bits at a time
+uint16_t telemetry_crc16(const uint8_t *data, uint32_t len) {
+    static const uint16_t table[16] = {
+        0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+        0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+    };
+    uint16_t crc = 0xFFFF;
+    for (uint32_t i = 0; i < len; i++) {
+        crc = (uint16_t)((crc << 4) ^ table[(crc >> 12) ^ (data[i] >> 4)]);
+        crc = (uint16_t)((crc << 4) ^ table[(crc >> 12) ^ (data[i] & 0x0F)]);
+    }
+    return crc;
+}
+
+// Hands the filled half to the DMA; called with interrupts masked or from the TX IRQ
+static void start_transmit(void) {
+    uint8_t *data = tx_buffer[tx_fill];
+    uint16_t len = tx_fill_len;
+    tx_fill ^= 1;
+    tx_fill_len = 0;
+    tx_busy = true;
+    stats.dma_starts++;
+    if (HAL_UART_Transmit_DMA(tx_uart, data, len) != HAL_OK) {
+        tx_busy = false;
+    }
+}
+
+static bool enqueue(const uint8_t *data, uint16_t len) {
+    bool queued = false;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (tx_uart != NULL && tx_fill_len + len <= TELEMETRY_TX_BUFFER_BYTES) {
+        memcpy(&tx_buffer[tx_fill][tx_fill_len], data, len);
+        tx_fill_len += len;
+        queued = true;
+        if (!tx_busy) {
+            start_transmit();
+        }
+    }
+    __set_PRIMASK(primask);
+    return queued;
+}
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart) {
+    if (huart != tx_uart) {
+        return;
+    }
+    tx_busy = false;
+    if (tx_fill_len > 0) {
+        start_transmit();
+    }
+    events_post(EVT_UART_TX_DONE);
+}
+
+void telemetry_uart_error(UART_HandleTypeDef *huart) {
+    // Receive errors leave a running transmit alone; only a TX that has ended
+    // (gState back to READY) is written off and the pending half sent instead
+    if (huart != tx_uart || !tx_busy || huart->gState != HAL_UART_STATE_READY) {
+        return;
+    }
+    tx_busy = false;
+    stats.tx_errors++;
+    if (tx_fill_len > 0) {
+        start_transmit();
+    }
+    events_post(EVT_UART_TX_DONE);
+}
+
+static void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+void telemetry_flush(void) {
+    if (frame_count == 0) {
+        return;
+    }
+    uint16_t len = TELEMETRY_HEADER_BYTES + frame_count * TELEMETRY_SAMPLE_BYTES;
+    uint32_t first = sample_index - frame_count;
+
+    frame[0] = TELEMETRY_SYNC0;
+    frame[1] = TELEMETRY_SYNC1;
+    put_u16(&frame[2], frame_seq);
+    put_u16(&frame[4], first & 0xFFFF);
+    put_u16(&frame[6], first >> 16);
+    frame[8] = frame_count;
+    frame[9] = frame_gesture;
+    put_u16(&frame[len], telemetry_crc16(&frame[2], len - 2));
+
+    if (enqueue(frame, len + 2)) {
+        stats.frames_sent++;
+    } else {
+        stats.frames_dropped++;
+    }
+    frame_seq++;
+    frame_count = 0;
+}
+
+void telemetry_push_sample(const uint16_t sample[ADC_CHANNELS], uint8_t gesture) {
+    uint8_t *p = &frame[TELEMETRY_HEADER_BYTES + frame_count * TELEMETRY_SAMPLE_BYTES];
+    for (int ch = 0; ch < ADC_CHANNELS; ch += 2) {
+        uint16_t a = sample[ch] & 0x0FFF;
+        uint16_t b = sample[ch + 1] & 0x0FFF;
+        *p++ = a & 0xFF;
+        *p++ = (uint8_t)((a >> 8) | ((b & 0x0F) << 4));
+        *p++ = (uint8_t)(b >> 4);
+    }
+    frame_gesture = gesture;
+    frame_count++;
+    sample_index++;
+
+    if (frame_count == TELEMETRY_SAMPLES_PER_FRAME) {
+        telemetry_flush();
+    }
+}
+
+bool telemetry_write(const uint8_t *data, uint16_t len) {
+    if (!enqueue(data, len)) {
+        stats.bytes_dropped += len;
+        return false;
+    }
+    return true;
+}
+
+const TelemetryStats* telemetry_get_stats(void) {
+    return &stats;
+}
@@ -0,0 +1,67 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f4xx_hal.h"
+#include "common_defs.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+// 1: every ADC frame goes out in binary telemetry frames (ml/decode_telemetry.py).
+// 0: the old 10Hz "S1,S2,S3,S4:G" text lines.
+#ifndef TELEMETRY_BINARY
+#define TELEMETRY_BINARY 1
+#endif
+
+// Frame layout, little-endian:
+//   0  sync        0xA5 0x5A
+//   2  seq         uint16, +1 per frame (also for frames dropped on a full queue)
+//   4  sample      uint32, index of the first sample since start
+//   8  count       uint8, samples in this frame (1..TELEMETRY_SAMPLES_PER_FRAME)
+//   9  gesture     uint8, current gesture when the frame was closed
+//  10  samples     count x 6 bytes, 4 x 12-bit per sample, two channels per 3 bytes:
+//                  a[7:0], a[11:8] | b[3:0] << 4, b[11:4]
+//  ..  crc         uint16 CRC-16/CCITT-FALSE over seq..samples
+// 60 bytes per 8 samples: ~11.3 kB/s at 1500Hz, half of what 230400 baud carries.
+#define TELEMETRY_SYNC0 0xA5
+#define TELEMETRY_SYNC1 0x5A
+#define TELEMETRY_SAMPLES_PER_FRAME 8
+#define TELEMETRY_HEADER_BYTES 10
+#define TELEMETRY_SAMPLE_BYTES 6
+#define TELEMETRY_FRAME_BYTES \
+    (TELEMETRY_HEADER_BYTES + TELEMETRY_SAMPLES_PER_FRAME * TELEMETRY_SAMPLE_BYTES + 2)
+
+// Each half of the TX double buffer. While one half is on the wire the other fills;
+// 2048 bytes is ~34 frames, enough for the burst after a 200ms main loop stall.
+#define TELEMETRY_TX_BUFFER_BYTES 2048
+
+typedef struct {
+    uint32_t frames_sent;    // Frames queued for the UART
+    uint32_t frames_dropped; // Frames lost to a full TX buffer (seq still advances)
+    uint32_t bytes_dropped;  // Text bytes lost to a full TX buffer
+    uint32_t dma_starts;     // HAL_UART_Transmit_DMA calls
+    uint32_t tx_errors;      // Transfers ended by a UART/DMA error (their half is lost)
+} TelemetryStats;
+
+void telemetry_init(UART_HandleTypeDef *huart);
+// Adds one ADC frame; a telemetry frame is queued every TELEMETRY_SAMPLES_PER_FRAME calls
+void telemetry_push_sample(const uint16_t sample[ADC_CHANNELS], uint8_t gesture);
+// Queues the partially filled frame, if any
+void telemetry_flush(void);
+// Queues raw bytes (log text) between frames; never blocks. Returns false if dropped.
+bool telemetry_write(const uint8_t *data, uint16_t len);
+const TelemetryStats* telemetry_get_stats(void);
+// From HAL_UART_ErrorCallback: frees the TX side after a failed transfer and starts
+// the half that filled meanwhile, so one error does not stop the telemetry
+void telemetry_uart_error(UART_HandleTypeDef *huart);
+
+uint16_t telemetry_crc16(const uint8_t *data, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TELEMETRY_H
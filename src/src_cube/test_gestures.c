@@ -1,5 +1,6 @@
 #include "gesture.h"
 #include "servo_control.h"
+#include "servo_motion.h"
 #include "main.h"
 #include <stdio.h>
 
@@ -44,7 +45,14 @@ void test_all_gestures(void) {
         HAL_UART_Transmit(&huart1, (uint8_t*)buffer, len, 100);
         
         execute_gesture(gestures[i]);
-        HAL_Delay(2000);
+        // The main loop is not running, so step the trajectory here
+        for (int t = 0; t < 2000; t += SERVO_FRAME_MS) {
+            HandPose pose;
+            if (servo_motion_tick(&servo_motion, &pose)) {
+                SetHandPose(&pose);
+            }
+            HAL_Delay(SERVO_FRAME_MS);
+        }
     }
     
     len = sprintf(buffer, "\r\n=== Test Complete ===\r\n");
@@ -0,0 +1,141 @@
+#include "trace.h"
+#include "common_defs.h"
+#include "emg_classifier.h"
+#include "adc_acquisition.h"
+#include "telemetry.h"
+#include <stdio.h>
+#include <string.h>
+
+static TraceStageStats stage_stats[TRACE_STAGE_COUNT];
+
+static const char* stage_names[TRACE_STAGE_COUNT] = {
+    "sample", "filter", "features", "predict", "decide", "actuate", "classify", "hop", "servo",
+};
+
+uint32_t trace_ticks_per_us(void) {
+#ifdef HAL_SHIM
+    return 1000;
+#else
+    return SystemCoreClock / 1000000U;
+#endif
+}
+
+void trace_reset(void) {
+    for (int i = 0; i < TRACE_STAGE_COUNT; i++) {
+        uint32_t deadline = stage_stats[i].deadline;
+        memset(&stage_stats[i], 0, sizeof(stage_stats[i]));
+        stage_stats[i].min = UINT32_MAX;
+        stage_stats[i].deadline = deadline;
+    }
+}
+
+void trace_init(void) {
+#if EMG_TRACE && !defined(HAL_SHIM)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+    uint32_t tpu = trace_ticks_per_us();
+    stage_stats[TRACE_SAMPLE].deadline = tpu * (1000000U / SAMPLING_RATE_HZ);
+    stage_stats[TRACE_CLASSIFY].deadline = tpu * 1000U * CLASSIFY_PERIOD_MS;
+    // SysTick wakes the loop every 1ms, so the hop sample has waited at most that long
+    // before the wake-up; a late classification has to finish within another tick
+    stage_stats[TRACE_HOP].deadline = tpu * 1000U;
+    trace_reset();
+}
+
+void trace_set_deadline(TraceStage stage, uint32_t ticks) {
+    stage_stats[stage].deadline = ticks;
+}
+
+// Exact below 8, then TRACE_SUB_BUCKETS buckets per power of two
+static uint32_t bucket_index(uint32_t ticks) {
+    if (ticks < 2 * TRACE_SUB_BUCKETS) {
+        return ticks;
+    }
+    uint32_t msb = 31 - __builtin_clz(ticks);
+    uint32_t sub = (ticks >> (msb - 2)) & (TRACE_SUB_BUCKETS - 1);
+    uint32_t index = (msb - 1) * TRACE_SUB_BUCKETS + sub;
+    return index < TRACE_BUCKETS ? index : TRACE_BUCKETS - 1;
+}
+
+static uint32_t bucket_upper(uint32_t index) {
+    if (index < 2 * TRACE_SUB_BUCKETS) {
+        return index;
+    }
+    uint32_t msb = index / TRACE_SUB_BUCKETS + 1;
+    uint32_t sub = index % TRACE_SUB_BUCKETS;
+    return ((TRACE_SUB_BUCKETS + sub + 1) << (msb - 2)) - 1;
+}
+
+#if EMG_TRACE
+uint32_t trace_record(TraceStage stage, uint32_t start) {
+    uint32_t now = trace_now();
+    uint32_t ticks = now - start;
+    TraceStageStats* s = &stage_stats[stage];
+
+    s->count++;
+    s->total += ticks;
+    if (ticks < s->min) s->min = ticks;
+    if (ticks > s->max) s->max = ticks;
+    if (s->deadline != 0 && ticks > s->deadline) s->missed++;
+    s->buckets[bucket_index(ticks)]++;
+    return now;
+}
+#endif
+
+const TraceStageStats* trace_get_stats(TraceStage stage) {
+    return &stage_stats[stage];
+}
+
+static uint32_t percentile(const TraceStageStats* s, uint32_t percent) {
+    uint32_t target = (uint32_t)(((uint64_t)s->count * percent + 99) / 100);
+    uint32_t seen = 0;
+    for (uint32_t i = 0; i < TRACE_BUCKETS; i++) {
+        seen += s->buckets[i];
+        if (seen >= target) {
+            uint32_t upper = bucket_upper(i);
+            return upper < s->max ? upper : s->max;
+        }
+    }
+    return s->max;
+}
+
+// Ticks as microseconds with one decimal, without float formatting
+static int format_us(char* buf, size_t size, uint32_t ticks) {
+    uint32_t tenths = (uint32_t)((uint64_t)ticks * 10 / trace_ticks_per_us());
+    return snprintf(buf, size, "%lu.%lu", (unsigned long)(tenths / 10), (unsigned long)(tenths % 10));
+}
+
+int trace_format_report(char* buf, size_t size) {
+    size_t len = 0;
+#define APPEND(...)                                                           \
+    do {                                                                      \
+        if (len < size) {                                                     \
+            int n = snprintf(buf + len, size - len, __VA_ARGS__);             \
+            if (n > 0) len += (size_t)n;                                      \
+        }                                                                     \
+    } while (0)
+
+    APPEND("stage          count     min(us)    mean(us)     p99(us)     max(us)  missed\n");
+    for (int i = 0; i < TRACE_STAGE_COUNT; i++) {
+        const TraceStageStats* s = &stage_stats[i];
+        char min_us[16] = "-", mean_us[16] = "-", p99_us[16] = "-", max_us[16] = "-";
+        if (s->count > 0) {
+            format_us(min_us, sizeof(min_us), s->min);
+            format_us(mean_us, sizeof(mean_us), (uint32_t)(s->total / s->count));
+            format_us(p99_us, sizeof(p99_us), percentile(s, 99));
+            format_us(max_us, sizeof(max_us), s->max);
+        }
+        APPEND("%-9s %10lu %11s %11s %11s %11s %7lu\n", stage_names[i], (unsigned long)s->count,
+               min_us, mean_us, p99_us, max_us, (unsigned long)s->missed);
+    }
+
+    const ADC_AcqStats* acq = adc_acq_get_stats();
+    const TelemetryStats* tel = telemetry_get_stats();
+    APPEND("samples lost %lu, ADC overruns %lu, max backlog %lu; telemetry frames dropped %lu\n",
+           (unsigned long)acq->frames_lost, (unsigned long)acq->overruns,
+           (unsigned long)acq->max_backlog, (unsigned long)tel->frames_dropped);
+#undef APPEND
+    return (int)(len < size ? len : size - 1);
+}
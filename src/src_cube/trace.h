@@ -0,0 +1,92 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f4xx_hal.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Stage latency tracing. Ticks are DWT CYCCNT cycles on the MCU and nanoseconds on
+// the native build (std::chrono via the HAL shim). Set EMG_TRACE to 0 to compile the
+// probes out.
+#ifndef EMG_TRACE
+#define EMG_TRACE 1
+#endif
+
+typedef enum {
+    TRACE_SAMPLE = 0,   // One ADC frame into the window (and telemetry)
+    TRACE_FILTER,       // EMG_PREFILTER biquads on one frame, deadline its cycle budget
+    TRACE_FEATURES,     // emg_buffer_process_window (with EMG_SPECTRAL_FEATURES, deadline its budget)
+    TRACE_PREDICT,      // Signal validation + classify_gesture
+    TRACE_DECIDE,       // gesture_decision_push
+    TRACE_ACTUATE,      // execute_gesture
+    TRACE_CLASSIFY,     // The whole classification step, deadline CLASSIFY_PERIOD_MS
+    TRACE_HOP,          // Wake-up that saw the hop's last sample -> classification done
+    TRACE_SERVO,        // Trajectory frame sent -> PCA9685 burst completed (EVT_SERVO_DONE)
+    TRACE_STAGE_COUNT
+} TraceStage;
+
+// Log-linear histogram: 4 buckets per power of two, so p99 is reported as the upper
+// edge of its bucket (at most ~19% high). Durations beyond 2^28 ticks share the top bucket.
+#define TRACE_SUB_BUCKETS 4
+#define TRACE_BUCKETS (TRACE_SUB_BUCKETS * 27)
+
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+    uint32_t deadline;   // Ticks, 0 = none
+    uint32_t missed;     // Durations above the deadline
+    uint32_t buckets[TRACE_BUCKETS];
+} TraceStageStats;
+
+#if EMG_TRACE
+
+#ifdef HAL_SHIM
+static inline uint32_t trace_now(void) {
+    return hal_shim_trace_ticks();
+}
+#else
+static inline uint32_t trace_now(void) {
+    return DWT->CYCCNT;
+}
+#endif
+
+// Records now - start for the stage and returns now, so consecutive stages chain:
+//   uint32_t t = trace_now(); a(); t = trace_record(STAGE_A, t); b(); trace_record(STAGE_B, t);
+uint32_t trace_record(TraceStage stage, uint32_t start);
+
+#else
+
+static inline uint32_t trace_now(void) {
+    return 0;
+}
+
+static inline uint32_t trace_record(TraceStage stage, uint32_t start) {
+    (void)stage;
+    return start;
+}
+
+#endif
+
+// Starts the cycle counter and sets the stage deadlines
+void trace_init(void);
+void trace_reset(void);
+// Deadline of a stage in ticks, 0 = none; kept across trace_reset()
+void trace_set_deadline(TraceStage stage, uint32_t ticks);
+uint32_t trace_ticks_per_us(void);
+const TraceStageStats* trace_get_stats(TraceStage stage);
+// Writes the per-stage table plus acquisition and telemetry loss counters as text;
+// returns the length (truncated to size - 1)
+int trace_format_report(char* buf, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TRACE_H
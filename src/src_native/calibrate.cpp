@@ -0,0 +1,179 @@
+// Runs the on-device calibration against recordings: the first half of each gesture's
+// file plays the user following the prompts, the fitted model goes through the
+// simulated flash and back, and the second halves score it against the exported model.
+#include "host_commands.h"
+#include "recording.h"
+#include "calibration.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+struct CalibrateOptions {
+    CalibrationFit fit = CALIB_LDA;
+    int trials = 1;
+    int channels = NUM_CHANNELS;
+};
+
+// Streams frames [begin, end) of every recording of one class, wrapping around
+struct ClassSource {
+    std::vector<const Recording*> recs;
+    size_t rec = 0;
+    size_t pos = 0;
+
+    const EmgFrame& next(bool first_half) {
+        const Recording* r = recs[rec];
+        size_t half = r->frames.size() / 2;
+        size_t begin = first_half ? 0 : half;
+        size_t end = first_half ? half : r->frames.size();
+        if (pos < begin || pos >= end) {
+            pos = begin;
+        }
+        const EmgFrame& f = r->frames[pos++];
+        if (pos == end) {
+            rec = (rec + 1) % recs.size();
+            pos = 0;
+        }
+        return f;
+    }
+};
+
+// Feeds the prompted gesture's samples through the window and the calibration state
+// machine on the sample clock until every trial is collected
+static uint32_t collect(Calibration& cal, std::vector<ClassSource>& sources) {
+    static EMG_Buffer buffer;
+    emg_buffer_init(&buffer);
+    float features[TOTAL_FEATURES];
+    uint32_t samples = 0;
+    uint32_t samples_to_hop = HOP_SAMPLES;
+
+    while (cal.mode == MODE_COLLECTING) {
+        const EmgFrame& f = sources[calibration_gesture(&cal)].next(true);
+        emg_buffer_add_sample(&buffer, f.ch[0], f.ch[1], f.ch[2], f.ch[3]);
+        samples++;
+        if (--samples_to_hop > 0) {
+            continue;
+        }
+        samples_to_hop = HOP_SAMPLES;
+        if (emg_buffer_process_window(&buffer, features)) {
+            calibration_add_window(&cal, features);
+        }
+        calibration_tick(&cal, (uint32_t)((uint64_t)samples * 1000 / SAMPLING_RATE_HZ));
+    }
+    return samples;
+}
+
+// Accuracy of the active classifier on the second half of a recording, every hop
+static double score(const Recording& rec) {
+    static EMG_Buffer buffer;
+    emg_buffer_init(&buffer);
+    float features[TOTAL_FEATURES];
+    size_t windows = 0, correct = 0;
+    for (size_t i = rec.frames.size() / 2; i < rec.frames.size(); i++) {
+        const EmgFrame& f = rec.frames[i];
+        emg_buffer_add_sample(&buffer, f.ch[0], f.ch[1], f.ch[2], f.ch[3]);
+        if ((i + 1) % HOP_SAMPLES == 0 && emg_buffer_process_window(&buffer, features)) {
+            windows++;
+            correct += (int)classify_gesture(features) == rec.label ? 1 : 0;
+        }
+    }
+    return windows > 0 ? 100.0 * correct / windows : 0.0;
+}
+
+int cmd_calibrate(int argc, char** argv) {
+    CalibrateOptions opt;
+    int first = 0;
+    for (; first < argc && std::strncmp(argv[first], "--", 2) == 0; first++) {
+        if (std::strcmp(argv[first], "--fit") == 0 && first + 1 < argc) {
+            const char* fit = argv[++first];
+            opt.fit = std::strcmp(fit, "centroid") == 0 ? CALIB_CENTROID : CALIB_LDA;
+        } else if (std::strcmp(argv[first], "--trials") == 0 && first + 1 < argc) {
+            opt.trials = std::atoi(argv[++first]);
+        } else if (std::strcmp(argv[first], "--channels") == 0 && first + 1 < argc) {
+            opt.channels = std::atoi(argv[++first]);
+        } else {
+            std::fprintf(stderr, "calibrate: unknown option %s\n", argv[first]);
+            return 1;
+        }
+    }
+
+    std::vector<std::string> paths = expand_recording_paths(argc - first, argv + first);
+    std::vector<Recording> recs;
+    for (const std::string& path : paths) {
+        Recording rec;
+        if (!load_recording(path, rec)) {
+            std::fprintf(stderr, "calibrate: cannot read %s\n", path.c_str());
+            return 1;
+        }
+        if (rec.label >= 0 && rec.channels == opt.channels && rec.frames.size() >= 2 * WINDOW_SIZE) {
+            recs.push_back(std::move(rec));
+        }
+    }
+    std::vector<ClassSource> sources(NUM_CLASSES);
+    for (const Recording& rec : recs) {
+        sources[rec.label].recs.push_back(&rec);
+    }
+    for (int c = 0; c < NUM_CLASSES; c++) {
+        if (sources[c].recs.empty()) {
+            std::fprintf(stderr, "calibrate: no %d-channel recording of %s\n", opt.channels,
+                         gesture_names[c]);
+            return 1;
+        }
+    }
+
+    static Calibration cal;
+    calibration_start(&cal, (uint8_t)opt.trials, opt.fit, 0);
+    uint32_t samples = collect(cal, sources);
+    uint32_t windows = 0;
+    for (int c = 0; c < NUM_CLASSES; c++) {
+        windows += cal.windows[c];
+    }
+    std::printf("collected %u windows over %.1f s (%d trial(s) per gesture, %d ms prompt + %d ms trial)\n",
+                windows, (double)samples / SAMPLING_RATE_HZ, cal.trials, CALIB_PROMPT_MS, CALIB_TRIAL_MS);
+
+    static CalibratedModel model;
+    const int reps = 100;
+    bool fitted = false;
+    Clock::time_point t0 = Clock::now();
+    for (int r = 0; r < reps; r++) {
+        fitted = calibration_fit(&cal, &model);
+    }
+    double fit_us = std::chrono::duration<double, std::micro>(Clock::now() - t0).count() / reps;
+    if (!fitted) {
+        std::fprintf(stderr, "calibrate: fit failed (a gesture has fewer than two windows)\n");
+        return 2;
+    }
+    std::printf("fit %s (requested %s): %.1f us on this host, statistics %zu bytes, model %zu bytes\n",
+                calibration_fit_name((CalibrationFit)model.fit), calibration_fit_name(opt.fit), fit_us,
+                sizeof(cal), sizeof(model));
+
+    if (!calibration_save(&model)) {
+        std::fprintf(stderr, "calibrate: flash write failed\n");
+        return 2;
+    }
+    const CalibratedModel* stored = calibration_stored();
+    bool same = stored != nullptr && std::memcmp(stored, &model, sizeof(model)) == 0;
+    std::printf("flash: stored at 0x%08X, read back %s\n", CALIB_FLASH_ADDR, same ? "identical" : "DIFFERENT");
+
+    static ModelDescriptor desc;
+    calibration_descriptor(stored, &desc);
+    std::printf("\n%-18s %-10s %9s %11s\n", "file (2nd half)", "label", "exported%", "calibrated%");
+    double sum_exported = 0.0, sum_calibrated = 0.0;
+    for (const Recording& rec : recs) {
+        classifier_set_model(nullptr);
+        double exported = score(rec);
+        classifier_set_model(&desc);
+        double calibrated = score(rec);
+        std::printf("%-18s %-10s %9.1f %11.1f\n", rec.name.c_str(), gesture_names[rec.label], exported,
+                    calibrated);
+        sum_exported += exported;
+        sum_calibrated += calibrated;
+    }
+    classifier_set_model(nullptr);
+    std::printf("%-18s %-10s %9.1f %11.1f\n", "mean", "", sum_exported / recs.size(),
+                sum_calibrated / recs.size());
+    return same ? 0 : 2;
+}
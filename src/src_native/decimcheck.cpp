@@ -0,0 +1,334 @@
+// Checks the ADC decimator (adc_decimator.c): the kernel against a direct convolution
+// with the CIC impulse response, exact DC for every factor and order, the designed
+// response against measured tones (in band and the ones that alias into it), the
+// noise of single conversions vs decimated scans, and the cost against its budget.
+#include "host_commands.h"
+#include "adc_decimator.h"
+#include "adc_acquisition.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+// Core clock the budgets are spent at (SystemClock_Config)
+static const double MCU_CLOCK_MHZ = 50.0;
+static const float response_hz[] = { 5, 20, 50, 100, 200, 300, 450, 600, 1050, 1200, 1400, 1450, 1550, 2950, 4400 };
+
+static double to_db(double gain) {
+    return 20.0 * std::log10(gain > 1e-9 ? gain : 1e-9);
+}
+
+// Runs n scans through dec, every channel fed by sample(i, ch)
+template <typename F>
+static std::vector<uint16_t> decimate(AdcDecimator& dec, size_t n, F sample) {
+    std::vector<uint16_t> scans(n * ADC_CHANNELS);
+    for (size_t i = 0; i < n; i++) {
+        for (int ch = 0; ch < ADC_CHANNELS; ch++) {
+            scans[i * ADC_CHANNELS + ch] = sample(i, ch);
+        }
+    }
+    std::vector<uint16_t> out((n / dec.config.factor + 1) * ADC_CHANNELS);
+    uint32_t frames = adc_decimator_process(&dec, scans.data(), (uint32_t)n, (uint16_t(*)[ADC_CHANNELS])out.data());
+    out.resize(frames * ADC_CHANNELS);
+    return out;
+}
+
+// Output RMS (mean removed, last second of 3 s) of a tone of amplitude 1000 on the
+// mid-scale offset, relative to the input; 2 extra bits keep the floor below -80dB
+static double measured_gain(AdcDecimatorConfig config, float freq_hz) {
+    config.extra_bits = 2;
+    AdcDecimator dec;
+    adc_decimator_init(&dec, &config);
+    const double fs = (double)SAMPLING_RATE_HZ * config.factor;
+    std::vector<uint16_t> out = decimate(dec, 3 * (size_t)fs, [&](size_t i, int) {
+        return (uint16_t)std::lround(2048.0 + 1000.0 * std::sin(2.0 * M_PI * freq_hz * i / fs));
+    });
+    size_t n = out.size() / ADC_CHANNELS, first = n - SAMPLING_RATE_HZ;
+    double sum = 0.0, sum_sqr = 0.0;
+    for (size_t k = first; k < n; k++) {
+        double v = out[k * ADC_CHANNELS] / 4.0;
+        sum += v;
+        sum_sqr += v * v;
+    }
+    double mean = sum / SAMPLING_RATE_HZ;
+    double rms = std::sqrt(std::max(0.0, sum_sqr / SAMPLING_RATE_HZ - mean * mean));
+    return rms / (1000.0 / std::sqrt(2.0));
+}
+
+// Same integer arithmetic as the kernel, but the CIC as a direct convolution of the
+// scans (relative to the first) with N boxcars of length R
+static std::vector<uint16_t> reference(const AdcDecimator& design, const std::vector<uint16_t>& scans) {
+    const int R = design.config.factor, N = design.config.order;
+    std::vector<int64_t> h(1, 1);
+    for (int st = 0; st < N; st++) {
+        std::vector<int64_t> next(h.size() + R - 1, 0);
+        for (size_t j = 0; j < h.size(); j++) {
+            for (int r = 0; r < R; r++) {
+                next[j + r] += h[j];
+            }
+        }
+        h = next;
+    }
+    const int32_t side = design.comp_tap, centre = (1 << ADC_DECIM_COMP_BITS) + 2 * side;
+    const int extra = design.config.extra_bits;
+    size_t n = scans.size() / ADC_CHANNELS, frames = n / R;
+    std::vector<uint16_t> out(frames * ADC_CHANNELS);
+    for (int ch = 0; ch < ADC_CHANNELS; ch++) {
+        int32_t offset = scans[ch];
+        int64_t y1 = 0, y2 = 0;
+        for (size_t k = 0; k < frames; k++) {
+            int64_t y = 0;
+            int64_t last = (int64_t)(k + 1) * R - 1;
+            for (size_t j = 0; j < h.size() && last - (int64_t)j >= 0; j++) {
+                y += h[j] * (scans[(last - j) * ADC_CHANNELS + ch] - offset);
+            }
+            int64_t z = y;
+            if (side != 0) {
+                z = (centre * y1 - side * (y + y2) + (1 << (ADC_DECIM_COMP_BITS - 1))) >> ADC_DECIM_COMP_BITS;
+                y2 = y1;
+                y1 = y;
+            }
+            int64_t v = ((int64_t)offset << extra)
+                        + ((z * design.norm_mul + (1ll << (design.norm_shift - 1))) >> design.norm_shift);
+            out[k * ADC_CHANNELS + ch] = (uint16_t)std::min<int64_t>(std::max<int64_t>(v, 0), design.out_max);
+        }
+    }
+    return out;
+}
+
+// Random full-scale scans fed in random-size chunks, against the reference; returns
+// the number of mismatching samples
+static size_t check_kernel(const AdcDecimatorConfig& config, std::mt19937& rng) {
+    AdcDecimator dec;
+    adc_decimator_init(&dec, &config);
+    const size_t n = 4000;
+    std::vector<uint16_t> scans(n * ADC_CHANNELS);
+    // Mostly random walks, with full-scale jumps that drive the clamp
+    std::uniform_int_distribution<int> step(-200, 200), jump(0, 99), level(0, 4095);
+    for (int ch = 0; ch < ADC_CHANNELS; ch++) {
+        int v = level(rng);
+        for (size_t i = 0; i < n; i++) {
+            v = jump(rng) == 0 ? level(rng) : std::min(4095, std::max(0, v + step(rng)));
+            scans[i * ADC_CHANNELS + ch] = (uint16_t)v;
+        }
+    }
+    std::vector<uint16_t> expect = reference(dec, scans);
+
+    std::vector<uint16_t> out(expect.size() + ADC_CHANNELS);
+    std::uniform_int_distribution<uint32_t> chunk(1, 3 * dec.config.factor + 5);
+    size_t frames = 0;
+    for (size_t i = 0; i < n;) {
+        uint32_t count = (uint32_t)std::min<size_t>(chunk(rng), n - i);
+        frames += adc_decimator_process(&dec, &scans[i * ADC_CHANNELS], count,
+                                        (uint16_t(*)[ADC_CHANNELS])&out[frames * ADC_CHANNELS]);
+        i += count;
+    }
+    size_t mismatches = frames * ADC_CHANNELS == expect.size() ? 0 : 1;
+    for (size_t k = 0; k < std::min(frames * ADC_CHANNELS, expect.size()); k++) {
+        mismatches += out[k] != expect[k] ? 1 : 0;
+    }
+    return mismatches;
+}
+
+// Starts at one level, steps to another, and checks that the output settles on it exactly
+static bool check_dc(const AdcDecimatorConfig& config, int from, int to) {
+    AdcDecimator dec;
+    adc_decimator_init(&dec, &config);
+    size_t settle = 8 * (size_t)config.factor;
+    std::vector<uint16_t> out = decimate(dec, settle, [&](size_t i, int) { return (uint16_t)(i == 0 ? from : to); });
+    return out.back() == (to << dec.config.extra_bits);
+}
+
+struct NoiseResult {
+    double rms_lsb;   // Residual after fitting the tone, in 12-bit counts
+    double enob;      // Bits at which quantisation alone would give that residual
+};
+
+// Least-squares fit of DC + the known tone; the residual is what the ADC added
+static NoiseResult fit_noise(const std::vector<double>& x, double freq_hz, double fs) {
+    double s[3][3] = {}, b[3] = {};
+    for (size_t i = 0; i < x.size(); i++) {
+        double basis[3] = { 1.0, std::sin(2.0 * M_PI * freq_hz * i / fs), std::cos(2.0 * M_PI * freq_hz * i / fs) };
+        for (int r = 0; r < 3; r++) {
+            for (int c = 0; c < 3; c++) {
+                s[r][c] += basis[r] * basis[c];
+            }
+            b[r] += basis[r] * x[i];
+        }
+    }
+    // 3x3 Gaussian elimination
+    for (int p = 0; p < 3; p++) {
+        for (int r = p + 1; r < 3; r++) {
+            double f = s[r][p] / s[p][p];
+            for (int c = p; c < 3; c++) {
+                s[r][c] -= f * s[p][c];
+            }
+            b[r] -= f * b[p];
+        }
+    }
+    double coef[3];
+    for (int r = 2; r >= 0; r--) {
+        double v = b[r];
+        for (int c = r + 1; c < 3; c++) {
+            v -= s[r][c] * coef[c];
+        }
+        coef[r] = v / s[r][r];
+    }
+    double sum_sqr = 0.0;
+    for (size_t i = 0; i < x.size(); i++) {
+        double e = x[i] - coef[0] - coef[1] * std::sin(2.0 * M_PI * freq_hz * i / fs)
+                   - coef[2] * std::cos(2.0 * M_PI * freq_hz * i / fs);
+        sum_sqr += e * e;
+    }
+    double rms = std::sqrt(sum_sqr / x.size());
+    return { rms, std::log2(4096.0 / (rms * std::sqrt(12.0))) };
+}
+
+int cmd_decimcheck(int argc, char** argv) {
+    AdcDecimatorConfig config = ADC_DECIMATOR_DEFAULTS;
+    if (config.factor < 2) {
+        config.factor = 8;   // What the check looks at when this build does not oversample
+    }
+    double noise_lsb = 2.0;
+    for (int i = 0; i < argc; i++) {
+        if (std::strcmp(argv[i], "--factor") == 0 && i + 1 < argc) {
+            config.factor = (uint8_t)std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--order") == 0 && i + 1 < argc) {
+            config.order = (uint8_t)std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--no-comp") == 0) {
+            config.compensate = false;
+        } else if (std::strcmp(argv[i], "--noise") == 0 && i + 1 < argc) {
+            noise_lsb = std::atof(argv[++i]);
+        } else {
+            std::fprintf(stderr, "decimcheck: unknown argument %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    AdcDecimator design;
+    adc_decimator_init(&design, &config);
+    config = design.config;
+    const double fs = (double)SAMPLING_RATE_HZ * config.factor;
+    int failures = 0;
+
+    std::printf("CIC order %u, decimation %u: %.0fHz scans -> %dHz (ADC_OVERSAMPLE %d in this build)\n",
+                config.order, config.factor, fs, SAMPLING_RATE_HZ, ADC_OVERSAMPLE);
+    std::printf("compensator [-a, 1+2a, -a] a = %.4f, flat at %.0fHz\n",
+                design.comp_tap / (double)(1 << ADC_DECIM_COMP_BITS), ADC_DECIM_FLAT_HZ);
+
+    // Bit-exact against the direct convolution, every factor and order
+    std::mt19937 rng(1234);
+    size_t mismatches = 0, cases = 0;
+    int dc_failures = 0;
+    static const uint8_t factors[] = { 1, 2, 3, 4, 5, 8, 12, 16, 32, 64 };
+    for (uint8_t factor : factors) {
+        for (uint8_t order = 1; order <= ADC_DECIM_MAX_ORDER; order++) {
+            for (int comp = 0; comp < 2; comp++) {
+                for (uint8_t extra = 0; extra <= 2; extra += 2) {
+                    AdcDecimatorConfig c = { factor, order, comp != 0, extra };
+                    mismatches += check_kernel(c, rng);
+                    cases++;
+                    for (int to : { 0, 1, 1000, 2047, 4094, 4095 }) {
+                        dc_failures += check_dc(c, 2048, to) && check_dc(c, 4095 - to, to) ? 0 : 1;
+                    }
+                }
+            }
+        }
+    }
+    std::printf("\nkernel vs direct convolution: %zu configurations, %zu mismatching samples\n", cases, mismatches);
+    std::printf("DC steps settling exactly: %d failures\n", dc_failures);
+    failures += (mismatches > 0 ? 1 : 0) + (dc_failures > 0 ? 1 : 0);
+
+    std::printf("\n%8s %8s %10s %10s\n", "Hz", "alias Hz", "design dB", "measured");
+    for (float hz : response_hz) {
+        if (hz >= fs / 2) {
+            continue;
+        }
+        double alias = std::fabs(hz - SAMPLING_RATE_HZ * std::round(hz / SAMPLING_RATE_HZ));
+        double design_db = to_db(adc_decimator_gain(&design, hz));
+        double measured_db = to_db(measured_gain(config, hz));
+        bool ok = std::fabs(measured_db - design_db) < 0.2 || (design_db < -60.0 && measured_db < -60.0);
+        std::printf("%8.0f %8.0f %10.1f %10.1f%s\n", hz, alias, design_db, measured_db, ok ? "" : "  FAIL");
+        failures += ok ? 0 : 1;
+    }
+
+    // Over the 20-450Hz band: ripple, and the strongest scan-rate tone that lands in it
+    double lo = 1e9, hi = -1e9, worst_alias = -1e9, worst_hz = 0.0;
+    for (double f = 20.0; f <= 450.0; f += 1.0) {
+        double db = to_db(adc_decimator_gain(&design, (float)f));
+        lo = std::min(lo, db);
+        hi = std::max(hi, db);
+    }
+    for (double f = SAMPLING_RATE_HZ - 450.0; f < fs / 2; f += 1.0) {
+        double alias = std::fabs(f - SAMPLING_RATE_HZ * std::round(f / SAMPLING_RATE_HZ));
+        double db = to_db(adc_decimator_gain(&design, (float)f));
+        if (alias >= 20.0 && alias <= 450.0 && db > worst_alias) {
+            worst_alias = db;
+            worst_hz = f;
+        }
+    }
+    std::printf("\n20-450Hz: %+.2f..%+.2f dB; worst alias into it %.1f dB (from %.0fHz)\n", lo, hi,
+                worst_hz > 0 ? worst_alias : 0.0, worst_hz);
+    std::printf("single conversions at %dHz pass every alias at 0 dB\n", SAMPLING_RATE_HZ);
+
+    // A 97Hz tone of 1500 counts plus Gaussian ADC noise, quantised at the scan rate
+    std::normal_distribution<double> noise(0.0, noise_lsb);
+    const size_t scans = 4 * (size_t)fs;
+    std::vector<uint16_t> analog(scans);
+    for (size_t i = 0; i < scans; i++) {
+        double v = 2048.0 + 1500.0 * std::sin(2.0 * M_PI * 97.0 * i / fs) + noise(rng);
+        analog[i] = (uint16_t)std::min(4095L, std::max(0L, std::lround(v)));
+    }
+    std::vector<double> single;
+    for (size_t i = 0; i < scans; i += config.factor) {
+        single.push_back(analog[i]);
+    }
+    std::printf("\n%.1f LSB rms ADC noise on a 97Hz tone      noise LSB   ENOB\n", noise_lsb);
+    NoiseResult r = fit_noise(single, 97.0, SAMPLING_RATE_HZ);
+    std::printf("%-40s %9.3f %6.2f\n", "single conversion per frame", r.rms_lsb, r.enob);
+    for (uint8_t extra = 0; extra <= 2; extra += 2) {
+        AdcDecimatorConfig c = config;
+        c.extra_bits = extra;
+        AdcDecimator dec;
+        adc_decimator_init(&dec, &c);
+        std::vector<uint16_t> out = decimate(dec, scans, [&](size_t i, int) { return analog[i]; });
+        std::vector<double> x;
+        for (size_t k = 8; k < out.size() / ADC_CHANNELS; k++) {
+            x.push_back(out[k * ADC_CHANNELS] / (double)(1 << extra));
+        }
+        NoiseResult d = fit_noise(x, 97.0, SAMPLING_RATE_HZ);
+        char label[64];
+        std::snprintf(label, sizeof(label), "decimated by %u, %u extra bits", config.factor, extra);
+        std::printf("%-40s %9.3f %6.2f\n", label, d.rms_lsb, d.enob);
+    }
+
+    // Cost per output frame
+    AdcDecimator dec;
+    adc_decimator_init(&dec, &config);
+    // One DMA half of scans per call, as adc_acquisition.c feeds it
+    std::vector<uint16_t> stream((size_t)config.factor * ADC_HALF_FRAMES * ADC_CHANNELS);
+    for (size_t i = 0; i < stream.size(); i++) {
+        stream[i] = (uint16_t)(rng() & 4095);
+    }
+    uint16_t block[ADC_HALF_FRAMES + 1][ADC_CHANNELS];
+    size_t frames = 0;
+    Clock::time_point t0 = Clock::now();
+    for (int rep = 0; rep < 20000; rep++) {
+        frames += adc_decimator_process(&dec, stream.data(), (uint32_t)(config.factor * ADC_HALF_FRAMES), block);
+    }
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+    uint32_t budget = adc_decimator_budget_cycles(&design);
+    double per_second = budget * (double)SAMPLING_RATE_HZ / (MCU_CLOCK_MHZ * 1e6);
+    std::printf("\nhost %.1f ns/frame; budget %u cycles/frame = %.2f%% of the CPU at 50MHz,\n", ns / frames,
+                budget, 100.0 * per_second);
+    std::printf("%.1f us at 50MHz per DMA half (%d frames)\n", budget * ADC_HALF_FRAMES / MCU_CLOCK_MHZ,
+                ADC_HALF_FRAMES);
+
+    std::printf("\n%s\n", failures == 0 ? "all checks passed" : "CHECKS FAILED");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,277 @@
+// Long-session drift test for the feature normaliser: the labelled recordings are
+// strung into one session (rest between gestures, cycling through the files), a slow
+// gain and offset ramp is applied to the raw samples to mimic electrode impedance and
+// sweat, and the session is classified with and without feature_normaliser.
+#include "host_commands.h"
+#include "recording.h"
+#include "feature_normaliser.h"
+#include "gesture_decision.h"
+#include "signal_validation.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+struct DriftOptions {
+    double minutes = 60.0;
+    double gesture_s = 5.0;   // Gesture segment length
+    double rest_s = 5.0;      // Rest between gestures
+    double offset = 200.0;    // LSB added by the end of the session
+    double gain = 0.3;        // Relative amplitude change by the end of the session
+    int blocks = 6;
+    int channels = NUM_CHANNELS;  // Only recordings from one electrode setup make a session
+    bool validate = true;
+    FeatureNormaliserConfig norm = FEATURE_NORMALISER_DEFAULTS;
+};
+
+struct SessionSample {
+    int16_t ch[NUM_CHANNELS];
+    int8_t label;
+};
+
+struct BlockStats {
+    size_t windows = 0;
+    size_t invalid = 0;
+    size_t raw_correct = 0;
+    size_t decided_correct = 0;
+    size_t rest_windows = 0;
+    size_t rest_correct = 0;  // Rest windows decided as REST
+    float min_gain = 1.0f;    // Normaliser gain range over the block's windows
+    float max_gain = 1.0f;
+};
+
+// Takes count frames from rec starting at cursor, wrapping around the file
+static void append_frames(const Recording& rec, size_t& cursor, size_t count,
+                          std::vector<SessionSample>& out) {
+    for (size_t i = 0; i < count; i++) {
+        const EmgFrame& f = rec.frames[cursor];
+        SessionSample s;
+        for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+            s.ch[ch] = f.ch[ch];
+        }
+        s.label = (int8_t)rec.label;
+        out.push_back(s);
+        cursor = (cursor + 1) % rec.frames.size();
+    }
+}
+
+static bool build_session(const std::vector<Recording>& recs, const DriftOptions& opt,
+                          std::vector<SessionSample>& session) {
+    std::vector<const Recording*> rest, gestures;
+    for (const Recording& rec : recs) {
+        (rec.label == GESTURE_REST ? rest : gestures).push_back(&rec);
+    }
+    if (rest.empty() || gestures.empty()) {
+        std::fprintf(stderr, "drift: need rest and gesture recordings\n");
+        return false;
+    }
+
+    const size_t total = (size_t)(opt.minutes * 60.0 * SAMPLING_RATE_HZ);
+    const size_t rest_len = (size_t)(opt.rest_s * SAMPLING_RATE_HZ);
+    const size_t gesture_len = (size_t)(opt.gesture_s * SAMPLING_RATE_HZ);
+    std::vector<size_t> rest_cursor(rest.size()), gesture_cursor(gestures.size());
+    session.reserve(total + rest_len + gesture_len);
+
+    for (size_t k = 0; session.size() < total; k++) {
+        size_t r = k % rest.size(), g = k % gestures.size();
+        append_frames(*rest[r], rest_cursor[r], rest_len, session);
+        append_frames(*gestures[g], gesture_cursor[g], gesture_len, session);
+    }
+    session.resize(total);
+
+    // Linear ramp over the session, on the raw ADC codes
+    for (size_t i = 0; i < session.size(); i++) {
+        double u = (double)i / session.size();
+        for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+            double v = session[i].ch[ch] * (1.0 + opt.gain * u) + opt.offset * u;
+            session[i].ch[ch] = (int16_t)std::min(std::max(std::lround(v), 0L), 4095L);
+        }
+    }
+    return true;
+}
+
+// Same order as the firmware main loop: features -> validate (raw) -> normalise ->
+// classify -> decide, then the raw features update the normaliser
+static void run_session(const std::vector<SessionSample>& session, const DriftOptions& opt,
+                        bool adapt, std::vector<BlockStats>& blocks, FeatureNormaliser& norm) {
+    static EMG_Buffer buffer;
+    emg_buffer_init(&buffer);
+    GestureDecision decision;
+    gesture_decision_init(&decision, NULL);
+    feature_normaliser_init(&norm, &opt.norm);
+    GestureType decided = GESTURE_REST;
+    float features[TOTAL_FEATURES];
+    float probs[NUM_CLASSES];
+
+    blocks.assign(opt.blocks, BlockStats());
+    uint32_t samples_to_hop = HOP_SAMPLES;
+    for (size_t i = 0; i < session.size(); i++) {
+        const SessionSample& s = session[i];
+        emg_buffer_add_sample(&buffer, s.ch[0], s.ch[1], s.ch[2], s.ch[3]);
+        if (--samples_to_hop > 0) {
+            continue;
+        }
+        samples_to_hop = HOP_SAMPLES;
+        if (!emg_buffer_process_window(&buffer, features)) {
+            continue;
+        }
+
+        float raw[TOTAL_FEATURES];
+        std::memcpy(raw, features, sizeof(raw));
+        bool valid = !opt.validate || is_window_valid(&buffer, raw);
+        if (adapt) {
+            feature_normaliser_apply(&norm, features);
+        }
+        GestureType prediction = GESTURE_REST;
+        if (valid) {
+            prediction = classify_gesture_proba(features, probs);
+            GestureType next;
+            if (gesture_decision_push(&decision, probs, &next)) {
+                decided = next;
+            }
+        } else {
+            gesture_decision_reset(&decision, GESTURE_REST);
+            decided = GESTURE_REST;
+        }
+        if (adapt) {
+            feature_normaliser_update(&norm, raw, valid && prediction == GESTURE_REST);
+        }
+
+        BlockStats& b = blocks[i * opt.blocks / session.size()];
+        b.windows++;
+        b.invalid += valid ? 0 : 1;
+        b.raw_correct += (valid && prediction == s.label) ? 1 : 0;
+        b.decided_correct += decided == s.label ? 1 : 0;
+        for (int k = 0; adapt && k < TOTAL_FEATURES; k++) {
+            b.min_gain = std::min(b.min_gain, norm.gain[k]);
+            b.max_gain = std::max(b.max_gain, norm.gain[k]);
+        }
+        if (s.label == GESTURE_REST) {
+            b.rest_windows++;
+            b.rest_correct += decided == GESTURE_REST ? 1 : 0;
+        }
+    }
+}
+
+static double pct(size_t n, size_t d) {
+    return d > 0 ? 100.0 * n / d : 0.0;
+}
+
+int cmd_drift(int argc, char** argv) {
+    DriftOptions opt;
+    int first = 0;
+    for (; first < argc && std::strncmp(argv[first], "--", 2) == 0; first++) {
+        const char* arg = argv[first];
+        const bool has_value = first + 1 < argc;
+        if (std::strcmp(arg, "--minutes") == 0 && has_value) {
+            opt.minutes = std::atof(argv[++first]);
+        } else if (std::strcmp(arg, "--gesture") == 0 && has_value) {
+            opt.gesture_s = std::atof(argv[++first]);
+        } else if (std::strcmp(arg, "--rest") == 0 && has_value) {
+            opt.rest_s = std::atof(argv[++first]);
+        } else if (std::strcmp(arg, "--offset") == 0 && has_value) {
+            opt.offset = std::atof(argv[++first]);
+        } else if (std::strcmp(arg, "--gain") == 0 && has_value) {
+            opt.gain = std::atof(argv[++first]) / 100.0;
+        } else if (std::strcmp(arg, "--blocks") == 0 && has_value) {
+            opt.blocks = std::max(1, std::atoi(argv[++first]));
+        } else if (std::strcmp(arg, "--channels") == 0 && has_value) {
+            opt.channels = std::atoi(argv[++first]);
+        } else if (std::strcmp(arg, "--alpha") == 0 && has_value) {
+            opt.norm.alpha = (float)std::atof(argv[++first]);
+        } else if (std::strcmp(arg, "--lock") == 0 && has_value) {
+            opt.norm.lock_windows = (uint16_t)std::max(1, std::atoi(argv[++first]));
+        } else if (std::strcmp(arg, "--gate") == 0 && has_value) {
+            opt.norm.gate = (float)std::atof(argv[++first]);
+        } else if (std::strcmp(arg, "--max-shift") == 0 && has_value) {
+            opt.norm.max_shift = (float)std::atof(argv[++first]);
+        } else if (std::strcmp(arg, "--max-gain") == 0 && has_value) {
+            opt.norm.max_gain = (float)std::atof(argv[++first]);
+        } else if (std::strcmp(arg, "--no-validate") == 0) {
+            opt.validate = false;
+        } else {
+            std::fprintf(stderr, "drift: unknown option %s\n", arg);
+            return 1;
+        }
+    }
+
+    std::vector<std::string> paths = expand_recording_paths(argc - first, argv + first);
+    std::vector<Recording> recs;
+    for (const std::string& path : paths) {
+        Recording rec;
+        if (!load_recording(path, rec)) {
+            std::fprintf(stderr, "drift: cannot read %s\n", path.c_str());
+            return 1;
+        }
+        if (rec.label >= 0 && rec.channels == opt.channels && rec.frames.size() >= WINDOW_SIZE) {
+            recs.push_back(std::move(rec));
+        }
+    }
+
+    std::vector<SessionSample> session;
+    if (opt.minutes <= 0.0 || !build_session(recs, opt, session)) {
+        return 1;
+    }
+    std::printf("session: %.1f min from %zu recordings (%.1f s gesture / %.1f s rest), "
+                "drift by the end: %+.0f LSB, %+.0f%% gain\n",
+                opt.minutes, recs.size(), opt.gesture_s, opt.rest_s, opt.offset, 100.0 * opt.gain);
+
+    std::vector<BlockStats> fixed, adapted;
+    FeatureNormaliser norm;
+    run_session(session, opt, false, fixed, norm);
+    run_session(session, opt, true, adapted, norm);
+
+    std::printf("\n%-13s %7s | %-27s | %-27s\n", "", "", "       fixed scaler", "       adaptive");
+    std::printf("%-13s %7s | %7s %7s %7s %3s| %7s %7s %7s %3s\n", "minutes", "windows", "invalid",
+                "raw%", "decided", "", "invalid", "raw%", "decided", "");
+    BlockStats f_total, a_total;
+    for (int k = 0; k < opt.blocks; k++) {
+        const BlockStats& f = fixed[k];
+        const BlockStats& a = adapted[k];
+        char span[32];
+        std::snprintf(span, sizeof(span), "%5.1f-%5.1f", opt.minutes * k / opt.blocks,
+                      opt.minutes * (k + 1) / opt.blocks);
+        std::printf("%-13s %7zu | %7zu %7.1f %7.1f %3s| %7zu %7.1f %7.1f\n", span, f.windows, f.invalid,
+                    pct(f.raw_correct, f.windows), pct(f.decided_correct, f.windows), "", a.invalid,
+                    pct(a.raw_correct, a.windows), pct(a.decided_correct, a.windows));
+        for (BlockStats* t : { &f_total, &a_total }) {
+            const BlockStats& b = t == &f_total ? f : a;
+            t->windows += b.windows;
+            t->invalid += b.invalid;
+            t->raw_correct += b.raw_correct;
+            t->decided_correct += b.decided_correct;
+            t->rest_windows += b.rest_windows;
+            t->rest_correct += b.rest_correct;
+            t->min_gain = std::min(t->min_gain, b.min_gain);
+            t->max_gain = std::max(t->max_gain, b.max_gain);
+        }
+    }
+    std::printf("%-13s %7zu | %7zu %7.1f %7.1f %3s| %7zu %7.1f %7.1f\n", "all", f_total.windows,
+                f_total.invalid, pct(f_total.raw_correct, f_total.windows),
+                pct(f_total.decided_correct, f_total.windows), "", a_total.invalid,
+                pct(a_total.raw_correct, a_total.windows), pct(a_total.decided_correct, a_total.windows));
+    std::printf("rest windows decided REST: fixed %.1f%%, adaptive %.1f%%\n",
+                pct(f_total.rest_correct, f_total.rest_windows),
+                pct(a_total.rest_correct, a_total.rest_windows));
+
+    if (!norm.locked) {
+        std::printf("normaliser: not locked, %u of %u reference windows\n", norm.lock_count,
+                    norm.config.lock_windows);
+        return 0;
+    }
+    // Where the adaptive run ended up relative to its reference, in the active model's units
+    const float* scale = classifier_get_model()->scaler_scale;
+    double worst_shift = 0.0, min_gain = 1.0, max_gain = 1.0;
+    for (int i = 0; i < TOTAL_FEATURES; i++) {
+        worst_shift = std::max(worst_shift,
+                               (double)std::fabs(norm.baseline[i] - norm.reference[i]) / scale[i]);
+        min_gain = std::min(min_gain, (double)norm.gain[i]);
+        max_gain = std::max(max_gain, (double)norm.gain[i]);
+    }
+    std::printf("normaliser: locked, %u rest updates, max baseline shift %.2f scaler_scale, "
+                "gain %.2f..%.2f (%.2f..%.2f over the session)\n", norm.updates, worst_shift,
+                min_gain, max_gain, a_total.min_gain, a_total.max_gain);
+    return 0;
+}
@@ -0,0 +1,236 @@
+// Checks the packed emg_dsp kernels, the separate ones and the single-pass
+// emg_dsp_channel_stats(), against plain loops on random series (every length and
+// alignment the ring can produce, random thresholds), times them, checks the
+// emg_spectrum real FFT against a plain DFT and, for recordings, the running window
+// sums against the kernel at every hop.
+#include "host_commands.h"
+#include "recording.h"
+#include "emg_classifier.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+// Plain definitions of every sum; ZC, SSC and WAMP with the given thresholds
+static void reference_sums(const int16_t* x, uint32_t n, const EmgDspThresholds& t, EMG_ChannelSums* s) {
+    std::memset(s, 0, sizeof(*s));
+    for (uint32_t i = 0; i < n; i++) {
+        s->sum_abs += x[i] < 0 ? -x[i] : x[i];
+        s->sum_sqr += (int32_t)x[i] * x[i];
+        s->sum += x[i];
+        if (i > 0) {
+            int32_t d = (int32_t)x[i] - x[i - 1];
+            int32_t ad = d < 0 ? -d : d;
+            s->sum_diff += ad;
+            s->zero_crossings += (x[i] < 0) != (x[i - 1] < 0) && ad >= t.zc_deadband;
+            s->willison += ad >= t.wamp_threshold;
+        }
+        if (i > 0 && i + 1 < n) {
+            s->slope_changes += ((int32_t)x[i] - x[i - 1]) * ((int32_t)x[i] - x[i + 1]) >= t.ssc_threshold;
+        }
+    }
+}
+
+// The separate kernels, one pass each (no thresholds)
+static void kernel_sums(const int16_t* x, uint32_t n, EMG_ChannelSums* s) {
+    std::memset(s, 0, sizeof(*s));
+    s->sum_abs = emg_dsp_sum_abs(x, n);
+    s->sum_sqr = emg_dsp_sum_sqr(x, n);
+    s->sum = emg_dsp_sum(x, n);
+    s->sum_diff = emg_dsp_sum_abs_diff(x, n);
+    s->zero_crossings = emg_dsp_zero_crossings(x, n);
+}
+
+// Members selected by an EMG_DSP_* mask
+static void keep_stats(EMG_ChannelSums* s, uint32_t stats) {
+    if (!(stats & EMG_DSP_SUM_ABS)) s->sum_abs = 0;
+    if (!(stats & EMG_DSP_SUM_SQR)) s->sum_sqr = 0;
+    if (!(stats & EMG_DSP_SUM)) s->sum = 0;
+    if (!(stats & EMG_DSP_SUM_DIFF)) s->sum_diff = 0;
+    if (!(stats & EMG_DSP_ZC)) s->zero_crossings = 0;
+    if (!(stats & EMG_DSP_SSC)) s->slope_changes = 0;
+    if (!(stats & EMG_DSP_WAMP)) s->willison = 0;
+}
+
+static bool same_sums(const EMG_ChannelSums& a, const EMG_ChannelSums& b) {
+    return a.sum_abs == b.sum_abs && a.sum_sqr == b.sum_sqr && a.sum == b.sum && a.sum_diff == b.sum_diff
+           && a.zero_crossings == b.zero_crossings && a.slope_changes == b.slope_changes
+           && a.willison == b.willison;
+}
+
+// Both the separate kernels and emg_dsp_channel_stats() (random thresholds and
+// stat selections) against the plain definitions
+static size_t check_random(size_t& cases) {
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int> value(-16383, 16383);
+    std::uniform_int_distribution<int> band(0, 4000);
+    std::uniform_int_distribution<uint32_t> selection(0, EMG_DSP_ALL);
+    std::vector<int16_t> series(2 * WINDOW_SIZE + 4);
+    const EmgDspThresholds none = { 0, 0, 0 };
+    size_t failures = 0;
+
+    for (int round = 0; round < 50; round++) {
+        // Small amplitudes in half the rounds, so the deadband and thresholds matter
+        int scale = round % 2 ? 1 : 64;
+        for (int16_t& v : series) {
+            v = (int16_t)(value(rng) / scale);
+        }
+        EmgDspThresholds t = { (int16_t)(band(rng) / scale), (int16_t)(band(rng) / scale),
+                               band(rng) * band(rng) / (scale * scale) };
+        uint32_t stats = round < 2 ? EMG_DSP_ALL : selection(rng);
+        for (uint32_t offset = 0; offset < 4; offset++) {
+            for (uint32_t n = 0; n <= 2 * WINDOW_SIZE; n++) {
+                EMG_ChannelSums expected, got;
+                reference_sums(&series[offset], n, none, &expected);
+                keep_stats(&expected, EMG_DSP_SUM_ABS | EMG_DSP_SUM_SQR | EMG_DSP_SUM | EMG_DSP_SUM_DIFF | EMG_DSP_ZC);
+                kernel_sums(&series[offset], n, &got);
+                bool ok = same_sums(expected, got);
+
+                reference_sums(&series[offset], n, t, &expected);
+                keep_stats(&expected, stats);
+                emg_dsp_channel_stats(&series[offset], n, stats, &t, &got);
+                ok = ok && same_sums(expected, got);
+                cases++;
+                if (!ok) {
+                    if (failures < 10) {
+                        std::printf("random series: n=%u offset=%u stats=0x%02x differs\n", n, offset, stats);
+                    }
+                    failures++;
+                }
+            }
+        }
+    }
+    return failures;
+}
+
+// Host time per window of the five separate kernels and of the single pass with
+// the same sums, and with everything. On the host the lane helpers are plain C and
+// the separate loops vectorise, so this shows the relative cost of SSC and WAMP
+// rather than the gain on the M4, where every pass is bound by its loads.
+static void time_kernels(void) {
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<int> value(0, 4095);
+    std::vector<int16_t> x(WINDOW_SIZE);
+    for (int16_t& v : x) {
+        v = (int16_t)value(rng);
+    }
+    const EmgDspThresholds t = EMG_FEATURE_THRESHOLDS;
+    const uint32_t five = EMG_DSP_SUM_ABS | EMG_DSP_SUM_SQR | EMG_DSP_SUM | EMG_DSP_SUM_DIFF | EMG_DSP_ZC;
+    const int reps = 200000;
+    double ns[3];
+    int64_t sink = 0;
+    for (int k = 0; k < 3; k++) {
+        Clock::time_point t0 = Clock::now();
+        for (int r = 0; r < reps; r++) {
+            EMG_ChannelSums s;
+            if (k == 0) {
+                kernel_sums(x.data(), WINDOW_SIZE, &s);
+            } else {
+                emg_dsp_channel_stats(x.data(), WINDOW_SIZE, k == 1 ? five : EMG_DSP_ALL, &t, &s);
+            }
+            sink += s.sum_sqr + s.zero_crossings + s.slope_changes;
+            x[r % WINDOW_SIZE] ^= 1;  // Keep the compiler from hoisting the call
+        }
+        ns[k] = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / reps;
+    }
+    std::printf("window of %d samples, host ns: 5 kernels %.1f, single pass %.1f, single pass + ssc,wamp %.1f\n",
+                WINDOW_SIZE, ns[0], ns[1], ns[2]);
+    if (sink == 0) {
+        std::printf("(empty window)\n");
+    }
+}
+
+// Largest error of emg_spectrum_power() against a direct DFT of the same mean-removed,
+// Hann-weighted samples, relative to the largest bin
+static double check_spectrum(void) {
+    std::mt19937 rng(2);
+    std::uniform_int_distribution<int> value(0, 4095);
+    std::vector<int16_t> series(WINDOW_SIZE);
+    double worst = 0.0;
+
+    for (int round = 0; round < 20; round++) {
+        for (int16_t& v : series) {
+            v = (int16_t)value(rng);
+        }
+        float power[SPECTRUM_BINS];
+        emg_spectrum_power(series.data(), WINDOW_SIZE, power);
+
+        const int16_t* x = &series[WINDOW_SIZE - SPECTRUM_FFT_SIZE];
+        double mean = 0.0, window_energy = 0.0;
+        double w[SPECTRUM_FFT_SIZE];
+        for (int i = 0; i < SPECTRUM_FFT_SIZE; i++) {
+            mean += x[i];
+            w[i] = 0.5 - 0.5 * std::cos(2.0 * M_PI * i / SPECTRUM_FFT_SIZE);
+            window_energy += w[i] * w[i];
+        }
+        mean /= SPECTRUM_FFT_SIZE;
+
+        std::vector<double> expected(SPECTRUM_BINS);
+        double largest = 0.0;
+        for (int k = 1; k < SPECTRUM_BINS; k++) {
+            double re = 0.0, im = 0.0;
+            for (int i = 0; i < SPECTRUM_FFT_SIZE; i++) {
+                double v = (x[i] - mean) * w[i];
+                re += v * std::cos(2.0 * M_PI * k * i / SPECTRUM_FFT_SIZE);
+                im -= v * std::sin(2.0 * M_PI * k * i / SPECTRUM_FFT_SIZE);
+            }
+            double one_sided = k == SPECTRUM_BINS - 1 ? 1.0 : 2.0;
+            expected[k] = (re * re + im * im) * one_sided / (SPECTRUM_FFT_SIZE * window_energy);
+            largest = std::max(largest, expected[k]);
+        }
+        for (int k = 1; k < SPECTRUM_BINS; k++) {
+            worst = std::max(worst, std::fabs(power[k] - expected[k]) / largest);
+        }
+    }
+    return worst;
+}
+
+int cmd_dspcheck(int argc, char** argv) {
+    size_t cases = 0;
+    size_t failures = check_random(cases);
+    std::printf("%zu random series, %zu kernel mismatches\n", cases, failures);
+    time_kernels();
+    double spectrum_error = check_spectrum();
+    std::printf("128-point real FFT vs DFT: max error %.2e of the largest bin\n", spectrum_error);
+    failures += spectrum_error > 1e-4 ? 1 : 0;
+
+    size_t windows = 0;
+    size_t drift = 0;
+    for (const std::string& path : expand_recording_paths(argc, argv)) {
+        Recording rec;
+        if (!load_recording(path, rec)) {
+            std::fprintf(stderr, "dspcheck: cannot read %s\n", path.c_str());
+            return 1;
+        }
+        EMG_Buffer buffer;
+        emg_buffer_init(&buffer);
+        for (size_t i = 0; i < rec.frames.size(); i++) {
+            const EmgFrame& f = rec.frames[i];
+            emg_buffer_add_sample(&buffer, f.ch[0], f.ch[1], f.ch[2], f.ch[3]);
+            if (!buffer.is_full || (i + 1) % STEP_SIZE != 0) {
+                continue;
+            }
+            EMG_ChannelSums sums[NUM_CHANNELS];
+            emg_buffer_window_sums(&buffer, sums);
+            for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+                if (!same_sums(sums[ch], buffer.sums[ch])) {
+                    if (drift < 10) {
+                        std::printf("%s: sample %zu ch%d running sums differ from window\n",
+                                    rec.name.c_str(), i, ch + 1);
+                    }
+                    drift++;
+                }
+            }
+            windows++;
+        }
+    }
+    if (windows > 0) {
+        std::printf("%zu recorded windows, %zu channels where running sums differ\n", windows, drift);
+    }
+    return failures == 0 && drift == 0 ? 0 : 2;
+}
@@ -0,0 +1,121 @@
+// Scores the firmware feature path on the recordings: each file is memory-mapped and
+// streamed through the sample ring, extract_features_from_window() and
+// predict_gesture() at every STEP_SIZE hop (the windows the trainers use). This is the
+// raw classifier, without signal validation or voting (see replay for those).
+#include "host_commands.h"
+#include "recording.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+struct EvalResult {
+    size_t samples = 0;
+    size_t windows = 0;
+    size_t correct = 0;
+    int channels = 0;
+    size_t predicted[NUM_CLASSES] = {};
+};
+
+static bool eval_recording(const std::string& path, int label, EvalResult& res, size_t& bytes) {
+    MappedFile file;
+    if (!file.open(path)) {
+        return false;
+    }
+    bytes += file.size();
+
+    static EMG_Buffer buffer;
+    static int16_t window[NUM_CHANNELS][WINDOW_SIZE];
+    float features[TOTAL_FEATURES];
+    emg_buffer_init(&buffer);
+
+    FrameReader reader(file.data(), file.size());
+    EmgFrame frame;
+    int channels;
+    while (reader.next(frame, channels)) {
+        res.channels = channels > res.channels ? channels : res.channels;
+        emg_buffer_add_sample(&buffer, frame.ch[0], frame.ch[1], frame.ch[2], frame.ch[3]);
+        res.samples++;
+        if (!buffer.is_full || res.samples % STEP_SIZE != 0) {
+            continue;
+        }
+        emg_buffer_get_window(&buffer, window);
+        extract_features_from_window(window, features);
+        GestureType prediction = predict_gesture(features);
+        res.windows++;
+        res.predicted[prediction]++;
+        res.correct += (int)prediction == label ? 1 : 0;
+    }
+    return true;
+}
+
+int cmd_eval(int argc, char** argv) {
+    std::vector<std::string> paths = expand_recording_paths(argc, argv);
+    if (paths.empty()) {
+        std::fprintf(stderr, "eval: no recordings given\n");
+        return 1;
+    }
+
+    std::printf("%-18s %-10s %3s %8s %7s %7s  %s\n", "file", "label", "ch", "samples", "windows",
+                "acc%", "most predicted");
+
+    // confusion[true][predicted] over the labelled files
+    size_t confusion[NUM_CLASSES][NUM_CLASSES] = {};
+    size_t total_samples = 0, total_windows = 0, labelled = 0, correct = 0, bytes = 0;
+
+    const Clock::time_point t0 = Clock::now();
+    for (const std::string& path : paths) {
+        int label = label_from_path(path);
+        EvalResult res;
+        if (!eval_recording(path, label, res, bytes)) {
+            std::fprintf(stderr, "eval: cannot read %s\n", path.c_str());
+            return 1;
+        }
+
+        int top = 0;
+        for (int c = 1; c < NUM_CLASSES; c++) {
+            if (res.predicted[c] > res.predicted[top]) top = c;
+        }
+        std::string name = path.substr(path.find_last_of("/\\") + 1);
+        const char* top_name = res.windows > 0 ? gesture_names[top] : "-";
+        if (label >= 0 && res.windows > 0) {
+            std::printf("%-18s %-10s %3d %8zu %7zu %7.1f  %s\n", name.c_str(), gesture_names[label],
+                        res.channels, res.samples, res.windows, 100.0 * res.correct / res.windows,
+                        top_name);
+            for (int c = 0; c < NUM_CLASSES; c++) {
+                confusion[label][c] += res.predicted[c];
+            }
+            labelled += res.windows;
+            correct += res.correct;
+        } else {
+            std::printf("%-18s %-10s %3d %8zu %7zu %7s  %s\n", name.c_str(), "-", res.channels,
+                        res.samples, res.windows, "-", top_name);
+        }
+        total_samples += res.samples;
+        total_windows += res.windows;
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+
+    std::printf("\nconfusion (rows: label, columns: prediction)\n%-10s", "");
+    for (int c = 0; c < NUM_CLASSES; c++) {
+        std::printf(" %6.6s", gesture_names[c]);
+    }
+    std::printf("\n");
+    for (int r = 0; r < NUM_CLASSES; r++) {
+        std::printf("%-10s", gesture_names[r]);
+        for (int c = 0; c < NUM_CLASSES; c++) {
+            std::printf(" %6zu", confusion[r][c]);
+        }
+        std::printf("\n");
+    }
+
+    if (labelled > 0) {
+        std::printf("\naccuracy %.1f%% over %zu labelled windows\n", 100.0 * correct / labelled, labelled);
+    }
+    std::printf("%zu files, %.1f MB, %zu samples, %zu windows in %.3f s: %.0f windows/s, %.0f MB/s\n",
+                paths.size(), bytes / 1e6, total_samples, total_windows, seconds,
+                seconds > 0 ? total_windows / seconds : 0.0, seconds > 0 ? bytes / 1e6 / seconds : 0.0);
+    return 0;
+}
@@ -0,0 +1,54 @@
+#include "feature_batch.h"
+#include "emg_classifier.h"
+
+int32_t feature_batch_windows(int32_t n, int32_t window, int32_t step) {
+    if (window <= 0 || step <= 0 || n < window) {
+        return 0;
+    }
+    return (n - window) / step + 1;
+}
+
+int32_t extract_features_batch(const int16_t* samples, int32_t n, int32_t window, int32_t step,
+                               float* out) {
+    if (window != WINDOW_SIZE || step <= 0 || n < 0) {
+        return -1;
+    }
+
+    // Same running-sum path the firmware classifies with
+    EMG_Buffer buffer;
+    emg_buffer_init(&buffer);
+
+    int32_t windows = 0;
+    for (int32_t i = 0; i < n; i++) {
+        const int16_t* s = &samples[i * NUM_CHANNELS];
+        emg_buffer_add_sample(&buffer, s[0], s[1], s[2], s[3]);
+        int32_t start = i + 1 - WINDOW_SIZE;
+        if (start >= 0 && start % step == 0) {
+            emg_buffer_process_window(&buffer, &out[windows * TOTAL_FEATURES]);
+            windows++;
+        }
+    }
+    return windows;
+}
+
+void feature_batch_info(int32_t* window_size, int32_t* num_channels, int32_t* num_features) {
+    *window_size = WINDOW_SIZE;
+    *num_channels = NUM_CHANNELS;
+    *num_features = TOTAL_FEATURES;
+}
+
+int32_t feature_batch_prefilter(void) {
+    return EMG_PREFILTER;
+}
+
+int32_t feature_batch_spectral(void) {
+    return EMG_SPECTRAL_FEATURES;
+}
+
+void feature_batch_time_features(int32_t* mask, int32_t* zc_deadband, int32_t* ssc_threshold,
+                                 int32_t* wamp_threshold) {
+    *mask = EMG_TIME_FEATURES;
+    *zc_deadband = EMG_ZC_DEADBAND;
+    *ssc_threshold = EMG_SSC_THRESHOLD;
+    *wamp_threshold = EMG_WAMP_THRESHOLD;
+}
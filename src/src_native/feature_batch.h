@@ -0,0 +1,37 @@
+// Batch feature extraction for the Python trainers (ml/emg_features.py loads the
+// host shared library through ctypes)
+#ifndef FEATURE_BATCH_H
+#define FEATURE_BATCH_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Windows extract_features_batch() produces for n samples
+int32_t feature_batch_windows(int32_t n, int32_t window, int32_t step);
+
+// Streams samples ([n][NUM_CHANNELS], raw ADC counts) through the firmware prefilter
+// (EMG_PREFILTER) and sample ring
+// and writes the TOTAL_FEATURES float features of the window starting at every
+// multiple of step to out ([windows][TOTAL_FEATURES]). window must be WINDOW_SIZE.
+// Returns the number of windows written, or -1 for bad arguments.
+int32_t extract_features_batch(const int16_t* samples, int32_t n, int32_t window, int32_t step,
+                               float* out);
+
+// Compile-time sizes, so the caller can check it was built for the same firmware
+void feature_batch_info(int32_t* window_size, int32_t* num_channels, int32_t* num_features);
+// EMG_PREFILTER the features were computed with
+int32_t feature_batch_prefilter(void);
+// EMG_SPECTRAL_FEATURES: 1 when each channel's features end with the spectral block
+int32_t feature_batch_spectral(void);
+// EMG_TIME_FEATURES and the ZC, SSC and WAMP thresholds
+void feature_batch_time_features(int32_t* mask, int32_t* zc_deadband, int32_t* ssc_threshold,
+                                 int32_t* wamp_threshold);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FEATURE_BATCH_H
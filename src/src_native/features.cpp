@@ -0,0 +1,238 @@
+// Builds the training feature matrix from recordings on all cores. Files are parsed in
+// parallel, then every file is cut into chunks of windows that worker threads run
+// through extract_features_batch() straight into one preallocated matrix. The result
+// is written as X.npy (float32 [windows][TOTAL_FEATURES]) and y.npy (int32 [windows]),
+// which numpy can open with np.load(..., mmap_mode='r'). --verify recomputes every
+// file in one pass, as ml/emg_features.py streams it, and compares the bytes.
+#include "host_commands.h"
+#include "recording.h"
+#include "feature_batch.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+// Windows per work item: small enough to balance uneven files across threads. The
+// prefilter's state runs through the whole recording (as on the device and in
+// ml/emg_features.py), so with EMG_PREFILTER a file is a single work item.
+static const int32_t CHUNK_WINDOWS = 256;
+
+struct FeatureJob {
+    size_t file;
+    int32_t first_window;
+    int32_t windows;
+    size_t row;  // First output row
+};
+
+// Runs fn(i) for i in [0, count) on up to threads workers
+template <typename Fn>
+static void parallel_for(size_t count, unsigned threads, Fn fn) {
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t i = next++; i < count; i = next++) {
+            fn(i);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads && t < count; t++) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& t : pool) {
+        t.join();
+    }
+}
+
+// "rock2.txt=rock" or "k15_01.txt=3"; without "=" the label comes from the file name
+static int parse_label(const std::string& text) {
+    for (int i = 0; i < NUM_CLASSES; i++) {
+        if (text == gesture_names[i]) {
+            return i;
+        }
+    }
+    char* end;
+    long value = std::strtol(text.c_str(), &end, 10);
+    return (*end == '\0' && value >= 0 && value < NUM_CLASSES) ? (int)value : -1;
+}
+
+static bool write_npy(const std::string& path, const char* descr, const std::string& shape,
+                      const void* data, size_t bytes) {
+    std::string header = std::string("{'descr': '") + descr + "', 'fortran_order': False, 'shape': "
+                         + shape + ", }";
+    // Magic (6) + version (2) + length (2) + header, padded to 64 bytes and ending in '\n'
+    size_t total = 10 + header.size() + 1;
+    header.append((64 - total % 64) % 64, ' ');
+    header += '\n';
+
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) {
+        return false;
+    }
+    const uint16_t len = (uint16_t)header.size();
+    const unsigned char preamble[10] = { 0x93, 'N', 'U', 'M', 'P', 'Y', 1, 0,
+                                         (unsigned char)(len & 0xFF), (unsigned char)(len >> 8) };
+    bool ok = std::fwrite(preamble, 1, sizeof(preamble), f) == sizeof(preamble)
+              && std::fwrite(header.data(), 1, header.size(), f) == header.size()
+              && std::fwrite(data, 1, bytes, f) == bytes;
+    return std::fclose(f) == 0 && ok;
+}
+
+int cmd_features(int argc, char** argv) {
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    int32_t step = STEP_SIZE;
+    std::string out_dir;
+    bool verify = false;
+    int first = 0;
+    for (; first < argc && std::strncmp(argv[first], "--", 2) == 0; first++) {
+        if (std::strcmp(argv[first], "--threads") == 0 && first + 1 < argc) {
+            threads = (unsigned)std::max(1, std::atoi(argv[++first]));
+        } else if (std::strcmp(argv[first], "--step") == 0 && first + 1 < argc) {
+            step = std::max(1, std::atoi(argv[++first]));
+        } else if (std::strcmp(argv[first], "--out") == 0 && first + 1 < argc) {
+            out_dir = argv[++first];
+        } else if (std::strcmp(argv[first], "--verify") == 0) {
+            verify = true;
+        } else {
+            std::fprintf(stderr, "features: unknown option %s\n", argv[first]);
+            return 1;
+        }
+    }
+    if (out_dir.empty()) {
+        std::fprintf(stderr, "features: --out DIR is required\n");
+        return 1;
+    }
+
+    // Split off explicit labels before expanding directories
+    std::vector<std::string> paths;
+    std::vector<int> labels;
+    for (int i = first; i < argc; i++) {
+        std::string arg = argv[i];
+        size_t eq = arg.rfind('=');
+        int label = -2;
+        if (eq != std::string::npos) {
+            label = parse_label(arg.substr(eq + 1));
+            if (label < 0) {
+                std::fprintf(stderr, "features: unknown label in %s\n", argv[i]);
+                return 1;
+            }
+            arg.resize(eq);
+        }
+        char* one[] = { &arg[0] };
+        for (const std::string& path : expand_recording_paths(1, one)) {
+            paths.push_back(path);
+            labels.push_back(label >= -1 ? label : label_from_path(path));
+        }
+    }
+    if (paths.empty()) {
+        std::fprintf(stderr, "features: no recordings given\n");
+        return 1;
+    }
+
+    const Clock::time_point t0 = Clock::now();
+
+    std::vector<Recording> recs(paths.size());
+    std::vector<char> loaded(paths.size(), 0);
+    parallel_for(paths.size(), threads, [&](size_t i) {
+        loaded[i] = labels[i] >= 0 && load_recording(paths[i], recs[i]);
+    });
+    const Clock::time_point t1 = Clock::now();
+
+    std::vector<FeatureJob> jobs;
+    std::vector<size_t> file_row(recs.size(), 0);
+    size_t rows = 0, used = 0, bytes_samples = 0;
+    for (size_t i = 0; i < recs.size(); i++) {
+        if (labels[i] < 0) {
+            std::fprintf(stderr, "features: skipping %s (no label)\n", paths[i].c_str());
+            continue;
+        }
+        if (!loaded[i]) {
+            std::fprintf(stderr, "features: cannot read %s\n", paths[i].c_str());
+            return 1;
+        }
+        const int32_t windows = feature_batch_windows((int32_t)recs[i].frames.size(), WINDOW_SIZE, step);
+        const int32_t chunk = EMG_PREFILTER ? std::max(windows, 1) : CHUNK_WINDOWS;
+        file_row[i] = rows;
+        for (int32_t w = 0; w < windows; w += chunk) {
+            int32_t count = std::min(chunk, windows - w);
+            jobs.push_back({ i, w, count, rows });
+            rows += (size_t)count;
+        }
+        used++;
+        bytes_samples += recs[i].frames.size() * sizeof(EmgFrame);
+    }
+
+    std::vector<float> X(rows * TOTAL_FEATURES);
+    std::vector<int32_t> y(rows);
+    std::atomic<bool> failed(false);
+    parallel_for(jobs.size(), threads, [&](size_t j) {
+        const FeatureJob& job = jobs[j];
+        const Recording& rec = recs[job.file];
+        // Without the prefilter windows are independent, so a chunk only needs its own samples
+        const int16_t* samples = rec.frames[(size_t)job.first_window * step].ch;
+        int32_t n = (job.windows - 1) * step + WINDOW_SIZE;
+        if (extract_features_batch(samples, n, WINDOW_SIZE, step, &X[job.row * TOTAL_FEATURES])
+            != job.windows) {
+            failed = true;
+        }
+        std::fill(y.begin() + job.row, y.begin() + job.row + job.windows, labels[job.file]);
+    });
+    if (failed) {
+        std::fprintf(stderr, "features: extract_features_batch failed\n");
+        return 1;
+    }
+    const Clock::time_point t2 = Clock::now();
+
+    if (verify) {
+        size_t mismatched = 0;
+        for (size_t i = 0; i < recs.size(); i++) {
+            const Recording& rec = recs[i];
+            const int32_t windows = feature_batch_windows((int32_t)rec.frames.size(), WINDOW_SIZE, step);
+            if (labels[i] < 0 || windows == 0) {
+                continue;
+            }
+            std::vector<float> whole((size_t)windows * TOTAL_FEATURES);
+            extract_features_batch(rec.frames[0].ch, (int32_t)rec.frames.size(), WINDOW_SIZE, step, whole.data());
+            if (std::memcmp(whole.data(), &X[file_row[i] * TOTAL_FEATURES], whole.size() * sizeof(float)) != 0) {
+                std::fprintf(stderr, "features: %s differs from a single pass over the file\n", paths[i].c_str());
+                mismatched++;
+            }
+        }
+        std::printf("verify (EMG_PREFILTER %d): %zu of %zu recordings differ from a single pass\n", EMG_PREFILTER,
+                    mismatched, used);
+        if (mismatched > 0) {
+            return 1;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(out_dir, ec);
+    const std::string x_path = out_dir + "/X.npy";
+    const std::string y_path = out_dir + "/y.npy";
+    char shape[64];
+    std::snprintf(shape, sizeof(shape), "(%zu, %d)", rows, TOTAL_FEATURES);
+    if (!write_npy(x_path, "<f4", shape, X.data(), X.size() * sizeof(float))) {
+        std::fprintf(stderr, "features: cannot write %s\n", x_path.c_str());
+        return 1;
+    }
+    std::snprintf(shape, sizeof(shape), "(%zu,)", rows);
+    if (!write_npy(y_path, "<i4", shape, y.data(), y.size() * sizeof(int32_t))) {
+        std::fprintf(stderr, "features: cannot write %s\n", y_path.c_str());
+        return 1;
+    }
+
+    const double load_s = std::chrono::duration<double>(t1 - t0).count();
+    const double feat_s = std::chrono::duration<double>(t2 - t1).count();
+    std::printf("%zu recordings, %zu windows x %d features -> %s, %s\n", used, rows, TOTAL_FEATURES,
+                x_path.c_str(), y_path.c_str());
+    std::printf("%u threads: parse %.3f s, features %.3f s (%.0f windows/s, %zu jobs, %.1f MB of samples)\n",
+                threads, load_s, feat_s, feat_s > 0 ? rows / feat_s : 0.0, jobs.size(), bytes_samples / 1e6);
+    return 0;
+}
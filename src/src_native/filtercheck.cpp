@@ -0,0 +1,181 @@
+// Checks the prefilter (emg_filter.c): the designed response at DC, mains and the
+// EMG band, the fixed-point path against the float one on synthetic tones and on
+// the recordings, the cost of both per frame against their cycle budgets, and what
+// it does to the MAV and ZC features of every window.
+#include "host_commands.h"
+#include "recording.h"
+#include "emg_classifier.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+// Core clock the budgets are spent at (SystemClock_Config)
+static const double MCU_CLOCK_MHZ = 50.0;
+static const float response_hz[] = { 0, 2, 5, 20, 45, 50, 55, 100, 150, 300, 450, 600 };
+
+static double to_db(double gain) {
+    return 20.0 * std::log10(gain > 1e-9 ? gain : 1e-9);
+}
+
+// RMS of the fixed-point output over the last second of a 3 s tone of amplitude 1000
+// on a 1000-count offset, relative to the input
+static double measured_gain_q(const EmgFilterConfig& config, float freq_hz) {
+    EmgFilter filter;
+    emg_filter_init(&filter, &config);
+    const int n = 3 * SAMPLING_RATE_HZ;
+    double sum_sqr = 0.0;
+    for (int i = 0; i < n; i++) {
+        int16_t frame[NUM_CHANNELS];
+        int16_t v = (int16_t)std::lround(1000.0 + 1000.0 * std::sin(2.0 * M_PI * freq_hz * i / SAMPLING_RATE_HZ));
+        for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+            frame[ch] = v;
+        }
+        emg_filter_process_q(&filter, frame, frame);
+        if (i >= n - SAMPLING_RATE_HZ) {
+            sum_sqr += (double)frame[0] * frame[0];
+        }
+    }
+    return std::sqrt(sum_sqr / SAMPLING_RATE_HZ) / (1000.0 / std::sqrt(2.0));
+}
+
+struct ChannelEffect {
+    double mav[2] = {};
+    double zc[2] = {};
+};
+
+int cmd_filtercheck(int argc, char** argv) {
+    EmgFilterConfig config = EMG_FILTER_DEFAULTS;
+    std::vector<char*> paths;
+    for (int i = 0; i < argc; i++) {
+        if (std::strcmp(argv[i], "--band-pass") == 0) {
+            config = EmgFilterConfig EMG_FILTER_BAND_PASS_DEFAULTS;
+        } else if (std::strcmp(argv[i], "--notch-q") == 0 && i + 1 < argc) {
+            config.notch_q = (float)std::atof(argv[++i]);
+        } else {
+            paths.push_back(argv[i]);
+        }
+    }
+
+    EmgFilter design;
+    emg_filter_init(&design, &config);
+    int failures = 0;
+
+    std::printf("%u biquads per channel (EMG_PREFILTER %d in this build)\n", design.stages, EMG_PREFILTER);
+    std::printf("%8s %10s %10s\n", "Hz", "design dB", "Q30 dB");
+    for (float hz : response_hz) {
+        double design_db = to_db(emg_filter_gain(&design, hz));
+        if (hz == 0) {
+            std::printf("%8.0f %10.1f %10s\n", hz, design_db, "-");
+            continue;
+        }
+        double q_db = to_db(measured_gain_q(config, hz));
+        // The tone is rounded to whole counts, so a deep notch bottoms out near -60dB
+        bool ok = std::fabs(q_db - design_db) < 0.2 || (design_db < -50.0 && q_db < -50.0);
+        std::printf("%8.0f %10.1f %10.1f%s\n", hz, design_db, q_db, ok ? "" : "  FAIL");
+        failures += ok ? 0 : 1;
+    }
+    if (config.notch_hz > 0 && to_db(emg_filter_gain(&design, config.notch_hz)) > -30.0) {
+        std::printf("FAIL: notch is shallower than 30dB\n");
+        failures++;
+    }
+
+    // Float against fixed point, both fed the recordings
+    std::vector<Recording> recordings;
+    if (!paths.empty()) {
+        for (const std::string& path : expand_recording_paths((int)paths.size(), paths.data())) {
+            Recording rec;
+            if (!load_recording(path, rec)) {
+                std::fprintf(stderr, "filtercheck: cannot read %s\n", path.c_str());
+                return 1;
+            }
+            recordings.push_back(std::move(rec));
+        }
+    }
+
+    size_t frames = 0;
+    int max_diff = 0;
+    double sum_diff = 0.0;
+    double ns[2] = {};
+    ChannelEffect effect[NUM_CHANNELS];
+    size_t windows = 0;
+    const EmgDspThresholds thresholds = EMG_FEATURE_THRESHOLDS;
+    for (const Recording& rec : recordings) {
+        EmgFilter filter_f, filter_q;
+        emg_filter_init(&filter_f, &config);
+        emg_filter_init(&filter_q, &config);
+        std::vector<int16_t> out_f(rec.frames.size() * NUM_CHANNELS), out_q(out_f.size());
+
+        Clock::time_point t0 = Clock::now();
+        for (size_t i = 0; i < rec.frames.size(); i++) {
+            emg_filter_process_f(&filter_f, rec.frames[i].ch, &out_f[i * NUM_CHANNELS]);
+        }
+        Clock::time_point t1 = Clock::now();
+        for (size_t i = 0; i < rec.frames.size(); i++) {
+            emg_filter_process_q(&filter_q, rec.frames[i].ch, &out_q[i * NUM_CHANNELS]);
+        }
+        Clock::time_point t2 = Clock::now();
+        ns[0] += std::chrono::duration<double, std::nano>(t1 - t0).count();
+        ns[1] += std::chrono::duration<double, std::nano>(t2 - t1).count();
+        frames += rec.frames.size();
+
+        for (size_t i = 0; i < out_f.size(); i++) {
+            int d = std::abs(out_f[i] - out_q[i]);
+            max_diff = d > max_diff ? d : max_diff;
+            sum_diff += d;
+        }
+
+        // Features of the raw and the filtered windows at every hop
+        EMG_Buffer raw, filtered;
+        emg_buffer_init(&raw);
+        emg_buffer_init(&filtered);
+        for (size_t i = 0; i < rec.frames.size(); i++) {
+            emg_buffer_push(&raw, rec.frames[i].ch);
+            emg_buffer_push(&filtered, &out_f[i * NUM_CHANNELS]);
+            if ((i + 1) % HOP_SAMPLES != 0 || !raw.is_full) {
+                continue;
+            }
+            // ZC with this build's deadband, whether or not the model uses it
+            for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+                for (int k = 0; k < 2; k++) {
+                    EmgDspStats s;
+                    emg_dsp_channel_stats(emg_buffer_channel_window(k ? &filtered : &raw, ch), WINDOW_SIZE,
+                                          EMG_DSP_SUM_ABS | EMG_DSP_ZC, &thresholds, &s);
+                    effect[ch].mav[k] += (double)s.sum_abs / WINDOW_SIZE;
+                    effect[ch].zc[k] += s.zero_crossings;
+                }
+            }
+            windows++;
+        }
+    }
+
+    const double period_us = 1e6 / SAMPLING_RATE_HZ;
+    std::printf("\n%-12s %12s %14s %14s\n", "path", "host ns/frame", "budget cycles", "at 50MHz (us)");
+    for (int fixed = 0; fixed < 2; fixed++) {
+        uint32_t budget = emg_filter_budget_cycles(&design, fixed != 0);
+        std::printf("%-12s %12.1f %14u %9.2f (%.2f%% of a sample)\n", fixed ? "fixed Q30" : "float",
+                    frames ? ns[fixed] / frames : 0.0, budget, budget / MCU_CLOCK_MHZ,
+                    100.0 * budget / MCU_CLOCK_MHZ / period_us);
+    }
+
+    if (frames > 0) {
+        std::printf("\n%zu frames: float vs fixed point max %d LSB, mean %.3f LSB\n", frames, max_diff,
+                    sum_diff / (frames * NUM_CHANNELS));
+        if (max_diff > 2) {
+            std::printf("FAIL: the fixed-point path is more than 2 LSB off\n");
+            failures++;
+        }
+        std::printf("\nmean over %zu windows    MAV raw  MAV filt    ZC raw   ZC filt\n", windows);
+        for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+            std::printf("ch%d %26.1f %9.1f %9.1f %9.1f\n", ch + 1, effect[ch].mav[0] / windows,
+                        effect[ch].mav[1] / windows, effect[ch].zc[0] / windows, effect[ch].zc[1] / windows);
+        }
+    }
+
+    std::printf("\n%s\n", failures == 0 ? "all checks passed" : "CHECKS FAILED");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,242 @@
+#include "stm32f4xx_hal.h"
+#include "pca9685_sim.h"
+#include <string.h>
+
+GPIO_TypeDef host_gpioc;
+ADC_TypeDef host_adc1;
+TIM_TypeDef host_tim4;
+static DMA_Stream_TypeDef host_dma2_stream0;
+
+I2C_HandleTypeDef hi2c1;
+UART_HandleTypeDef huart1;
+DMA_HandleTypeDef hdma_adc1 = { &host_dma2_stream0 };
+ADC_HandleTypeDef hadc1 = { ADC1, &hdma_adc1 };
+TIM_HandleTypeDef htim3;
+
+// Circular ADC DMA target set by HAL_ADC_Start_DMA
+static uint16_t *adc_dma_data = NULL;
+static uint32_t adc_dma_length = 0;
+
+static uint32_t sim_tick_ms = 0;
+static FILE *uart_sink = NULL;
+static uint32_t uart_tx_error_every = 0;
+static uint32_t uart_tx_count = 0;
+
+void hal_shim_set_tick(uint32_t tick_ms) {
+    sim_tick_ms = tick_ms;
+}
+
+void hal_shim_set_uart_sink(FILE *sink) {
+    uart_sink = sink;
+}
+
+void hal_shim_uart_tx_error_every(uint32_t n) {
+    uart_tx_error_every = n;
+    uart_tx_count = 0;
+}
+
+int hal_shim_printf(const char *format, ...) {
+    (void)format;
+    return 0;
+}
+
+uint32_t HAL_GetTick(void) {
+    return sim_tick_ms;
+}
+
+void HAL_Delay(uint32_t Delay) {
+    sim_tick_ms += Delay;
+}
+
+HAL_StatusTypeDef HAL_ADC_Start_DMA(ADC_HandleTypeDef *hadc, uint32_t *pData, uint32_t Length) {
+    adc_dma_data = (uint16_t *)pData;
+    adc_dma_length = Length;
+    hadc->DMA_Handle->Instance->NDTR = Length;
+    return HAL_OK;
+}
+
+__attribute__((weak)) void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef *hadc) {
+    (void)hadc;
+}
+
+__attribute__((weak)) void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc) {
+    (void)hadc;
+}
+
+void hal_shim_adc_scan(const uint16_t *values, int channels) {
+    if (adc_dma_data == NULL) {
+        return;
+    }
+    DMA_Stream_TypeDef *stream = hadc1.DMA_Handle->Instance;
+    for (int i = 0; i < channels; i++) {
+        uint32_t pos = adc_dma_length - stream->NDTR;
+        adc_dma_data[pos] = values[i];
+        stream->NDTR--;
+        if (pos + 1 == adc_dma_length / 2) {
+            HAL_ADC_ConvHalfCpltCallback(&hadc1);
+        } else if (stream->NDTR == 0) {
+            stream->NDTR = adc_dma_length;  // Circular mode reload
+            HAL_ADC_ConvCpltCallback(&hadc1);
+        }
+    }
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState) {
+    if (PinState == GPIO_PIN_SET) {
+        GPIOx->ODR |= GPIO_Pin;
+    } else {
+        GPIOx->ODR &= ~(uint32_t)GPIO_Pin;
+    }
+}
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin) {
+    GPIOx->ODR ^= GPIO_Pin;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size,
+                                    uint32_t Timeout) {
+    (void)huart;
+    (void)Timeout;
+    if (uart_sink) {
+        fwrite(pData, 1, Size, uart_sink);
+    }
+    return HAL_OK;
+}
+
+// Nothing is ever received on the host
+HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size) {
+    (void)huart;
+    (void)pData;
+    (void)Size;
+    return HAL_OK;
+}
+
+__attribute__((weak)) void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart) {
+    (void)huart;
+}
+
+__attribute__((weak)) void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart) {
+    (void)huart;
+}
+
+// The DMA transfer completes (or fails) at once; as in the HAL, gState is READY
+// again before either callback runs
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size) {
+    if (huart->gState == HAL_UART_STATE_BUSY_TX) {
+        return HAL_BUSY;
+    }
+    huart->gState = HAL_UART_STATE_BUSY_TX;
+    if (uart_tx_error_every != 0 && ++uart_tx_count % uart_tx_error_every == 0) {
+        huart->gState = HAL_UART_STATE_READY;
+        HAL_UART_ErrorCallback(huart);
+        return HAL_OK;
+    }
+    HAL_UART_Transmit(huart, pData, Size, 0);
+    huart->gState = HAL_UART_STATE_READY;
+    HAL_UART_TxCpltCallback(huart);
+    return HAL_OK;
+}
+
+__attribute__((weak)) void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart) {
+    (void)huart;
+}
+
+// The I2C bus has one device on it, the PCA9685 model (pca9685_sim.c)
+HAL_StatusTypeDef HAL_I2C_Mem_Write(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress,
+                                    uint16_t MemAddSize, uint8_t *pData, uint16_t Size, uint32_t Timeout) {
+    (void)hi2c;
+    (void)Timeout;
+    if (MemAddSize != I2C_MEMADD_SIZE_8BIT) {
+        return HAL_ERROR;
+    }
+    return pca9685_sim_write(DevAddress, (uint8_t)MemAddress, pData, Size) ? HAL_OK : HAL_ERROR;
+}
+
+// The DMA transfer completes at once; a NACK arrives as the error callback, as on
+// the MCU where it is detected in the I2C interrupt
+HAL_StatusTypeDef HAL_I2C_Mem_Write_DMA(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress,
+                                        uint16_t MemAddSize, uint8_t *pData, uint16_t Size) {
+    if (HAL_I2C_Mem_Write(hi2c, DevAddress, MemAddress, MemAddSize, pData, Size, 0) == HAL_OK) {
+        HAL_I2C_MemTxCpltCallback(hi2c);
+    } else {
+        HAL_I2C_ErrorCallback(hi2c);
+    }
+    return HAL_OK;
+}
+
+__attribute__((weak)) void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c) {
+    (void)hi2c;
+}
+
+__attribute__((weak)) void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c) {
+    (void)hi2c;
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Read(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress,
+                                   uint16_t MemAddSize, uint8_t *pData, uint16_t Size, uint32_t Timeout) {
+    (void)hi2c;
+    (void)Timeout;
+    if (MemAddSize != I2C_MEMADD_SIZE_8BIT) {
+        return HAL_ERROR;
+    }
+    return pca9685_sim_read(DevAddress, (uint8_t)MemAddress, pData, Size) ? HAL_OK : HAL_ERROR;
+}
+
+#define FLASH_SIZE (256U * 1024U)
+#define FLASH_SECTORS 6
+
+static const uint32_t flash_sector_start[FLASH_SECTORS + 1] = {
+    0x00000, 0x04000, 0x08000, 0x0C000, 0x10000, 0x20000, FLASH_SIZE,
+};
+static uint8_t flash_mem[FLASH_SIZE];
+static bool flash_erased_at_start = false;
+static bool flash_locked = true;
+
+static uint8_t *flash_at(uint32_t address, uint32_t size) {
+    if (!flash_erased_at_start) {
+        memset(flash_mem, 0xFF, sizeof(flash_mem));
+        flash_erased_at_start = true;
+    }
+    if (address < FLASH_BASE || address - FLASH_BASE + size > FLASH_SIZE) {
+        return NULL;
+    }
+    return &flash_mem[address - FLASH_BASE];
+}
+
+const void *hal_shim_flash_ptr(uint32_t address) {
+    return flash_at(address, 1);
+}
+
+HAL_StatusTypeDef HAL_FLASH_Unlock(void) {
+    flash_locked = false;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Lock(void) {
+    flash_locked = true;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef *pEraseInit, uint32_t *SectorError) {
+    *SectorError = 0xFFFFFFFFU;
+    if (flash_locked || pEraseInit->Sector + pEraseInit->NbSectors > FLASH_SECTORS) {
+        return HAL_ERROR;
+    }
+    for (uint32_t s = pEraseInit->Sector; s < pEraseInit->Sector + pEraseInit->NbSectors; s++) {
+        uint32_t size = flash_sector_start[s + 1] - flash_sector_start[s];
+        memset(flash_at(FLASH_BASE + flash_sector_start[s], size), 0xFF, size);
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Program(uint32_t TypeProgram, uint32_t Address, uint64_t Data) {
+    uint8_t *cell = flash_at(Address, 4);
+    if (flash_locked || TypeProgram != FLASH_TYPEPROGRAM_WORD || cell == NULL || (Address & 3U) != 0) {
+        return HAL_ERROR;
+    }
+    uint32_t word;
+    memcpy(&word, cell, 4);
+    word &= (uint32_t)Data;
+    memcpy(cell, &word, 4);
+    return HAL_OK;
+}
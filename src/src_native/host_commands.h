@@ -0,0 +1,20 @@
+// Sub-commands of the native emg_host tool
+#ifndef HOST_COMMANDS_H
+#define HOST_COMMANDS_H
+
+int cmd_replay(int argc, char** argv);
+int cmd_qcheck(int argc, char** argv);
+int cmd_dspcheck(int argc, char** argv);
+int cmd_filtercheck(int argc, char** argv);
+int cmd_decimcheck(int argc, char** argv);
+int cmd_queuestress(int argc, char** argv);
+int cmd_modelbench(int argc, char** argv);
+int cmd_eval(int argc, char** argv);
+int cmd_features(int argc, char** argv);
+int cmd_pipebench(int argc, char** argv);
+int cmd_drift(int argc, char** argv);
+int cmd_calibrate(int argc, char** argv);
+int cmd_servosim(int argc, char** argv);
+int cmd_pcasim(int argc, char** argv);
+
+#endif // HOST_COMMANDS_H
@@ -0,0 +1,60 @@
+// emg_host: runs the firmware EMG pipeline on a workstation (pio run -e native)
+#include "host_commands.h"
+#include <cstdio>
+#include <cstring>
+
+struct Command {
+    const char* name;
+    int (*run)(int argc, char** argv);
+    const char* help;
+};
+
+static const Command commands[] = {
+    { "replay", cmd_replay, "[--realtime] [--events] [--verify] [--trace] [--stall MS] [--uart]\n"
+               "           [--telemetry FILE] [--tx-errors N] [--no-validate] [--accept P]\n"
+               "           [--reject P] [--evidence E] [--decay D] <recording|dir>...\n"
+               "           replay through the acquisition path and classifier" },
+    { "eval", cmd_eval, "<recording|dir>...  accuracy and confusion of the firmware features per file" },
+    { "features", cmd_features, "[--threads N] [--step N] [--verify] --out DIR <recording[=label]|dir>...\n"
+                 "           X.npy/y.npy training matrix on all cores" },
+    { "drift", cmd_drift, "[--minutes M] [--gesture S] [--rest S] [--offset LSB] [--gain PCT] [--blocks N]\n"
+              "           [--alpha A] [--lock N] [--gate K] [--max-shift K] [--max-gain G] [--no-validate]\n"
+              "           <recording|dir>...\n"
+              "           long drifting session with and without the feature normaliser" },
+    { "pipebench", cmd_pipebench, "<recording|dir>...  compare window/step/channel/feature configurations" },
+    { "calibrate", cmd_calibrate, "[--fit lda|centroid] [--trials N] [--channels N] <recording|dir>...\n"
+                  "           on-device calibration fed from recordings, scored on held-out halves" },
+    { "servosim", cmd_servosim, "[--speed DEG_S] [--thumb-speed DEG_S] [--accel DEG_S2] [--stagger MS]\n"
+                 "           [--hold MS] [--csv FILE] [gesture[:hold_ms]]...\n"
+                 "           finger trajectories per PWM frame vs jumping to the pose" },
+    { "pcasim", cmd_pcasim, "  pulse widths and I2C bus time per gesture on the PCA9685 register model" },
+    { "qcheck", cmd_qcheck, "<recording|dir>...  compare float and fixed-point classes on every window" },
+    { "dspcheck", cmd_dspcheck, "[recording|dir]...  check the packed window kernels and running sums" },
+    { "filtercheck", cmd_filtercheck, "[--band-pass] [--notch-q Q] [recording|dir]...\n"
+                    "           prefilter response, fixed vs float, cost and effect on MAV/ZC" },
+    { "decimcheck", cmd_decimcheck, "[--factor R] [--order N] [--no-comp] [--noise LSB]\n"
+                   "           ADC decimator vs direct convolution, response, aliasing, noise and cost" },
+    { "queuestress", cmd_queuestress, "[--frames N] [--pop N]  two-thread stress test of the ADC frame queue" },
+    { "modelbench", cmd_modelbench, "<recording|dir>...  latency and memory of the LR, LDA and MLP runtimes" },
+};
+
+static void usage(void) {
+    std::printf("usage: emg_host <command> [args]\n\n");
+    for (const Command& c : commands) {
+        std::printf("  %-8s %s\n", c.name, c.help);
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage();
+        return 1;
+    }
+    for (const Command& c : commands) {
+        if (std::strcmp(argv[1], c.name) == 0) {
+            return c.run(argc - 2, argv + 2);
+        }
+    }
+    usage();
+    return 1;
+}
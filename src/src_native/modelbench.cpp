@@ -0,0 +1,128 @@
+// Times model_runtime.c for each model type on the feature vectors of the given
+// recordings and reports flash/stack use. The exported model (emg_model.c) is also
+// scored against the labels in the file names; the other entries use random weights
+// of the same shape, so only their latency and memory are meaningful.
+#include "host_commands.h"
+#include "recording.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+struct SyntheticModel {
+    ModelDescriptor desc;
+    std::vector<float> weights, bias, out_weights, out_bias;
+};
+
+static void random_fill(std::vector<float>& v, size_t n, std::mt19937& rng) {
+    std::normal_distribution<float> dist(0.0f, 0.5f);
+    v.resize(n);
+    for (float& x : v) {
+        x = dist(rng);
+    }
+}
+
+static SyntheticModel synthetic_model(ModelType type, uint16_t hidden, std::mt19937& rng) {
+    SyntheticModel m;
+    uint16_t rows = type == MODEL_MLP ? hidden : NUM_CLASSES;
+    random_fill(m.weights, (size_t)rows * NUM_FEATURES, rng);
+    random_fill(m.bias, rows, rng);
+    if (type == MODEL_MLP) {
+        random_fill(m.out_weights, (size_t)NUM_CLASSES * hidden, rng);
+        random_fill(m.out_bias, NUM_CLASSES, rng);
+    }
+    m.desc = emg_model_descriptor;
+    m.desc.type = type;
+    m.desc.num_hidden = type == MODEL_MLP ? hidden : 0;
+    m.desc.weights = m.weights.data();
+    m.desc.bias = m.bias.data();
+    m.desc.out_weights = type == MODEL_MLP ? m.out_weights.data() : nullptr;
+    m.desc.out_bias = type == MODEL_MLP ? m.out_bias.data() : nullptr;
+    return m;
+}
+
+static double time_model(const ModelDescriptor* model, const std::vector<float>& features,
+                         size_t windows, std::vector<int>& classes) {
+    const int rounds = 20;
+    classes.assign(windows, 0);
+    Clock::time_point t0 = Clock::now();
+    for (int r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < windows; i++) {
+            classes[i] = model_predict(model, &features[i * TOTAL_FEATURES], nullptr);
+        }
+    }
+    return std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / (rounds * windows);
+}
+
+int cmd_modelbench(int argc, char** argv) {
+    std::vector<std::string> paths = expand_recording_paths(argc, argv);
+    if (paths.empty()) {
+        std::fprintf(stderr, "modelbench: no recordings given\n");
+        return 1;
+    }
+
+    // Features at every hop, as the firmware sees them
+    std::vector<float> features;
+    std::vector<int> labels;
+    for (const std::string& path : paths) {
+        Recording rec;
+        if (!load_recording(path, rec)) {
+            std::fprintf(stderr, "modelbench: cannot read %s\n", path.c_str());
+            return 1;
+        }
+        EMG_Buffer buffer;
+        emg_buffer_init(&buffer);
+        float f[TOTAL_FEATURES];
+        for (size_t i = 0; i < rec.frames.size(); i++) {
+            const EmgFrame& frame = rec.frames[i];
+            emg_buffer_add_sample(&buffer, frame.ch[0], frame.ch[1], frame.ch[2], frame.ch[3]);
+            if ((i + 1) % HOP_SAMPLES == 0 && emg_buffer_process_window(&buffer, f)) {
+                features.insert(features.end(), f, f + TOTAL_FEATURES);
+                labels.push_back(rec.label);
+            }
+        }
+    }
+    const size_t windows = labels.size();
+    if (windows == 0) {
+        std::fprintf(stderr, "modelbench: recordings too short for a window\n");
+        return 1;
+    }
+
+    std::mt19937 rng(1);
+    std::vector<SyntheticModel> synthetic;
+    synthetic.push_back(synthetic_model(MODEL_LR, 0, rng));
+    synthetic.push_back(synthetic_model(MODEL_LDA, 0, rng));
+    for (uint16_t hidden : { 8, 16, 32, 64 }) {
+        synthetic.push_back(synthetic_model(MODEL_MLP, hidden, rng));
+    }
+
+    std::printf("%zu windows from %zu recordings\n\n", windows, paths.size());
+    std::printf("model        hidden   ns/window   flash(B)   stack(B)   accuracy\n");
+
+    std::vector<int> classes;
+    const ModelDescriptor* exported = &emg_model_descriptor;
+    double ns = time_model(exported, features, windows, classes);
+    size_t labelled = 0, correct = 0;
+    for (size_t i = 0; i < windows; i++) {
+        if (labels[i] >= 0) {
+            labelled++;
+            correct += classes[i] == labels[i] ? 1 : 0;
+        }
+    }
+    char accuracy[16] = "-";
+    if (labelled > 0) {
+        std::snprintf(accuracy, sizeof(accuracy), "%.1f%%", 100.0 * correct / labelled);
+    }
+    std::printf("%-4s (emg)   %6u %11.1f %10u %10u %10s\n", model_type_name(exported->type),
+                exported->num_hidden, ns, model_param_bytes(exported), model_scratch_bytes(exported),
+                accuracy);
+
+    for (const SyntheticModel& m : synthetic) {
+        ns = time_model(&m.desc, features, windows, classes);
+        std::printf("%-4s (rand)  %6u %11.1f %10u %10u %10s\n", model_type_name(m.desc.type),
+                    m.desc.num_hidden, ns, model_param_bytes(&m.desc), model_scratch_bytes(&m.desc), "-");
+    }
+    return 0;
+}
@@ -0,0 +1,230 @@
+#include "pca9685_sim.h"
+#include "pca9685.h"
+#include <string.h>
+
+#define REG_ALL_LED_ON_L 0xFA
+#define REG_ALL_LED_OFF_H 0xFD
+#define REG_LED_LAST (PCA9685_LED0_ON_L + 4 * PCA9685_NUM_CHANNELS - 1)
+#define LED_FULL_BIT 0x10  // Bit 4 of LEDn_ON_H / LEDn_OFF_H
+
+// The oscillator needs 500us after SLEEP is cleared before RESTART is honoured;
+// the shim clock has 1ms resolution, so it has to be a later tick
+#define WAKE_TICKS 1
+
+static uint8_t regs[256];
+static bool halted[PCA9685_NUM_CHANNELS];  // Off after sleep until RESTART or rewritten
+static uint32_t wake_tick;
+static bool powered = false;
+
+static Pca9685SimBusStats bus;
+static Pca9685SimTransaction log_entries[PCA9685_SIM_LOG_SIZE];
+static uint32_t log_count;
+
+void pca9685_sim_clear_bus(void) {
+    memset(&bus, 0, sizeof(bus));
+    log_count = 0;
+}
+
+void pca9685_sim_reset(void) {
+    memset(regs, 0, sizeof(regs));
+    regs[PCA9685_MODE1_REG] = PCA9685_SLEEP | PCA9685_ALLCALL;
+    regs[PCA9685_MODE2_REG] = 0x04;  // OUTDRV
+    regs[0x02] = 0xE2;               // SUBADR1..3, ALLCALLADR
+    regs[0x03] = 0xE4;
+    regs[0x04] = 0xE8;
+    regs[0x05] = 0xE0;
+    for (int ch = 0; ch < PCA9685_NUM_CHANNELS; ch++) {
+        regs[PCA9685_LED0_OFF_H + 4 * ch] = LED_FULL_BIT;
+        halted[ch] = false;
+    }
+    regs[PCA9685_PRESCALE_REG] = 0x1E;
+    wake_tick = 0;
+    powered = true;
+    pca9685_sim_clear_bus();
+}
+
+static void power_on(void) {
+    if (!powered) {
+        pca9685_sim_reset();
+    }
+}
+
+static bool channel_active(int ch) {
+    return !(regs[PCA9685_LED0_OFF_H + 4 * ch] & LED_FULL_BIT)
+           && (regs[PCA9685_LED0_ON_H + 4 * ch] & LED_FULL_BIT
+               || regs[PCA9685_LED0_OFF_L + 4 * ch] != 0 || (regs[PCA9685_LED0_OFF_H + 4 * ch] & 0x0F) != 0);
+}
+
+static void write_mode1(uint8_t value) {
+    uint8_t old = regs[PCA9685_MODE1_REG];
+    bool was_asleep = old & PCA9685_SLEEP;
+    bool asleep = value & PCA9685_SLEEP;
+
+    // RESTART reads back as set when PWM was running at sleep; writing 1 clears it
+    // and resumes the halted channels, writing 0 leaves it alone
+    uint8_t restart = old & PCA9685_RESTART;
+    if (!was_asleep && asleep) {
+        for (int ch = 0; ch < PCA9685_NUM_CHANNELS; ch++) {
+            if (channel_active(ch)) {
+                halted[ch] = true;
+                restart = PCA9685_RESTART;
+            }
+        }
+    } else if (was_asleep && !asleep) {
+        wake_tick = HAL_GetTick();
+    }
+    if ((value & PCA9685_RESTART) && restart && !asleep && !was_asleep
+        && HAL_GetTick() - wake_tick >= WAKE_TICKS) {
+        memset(halted, 0, sizeof(halted));
+        restart = 0;
+    }
+    regs[PCA9685_MODE1_REG] = (uint8_t)((value & ~PCA9685_RESTART) | restart);
+}
+
+static void write_register(uint8_t reg, uint8_t value) {
+    if (reg == PCA9685_MODE1_REG) {
+        write_mode1(value);
+    } else if (reg == PCA9685_PRESCALE_REG) {
+        // Blocked unless SLEEP is set; values below 3 are clamped to 3
+        if (regs[PCA9685_MODE1_REG] & PCA9685_SLEEP) {
+            regs[reg] = value < 3 ? 3 : value;
+        }
+    } else if (reg >= REG_ALL_LED_ON_L && reg <= REG_ALL_LED_OFF_H) {
+        for (int ch = 0; ch < PCA9685_NUM_CHANNELS; ch++) {
+            regs[PCA9685_LED0_ON_L + 4 * ch + (reg - REG_ALL_LED_ON_L)] = value;
+            halted[ch] = false;
+        }
+    } else if (reg <= REG_LED_LAST) {
+        regs[reg] = value;
+        if (reg >= PCA9685_LED0_ON_L) {
+            halted[(reg - PCA9685_LED0_ON_L) / 4] = false;
+        }
+    }
+    // 0x46..0xF9 are reserved and 0xFF is test mode: ignored
+}
+
+static uint8_t read_register(uint8_t reg) {
+    if (reg >= REG_ALL_LED_ON_L && reg <= REG_ALL_LED_OFF_H) {
+        return 0;  // ALL_LED reads back as zero
+    }
+    return regs[reg];
+}
+
+// Without AI every byte of a burst goes to the same register
+static uint8_t next_register(uint8_t reg) {
+    return (regs[PCA9685_MODE1_REG] & PCA9685_AI) ? (uint8_t)(reg + 1) : reg;
+}
+
+static void log_transaction(bool write, bool ok, uint8_t reg, uint16_t size) {
+    Pca9685SimTransaction t;
+    t.write = write;
+    t.ok = ok;
+    t.reg = reg;
+    t.data_bytes = ok ? size : 0;
+    // A NACKed address ends the transfer after the first byte. Reads re-address
+    // after the register byte: START addr reg, repeated START addr data..., STOP.
+    if (!ok) {
+        t.wire_bytes = 1;
+        t.bus_events = 2;
+    } else {
+        t.wire_bytes = (uint16_t)(size + (write ? 2 : 3));
+        t.bus_events = write ? 2 : 3;
+    }
+
+    bus.transactions++;
+    bus.nacks += ok ? 0 : 1;
+    bus.data_bytes += t.data_bytes;
+    bus.wire_bytes += t.wire_bytes;
+    bus.bus_events += t.bus_events;
+    if (log_count < PCA9685_SIM_LOG_SIZE) {
+        log_entries[log_count++] = t;
+    }
+}
+
+bool pca9685_sim_write(uint16_t dev_address, uint8_t reg, const uint8_t *data, uint16_t size) {
+    power_on();
+    bool ok = dev_address == (PCA9685_I2C_ADDRESS << 1);
+    log_transaction(true, ok, reg, size);
+    if (!ok) {
+        return false;
+    }
+    for (uint16_t i = 0; i < size; i++) {
+        write_register(reg, data[i]);
+        reg = next_register(reg);
+    }
+    return true;
+}
+
+bool pca9685_sim_read(uint16_t dev_address, uint8_t reg, uint8_t *data, uint16_t size) {
+    power_on();
+    bool ok = dev_address == (PCA9685_I2C_ADDRESS << 1);
+    log_transaction(false, ok, reg, size);
+    if (!ok) {
+        return false;
+    }
+    for (uint16_t i = 0; i < size; i++) {
+        data[i] = read_register(reg);
+        reg = next_register(reg);
+    }
+    return true;
+}
+
+uint8_t pca9685_sim_register(uint8_t reg) {
+    power_on();
+    return regs[reg];
+}
+
+bool pca9685_sim_sleeping(void) {
+    power_on();
+    return (regs[PCA9685_MODE1_REG] & PCA9685_SLEEP) != 0;
+}
+
+double pca9685_sim_frequency(void) {
+    power_on();
+    return PCA9685_SIM_OSC_HZ / (4096.0 * (regs[PCA9685_PRESCALE_REG] + 1));
+}
+
+double pca9685_sim_pulse_us(int channel) {
+    power_on();
+    if (channel < 0 || channel >= PCA9685_NUM_CHANNELS || pca9685_sim_sleeping() || halted[channel]) {
+        return 0.0;
+    }
+    const uint8_t *led = &regs[PCA9685_LED0_ON_L + 4 * channel];
+    double period_us = 1e6 / pca9685_sim_frequency();
+    if (led[3] & LED_FULL_BIT) {
+        return 0.0;  // Full off wins over full on
+    }
+    if (led[1] & LED_FULL_BIT) {
+        return period_us;
+    }
+    int on = led[0] | ((led[1] & 0x0F) << 8);
+    int off = led[2] | ((led[3] & 0x0F) << 8);
+    return ((off - on) & 0x0FFF) * period_us / 4096.0;
+}
+
+int pca9685_sim_off_count(int channel) {
+    power_on();
+    if (channel < 0 || channel >= PCA9685_NUM_CHANNELS) {
+        return -1;
+    }
+    const uint8_t *led = &regs[PCA9685_LED0_ON_L + 4 * channel];
+    if (led[0] != 0 || led[1] != 0 || (led[3] & LED_FULL_BIT)) {
+        return -1;
+    }
+    return led[2] | ((led[3] & 0x0F) << 8);
+}
+
+const Pca9685SimBusStats *pca9685_sim_bus(void) {
+    return &bus;
+}
+
+uint32_t pca9685_sim_log(const Pca9685SimTransaction **log) {
+    *log = log_entries;
+    return log_count;
+}
+
+double pca9685_sim_bus_time_us(const Pca9685SimBusStats *stats, uint32_t bus_hz) {
+    // 9 clocks per byte (8 data + ACK), about one per START/STOP condition
+    double clocks = 9.0 * stats->wire_bytes + stats->bus_events;
+    return clocks * 1e6 / bus_hz;
+}
@@ -0,0 +1,65 @@
+// Register-level PCA9685 behind the HAL I2C shim. HAL_I2C_Mem_Write/Mem_Read/
+// Mem_Write_DMA to its address land here; other addresses NACK. Models MODE1
+// (SLEEP, RESTART, AI), PRE_SCALE (only writable while asleep), the LEDn and
+// ALL_LED registers with their full-on/full-off bits, and logs every transaction
+// with the bytes it puts on the wire.
+#ifndef PCA9685_SIM_H
+#define PCA9685_SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PCA9685_SIM_OSC_HZ 25000000.0
+#define PCA9685_SIM_LOG_SIZE 256
+
+typedef struct {
+    bool write;
+    bool ok;            // Acknowledged
+    uint8_t reg;
+    uint16_t data_bytes;
+    uint16_t wire_bytes;  // Address, register and data bytes, each 8 bits + ACK
+    uint8_t bus_events;   // START, repeated START and STOP conditions
+} Pca9685SimTransaction;
+
+typedef struct {
+    uint32_t transactions;
+    uint32_t nacks;
+    uint32_t data_bytes;
+    uint32_t wire_bytes;
+    uint32_t bus_events;
+} Pca9685SimBusStats;
+
+// Power-on register state (asleep, all outputs full off, 200Hz prescale), empty log
+void pca9685_sim_reset(void);
+
+// Called by the HAL shim. dev_address is the 8-bit HAL form (7-bit address << 1).
+// Returns false (NACK) for other addresses.
+bool pca9685_sim_write(uint16_t dev_address, uint8_t reg, const uint8_t *data, uint16_t size);
+bool pca9685_sim_read(uint16_t dev_address, uint8_t reg, uint8_t *data, uint16_t size);
+
+uint8_t pca9685_sim_register(uint8_t reg);
+bool pca9685_sim_sleeping(void);
+// PWM frequency set by PRE_SCALE
+double pca9685_sim_frequency(void);
+// High time of a channel's output in microseconds: 0 while asleep, halted after
+// sleep (until RESTART or a write to the channel) or full off
+double pca9685_sim_pulse_us(int channel);
+// LEDn_OFF count with LEDn_ON = 0, or -1 if the channel is not a plain ON=0 pulse
+int pca9685_sim_off_count(int channel);
+
+// Totals since the last reset/clear, and the first PCA9685_SIM_LOG_SIZE transactions
+const Pca9685SimBusStats *pca9685_sim_bus(void);
+void pca9685_sim_clear_bus(void);
+uint32_t pca9685_sim_log(const Pca9685SimTransaction **log);
+// Time the logged traffic occupies an I2C bus clocked at bus_hz
+double pca9685_sim_bus_time_us(const Pca9685SimBusStats *stats, uint32_t bus_hz);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PCA9685_SIM_H
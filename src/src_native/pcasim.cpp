@@ -0,0 +1,146 @@
+// Actuation path against the register-level PCA9685 model: checks the start-up
+// sequence, sleep/restart, and that every gesture leaves exactly its pose's pulse
+// widths in the LEDn registers, then prices the I2C traffic each gesture costs at
+// the standard bus speeds.
+#include "host_commands.h"
+#include "pca9685_sim.h"
+#include "servo_motion.h"
+#include "gesture.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+static const uint32_t bus_speeds[] = { 100000, 400000, 1000000 };
+
+// Totals, or the mean over n
+static void print_bus(const char* label, const Pca9685SimBusStats* stats, int n = 1) {
+    std::printf("%-22s %5.1f %6.1f %6.1f", label, (double)stats->transactions / n,
+                (double)stats->data_bytes / n, (double)stats->wire_bytes / n);
+    for (uint32_t hz : bus_speeds) {
+        std::printf(" %9.1f", pca9685_sim_bus_time_us(stats, hz) / n);
+    }
+    std::printf("\n");
+}
+
+static void add_bus(Pca9685SimBusStats& total, const Pca9685SimBusStats& stats) {
+    total.transactions += stats.transactions;
+    total.nacks += stats.nacks;
+    total.data_bytes += stats.data_bytes;
+    total.wire_bytes += stats.wire_bytes;
+    total.bus_events += stats.bus_events;
+}
+
+static void print_bus_header(void) {
+    std::printf("%-22s %5s %6s %6s %9s %9s %9s\n", "", "xfers", "data", "wire", "100k(us)", "400k(us)",
+                "1M(us)");
+}
+
+// Sleep halts the outputs and sets RESTART; they resume only after RESTART is written
+static bool check_sleep_restart(void) {
+    double before = pca9685_sim_pulse_us(SERVO_THUMB_CHANNEL);
+    bool ok = PCA9685_Sleep(&pca9685, true) && pca9685_sim_pulse_us(SERVO_THUMB_CHANNEL) == 0.0
+              && (pca9685_sim_register(PCA9685_MODE1_REG) & PCA9685_RESTART);
+    ok = ok && PCA9685_Sleep(&pca9685, false) && pca9685_sim_pulse_us(SERVO_THUMB_CHANNEL) == 0.0;
+    HAL_Delay(1);
+    uint8_t mode1 = (uint8_t)(pca9685_sim_register(PCA9685_MODE1_REG) | PCA9685_RESTART);
+    ok = ok && HAL_I2C_Mem_Write(pca9685.hi2c, pca9685.address, PCA9685_MODE1_REG, I2C_MEMADD_SIZE_8BIT,
+                                 &mode1, 1, 100) == HAL_OK;
+    return ok && pca9685_sim_pulse_us(SERVO_THUMB_CHANNEL) == before
+           && !(pca9685_sim_register(PCA9685_MODE1_REG) & PCA9685_RESTART);
+}
+
+int cmd_pcasim(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    int failures = 0;
+
+    pca9685_sim_reset();
+    InitAllServos();
+    const HandPose rest_pose = { { SERVO_REST_ANGLE, SERVO_REST_ANGLE, SERVO_REST_ANGLE, SERVO_REST_ANGLE,
+                                   SERVO_REST_ANGLE } };
+    servo_motion_init(&servo_motion, NULL, &rest_pose);
+
+    const uint8_t mode1 = pca9685_sim_register(PCA9685_MODE1_REG);
+    const double freq = pca9685_sim_frequency();
+    const double period_us = 1e6 / freq;
+    std::printf("init: MODE1 0x%02X (%s, auto-increment %s), PRE_SCALE %u -> %.2f Hz\n", mode1,
+                pca9685_sim_sleeping() ? "asleep" : "awake", (mode1 & PCA9685_AI) ? "on" : "off",
+                pca9685_sim_register(PCA9685_PRESCALE_REG), freq);
+    if (pca9685_sim_sleeping() || !(mode1 & PCA9685_AI) || std::fabs(freq - SERVO_FRAME_HZ) > 0.5) {
+        std::printf("  FAIL: expected awake, auto-increment, %d Hz\n", SERVO_FRAME_HZ);
+        failures++;
+    }
+    print_bus_header();
+    print_bus("init + rest pose", pca9685_sim_bus());
+
+    bool restart_ok = check_sleep_restart();
+    std::printf("sleep/restart: %s\n\n", restart_ok ? "ok" : "FAIL");
+    failures += restart_ok ? 0 : 1;
+
+    std::printf("%-11s %-34s %6s\n", "gesture", "pulse us (thumb..pinky)", "check");
+    Pca9685SimBusStats ramp[NUM_CLASSES];
+    for (int g = 0; g < NUM_CLASSES; g++) {
+        pca9685_sim_clear_bus();
+        execute_gesture((GestureType)g);
+        for (int frame = 0; frame < 10 * SERVO_FRAME_HZ && servo_motion_active(&servo_motion) > 0; frame++) {
+            HandPose pose;
+            if (servo_motion_tick(&servo_motion, &pose)) {
+                SetHandPose(&pose);
+            }
+        }
+        ramp[g] = *pca9685_sim_bus();
+
+        // The registers must hold exactly the pose's pulses, ON = 0
+        char pulses[64];
+        int len = 0;
+        bool ok = servo_motion_active(&servo_motion) == 0;
+        for (int i = 0; i < SERVO_COUNT; i++) {
+            int channel = SERVO_THUMB_CHANNEL + i;
+            int expected = PCA9685_AngleToPulse(servo_motion.target[i]);
+            double us = pca9685_sim_pulse_us(channel);
+            ok = ok && pca9685_sim_off_count(channel) == expected
+                 && std::fabs(us - expected * period_us / 4096.0) < 1e-6;
+            len += std::snprintf(pulses + len, sizeof(pulses) - len, "%7.1f", us);
+        }
+        std::printf("%-11s %-34s %6s\n", gesture_names[g], pulses, ok ? "ok" : "FAIL");
+        failures += ok ? 0 : 1;
+    }
+
+    std::printf("\nI2C traffic per gesture, ramped over the PWM frames:\n");
+    print_bus_header();
+    for (int g = 0; g < NUM_CLASSES; g++) {
+        print_bus(gesture_names[g], &ramp[g]);
+    }
+
+    // Every gesture change as a single pose burst, with the shadow registers and
+    // with the shadow invalidated (all five channels, as before the shadow)
+    Pca9685SimBusStats full_total = {}, dirty_total = {};
+    int transitions = 0;
+    for (int from = 0; from < NUM_CLASSES; from++) {
+        for (int to = 0; to < NUM_CLASSES; to++) {
+            if (from == to) {
+                continue;
+            }
+            for (int pass = 0; pass < 2; pass++) {
+                const bool shadow = pass == 1;
+                SetHandPose(gesture_pose((GestureType)from));
+                if (!shadow) {
+                    pca9685.shadow_valid = 0;
+                }
+                pca9685_sim_clear_bus();
+                SetHandPose(gesture_pose((GestureType)to));
+                add_bus(shadow ? dirty_total : full_total, *pca9685_sim_bus());
+            }
+            transitions++;
+        }
+    }
+    std::printf("\nmean of the %d gesture changes as one burst:\n", transitions);
+    print_bus_header();
+    print_bus("all five channels", &full_total, transitions);
+    print_bus("dirty range", &dirty_total, transitions);
+    std::printf("PCA9685 bursts: %u written, %u skipped (unchanged), %u coalesced, %u errors\n",
+                pca9685.blocks_written, pca9685.blocks_skipped, pca9685.blocks_coalesced, pca9685.block_errors);
+
+    std::printf("\n%s\n", failures == 0 ? "all checks passed" : "CHECKS FAILED");
+    return failures == 0 ? 0 : 1;
+}
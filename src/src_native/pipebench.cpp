@@ -0,0 +1,266 @@
+// Runs several FeaturePipeline configurations side by side over the labelled
+// recordings: cost per sample and per hop, and a quick accuracy estimate from a
+// nearest-centroid classifier (standardised features, centroids from the first half
+// of every file, scored on the second half). The exported model only fits the
+// default configuration, so the estimate is for comparing configurations, not a
+// prediction of the trained model's accuracy. The "+spectral" rows append the
+// emg_spectrum block (EMG_SPECTRAL_FEATURES) to every channel; the ssc and wamp rows
+// use the thresholds of this build (EMG_SSC_THRESHOLD, EMG_WAMP_THRESHOLD).
+#include "host_commands.h"
+#include "recording.h"
+#include "feature_pipeline.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+using namespace emg_features;
+
+struct PipeResult {
+    double ns_per_sample = 0.0;
+    double ns_per_hop = 0.0;
+    size_t windows = 0;
+    double accuracy = 0.0;
+};
+
+// Nearest standardised class centroid, fitted on the first half of each file
+static double centroid_accuracy(const std::vector<float>& X, const std::vector<int>& y,
+                                const std::vector<bool>& train, int dims) {
+    const size_t n = y.size();
+    std::vector<double> mean(dims, 0.0), scale(dims, 0.0);
+    size_t n_train = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (!train[i]) continue;
+        n_train++;
+        for (int d = 0; d < dims; d++) mean[d] += X[i * dims + d];
+    }
+    if (n_train == 0 || n_train == n) return 0.0;
+    for (int d = 0; d < dims; d++) mean[d] /= n_train;
+    for (size_t i = 0; i < n; i++) {
+        if (!train[i]) continue;
+        for (int d = 0; d < dims; d++) {
+            double v = X[i * dims + d] - mean[d];
+            scale[d] += v * v;
+        }
+    }
+    for (int d = 0; d < dims; d++) {
+        scale[d] = std::sqrt(scale[d] / n_train);
+        if (scale[d] == 0.0) scale[d] = 1.0;
+    }
+
+    std::vector<double> centroid((size_t)NUM_CLASSES * dims, 0.0);
+    std::vector<size_t> count(NUM_CLASSES, 0);
+    for (size_t i = 0; i < n; i++) {
+        if (!train[i]) continue;
+        count[y[i]]++;
+        for (int d = 0; d < dims; d++) {
+            centroid[(size_t)y[i] * dims + d] += (X[i * dims + d] - mean[d]) / scale[d];
+        }
+    }
+    for (int c = 0; c < NUM_CLASSES; c++) {
+        for (int d = 0; d < dims && count[c] > 0; d++) centroid[(size_t)c * dims + d] /= count[c];
+    }
+
+    size_t tested = 0, correct = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (train[i]) continue;
+        int best = -1;
+        double best_dist = 0.0;
+        for (int c = 0; c < NUM_CLASSES; c++) {
+            if (count[c] == 0) continue;
+            double dist = 0.0;
+            for (int d = 0; d < dims; d++) {
+                double v = (X[i * dims + d] - mean[d]) / scale[d] - centroid[(size_t)c * dims + d];
+                dist += v * v;
+            }
+            if (best < 0 || dist < best_dist) {
+                best = c;
+                best_dist = dist;
+            }
+        }
+        tested++;
+        correct += best == y[i] ? 1 : 0;
+    }
+    return tested > 0 ? 100.0 * correct / tested : 0.0;
+}
+
+// A pipeline with the emg_spectrum block appended to each channel's features
+template <typename Pipeline>
+class WithSpectrum : public Pipeline {
+public:
+    static_assert(Pipeline::kWindow >= SPECTRUM_FFT_SIZE, "window shorter than the FFT");
+    static constexpr int kFeaturesPerChannel = Pipeline::kFeaturesPerChannel + SPECTRAL_FEATURES_PER_CHANNEL;
+    static constexpr int kFeatureCount = Pipeline::kChannels * kFeaturesPerChannel;
+
+    void features(float* out) const {
+        float time[Pipeline::kFeatureCount];
+        Pipeline::features(time);
+        for (int ch = 0; ch < Pipeline::kChannels; ch++) {
+            float* f = &out[ch * kFeaturesPerChannel];
+            std::memcpy(f, &time[ch * Pipeline::kFeaturesPerChannel], sizeof(float) * Pipeline::kFeaturesPerChannel);
+            emg_spectrum_features(this->channel_window(ch), Pipeline::kWindow, f + Pipeline::kFeaturesPerChannel);
+        }
+    }
+};
+
+// Feeds every sample and appends the features of every hop to X
+template <typename Pipeline>
+static void collect(Pipeline& pipeline, const std::vector<Recording>& recs, std::vector<float>& X,
+                    std::vector<int>& y, std::vector<bool>& train) {
+    float f[Pipeline::kFeatureCount];
+    for (const Recording& rec : recs) {
+        pipeline.reset();
+        size_t windows = 0;
+        for (const EmgFrame& frame : rec.frames) {
+            if (!pipeline.add_sample(frame.ch)) continue;
+            pipeline.features(f);
+            X.insert(X.end(), f, f + Pipeline::kFeatureCount);
+            y.push_back(rec.label);
+            windows++;
+        }
+        for (size_t i = 0; i < windows; i++) {
+            train.push_back(i < windows / 2);
+        }
+    }
+}
+
+// Default configuration against emg_buffer_process_window() at every hop (its
+// time-domain features; the spectral block, when built in, follows them per channel)
+static size_t c_api_mismatches(const std::vector<Recording>& recs) {
+    static DefaultFeaturePipeline pipeline;
+    static EMG_Buffer buffer;
+    float f[DefaultFeaturePipeline::kFeatureCount], c_features[TOTAL_FEATURES];
+    size_t mismatches = 0;
+    for (const Recording& rec : recs) {
+        pipeline.reset();
+        emg_buffer_init(&buffer);
+        for (const EmgFrame& frame : rec.frames) {
+            emg_buffer_add_sample(&buffer, frame.ch[0], frame.ch[1], frame.ch[2], frame.ch[3]);
+            if (!pipeline.add_sample(frame.ch)) continue;
+            pipeline.features(f);
+            emg_buffer_process_window(&buffer, c_features);
+            bool same = true;
+            for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+                same = same && std::memcmp(&f[ch * TIME_FEATURES_PER_CHANNEL], &c_features[ch * FEATURES_PER_CHANNEL],
+                                           sizeof(float) * TIME_FEATURES_PER_CHANNEL) == 0;
+            }
+            mismatches += same ? 0 : 1;
+        }
+    }
+    return mismatches;
+}
+
+template <typename Pipeline>
+static PipeResult run_pipeline(const std::vector<Recording>& recs) {
+    PipeResult res;
+    std::vector<float> X;
+    std::vector<int> y;
+    std::vector<bool> train;
+    size_t samples = 0;
+    for (const Recording& rec : recs) {
+        samples += rec.frames.size();
+    }
+
+    static Pipeline pipeline;
+    // Per-sample cost: the ring and running sums alone
+    size_t hops = 0;
+    Clock::time_point t0 = Clock::now();
+    for (const Recording& rec : recs) {
+        pipeline.reset();
+        for (const EmgFrame& frame : rec.frames) {
+            hops += pipeline.add_sample(frame.ch) ? 1 : 0;
+        }
+    }
+    double sample_ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+
+    // Per-hop cost: features from the sums, repeated on the last window
+    const int reps = 100000;
+    float f[Pipeline::kFeatureCount];
+    float sink = 0.0f;
+    t0 = Clock::now();
+    for (int i = 0; i < reps; i++) {
+        pipeline.features(f);
+        sink += f[i % Pipeline::kFeatureCount];
+    }
+    double hop_ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+
+    collect(pipeline, recs, X, y, train);
+    res.windows = y.size();
+    res.ns_per_sample = samples > 0 ? sample_ns / samples : 0.0;
+    res.ns_per_hop = (sink == sink && hops > 0) ? hop_ns / reps : 0.0;
+    res.accuracy = centroid_accuracy(X, y, train, Pipeline::kFeatureCount);
+    return res;
+}
+
+// "mav,rms,..." for a FEATURE_* mask
+static std::string feature_list(uint32_t mask) {
+    static const char* names[] = { "mav", "rms", "var", "wl", "zc", "ssc", "wamp" };
+    std::string list;
+    for (int i = 0; i < 7; i++) {
+        if (mask & (1u << i)) {
+            list += list.empty() ? names[i] : std::string(",") + names[i];
+        }
+    }
+    return list;
+}
+
+template <typename Pipeline>
+static PipeResult report(const char* features, const std::vector<Recording>& recs) {
+    PipeResult r = run_pipeline<Pipeline>(recs);
+    std::printf("%6d %6.1f %5d %5d %-16s %8zu %10.1f %8.1f %9u %8.1f", Pipeline::kWindow,
+                1000.0 * Pipeline::kWindow / SAMPLING_RATE_HZ, Pipeline::kStep, Pipeline::kChannels,
+                features, r.windows, r.ns_per_sample, r.ns_per_hop,
+                (unsigned)sizeof(Pipeline), r.accuracy);
+    std::printf("\n");
+    return r;
+}
+
+int cmd_pipebench(int argc, char** argv) {
+    std::vector<Recording> recs;
+    for (const std::string& path : expand_recording_paths(argc, argv)) {
+        Recording rec;
+        if (!load_recording(path, rec)) {
+            std::fprintf(stderr, "pipebench: cannot read %s\n", path.c_str());
+            return 1;
+        }
+        if (rec.label >= 0) {
+            recs.push_back(std::move(rec));
+        }
+    }
+    if (recs.empty()) {
+        std::fprintf(stderr, "pipebench: no labelled recordings given\n");
+        return 1;
+    }
+
+    std::printf("%zu labelled recordings; accuracy is a nearest-centroid estimate\n\n", recs.size());
+    std::printf("%6s %6s %5s %5s %-16s %8s %10s %8s %9s %8s\n", "window", "ms", "step", "ch",
+                "features", "windows", "ns/sample", "ns/hop", "state(B)", "acc%");
+    const std::string default_features = feature_list(EMG_TIME_FEATURES);
+    PipeResult time_only = report<DefaultFeaturePipeline>(default_features.c_str(), recs);
+    PipeResult spectral = report<WithSpectrum<DefaultFeaturePipeline>>("+spectral", recs);
+    report<WithSpectrum<FeaturePipeline<225, 75, 4, Mav, Rms, Var, Wl, Zc>>>("+spectral", recs);
+    report<FeaturePipeline<75, 25, 4, Mav, Rms, Var, Wl, Zc>>("mav,rms,var,wl,zc", recs);
+    report<FeaturePipeline<105, 35, 4, Mav, Rms, Var, Wl, Zc>>("mav,rms,var,wl,zc", recs);
+    report<FeaturePipeline<225, 75, 4, Mav, Rms, Var, Wl, Zc>>("mav,rms,var,wl,zc", recs);
+    report<FeaturePipeline<300, 100, 4, Mav, Rms, Var, Wl, Zc>>("mav,rms,var,wl,zc", recs);
+    report<FeaturePipeline<150, 50, 4, Mav, Wl>>("mav,wl", recs);
+    report<FeaturePipeline<150, 50, 4, Mav, Wl, Zc, Ssc>>("mav,wl,zc,ssc", recs);
+    report<FeaturePipeline<150, 50, 4, Mav, Rms, Var, Wl, Zc, Ssc, Wamp>>("all seven", recs);
+    report<FeaturePipeline<150, 50, 3, Mav, Rms, Var, Wl, Zc>>("mav,rms,var,wl,zc", recs);
+
+    // The host has no Cortex-M4 cycle counter: the device figure is the budget, checked
+    // against the trace "features" row when the firmware is built with the block
+    const double mcu_mhz = 50.0;
+    const uint32_t budget = NUM_CHANNELS * EMG_SPECTRUM_CYCLES_PER_CHANNEL;
+    std::printf("\nspectral block per window: %.1f ns on this host; M4 budget %u cycles = %.0f us at %.0f MHz "
+                "(%.1f%% of the %d ms hop)\n",
+                spectral.ns_per_hop - time_only.ns_per_hop, budget, budget / mcu_mhz, mcu_mhz,
+                100.0 * budget / mcu_mhz / (1000.0 * CLASSIFY_PERIOD_MS), CLASSIFY_PERIOD_MS);
+
+    size_t mismatches = c_api_mismatches(recs);
+    std::printf("\ndefault configuration vs the C API: %zu mismatching windows\n", mismatches);
+    return mismatches == 0 ? 0 : 2;
+}
@@ -0,0 +1,98 @@
+// Runs the float and fixed-point feature/inference paths on every window of the
+// recordings and checks that they pick the same class.
+#include "host_commands.h"
+#include "recording.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+int cmd_qcheck(int argc, char** argv) {
+#if !EMG_MODEL_FIXED_POINT || EMG_SPECTRAL_FEATURES
+    std::fprintf(stderr, "qcheck: the exported %s model has no fixed-point tables\n",
+                 model_type_name(emg_model_descriptor.type));
+    return 1;
+#else
+    std::vector<std::string> paths = expand_recording_paths(argc, argv);
+    if (paths.empty()) {
+        std::fprintf(stderr, "qcheck: no recordings given\n");
+        return 1;
+    }
+
+    // Snapshot the buffer at every hop so both paths can be timed on identical input
+    std::vector<EMG_Buffer> windows;
+    for (const std::string& path : paths) {
+        Recording rec;
+        if (!load_recording(path, rec)) {
+            std::fprintf(stderr, "qcheck: cannot read %s\n", path.c_str());
+            return 1;
+        }
+        EMG_Buffer buffer;
+        emg_buffer_init(&buffer);
+        for (size_t i = 0; i < rec.frames.size(); i++) {
+            const EmgFrame& f = rec.frames[i];
+            emg_buffer_add_sample(&buffer, f.ch[0], f.ch[1], f.ch[2], f.ch[3]);
+            if (buffer.is_full && (i + 1) % STEP_SIZE == 0) {
+                windows.push_back(buffer);
+            }
+        }
+    }
+    if (windows.empty()) {
+        std::fprintf(stderr, "qcheck: recordings too short for a window\n");
+        return 1;
+    }
+
+    std::vector<GestureType> float_class(windows.size());
+    std::vector<GestureType> q_class(windows.size());
+    float features[TOTAL_FEATURES];
+    int32_t q_features[TOTAL_FEATURES];
+
+    Clock::time_point t0 = Clock::now();
+    for (size_t i = 0; i < windows.size(); i++) {
+        emg_buffer_process_window(&windows[i], features);
+        float_class[i] = classify_gesture(features);
+    }
+    Clock::time_point t1 = Clock::now();
+    for (size_t i = 0; i < windows.size(); i++) {
+        emg_buffer_process_window_q(&windows[i], q_features);
+        q_class[i] = classify_gesture_q(q_features);
+    }
+    Clock::time_point t2 = Clock::now();
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < windows.size(); i++) {
+        if (float_class[i] != q_class[i]) {
+            if (mismatches < 10) {
+                std::printf("window %zu: float %s, fixed %s\n", i, gesture_names[float_class[i]],
+                            gesture_names[q_class[i]]);
+            }
+            mismatches++;
+        }
+    }
+
+    // Probabilities the gesture decision sees on both paths
+    double max_prob_error = 0.0;
+    for (size_t i = 0; i < windows.size(); i++) {
+        float probs[NUM_CLASSES];
+        float q_probs[NUM_CLASSES];
+        emg_buffer_process_window(&windows[i], features);
+        classify_gesture_proba(features, probs);
+        emg_buffer_process_window_q(&windows[i], q_features);
+        classify_gesture_q_proba(q_features, q_probs);
+        for (int c = 0; c < NUM_CLASSES; c++) {
+            max_prob_error = std::max(max_prob_error, (double)std::fabs(probs[c] - q_probs[c]));
+        }
+    }
+
+    double float_ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / windows.size();
+    double q_ns = std::chrono::duration<double, std::nano>(t2 - t1).count() / windows.size();
+    std::printf("%zu windows, %zu mismatches between float and fixed-point classes\n", windows.size(),
+                mismatches);
+    std::printf("max class probability difference %.2e\n", max_prob_error);
+    std::printf("features + inference per window: float %.1f ns, fixed-point %.1f ns\n", float_ns, q_ns);
+    return mismatches == 0 ? 0 : 2;
+#endif
+}
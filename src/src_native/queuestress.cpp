@@ -0,0 +1,147 @@
+// Two-thread stress test of the frame queue (frame_queue.h) the ADC interrupt and
+// the main loop share. Run twice: a lossless producer that pushes only into free
+// space, then one that pushes DMA-sized bursts regardless, like the interrupt,
+// against a consumer that stalls now and then. The consumer checks every frame's
+// content against its timestamp, that timestamps only increase, and that the gaps
+// add up to the frames the queue reports dropped.
+#include "host_commands.h"
+#include "frame_queue.h"
+#include "adc_acquisition.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+using Clock = std::chrono::steady_clock;
+
+static FrameQueue queue;
+
+static uint16_t channel_value(uint32_t timestamp, int ch) {
+    return (uint16_t)((timestamp * 2654435761u) >> (8 * ch));
+}
+
+static void make_frame(AdcFrame& f, uint32_t timestamp) {
+    f.timestamp = timestamp;
+    for (int ch = 0; ch < ADC_CHANNELS; ch++) {
+        f.ch[ch] = channel_value(timestamp, ch);
+    }
+}
+
+struct StressResult {
+    uint64_t popped = 0;
+    uint64_t gaps = 0;         // Frames missing between consecutive timestamps
+    uint64_t corrupt = 0;      // Frames whose content does not match their timestamp
+    uint64_t reordered = 0;    // Timestamps that did not increase
+    double seconds = 0.0;
+};
+
+static StressResult run(uint32_t frames, bool lossy, uint32_t pop_batch) {
+    frame_queue_init(&queue);
+    std::atomic<bool> done(false);
+    StressResult r;
+
+    Clock::time_point t0 = Clock::now();
+    std::thread producer([&]() {
+        AdcFrame burst[ADC_HALF_FRAMES];
+        uint32_t next = 0;
+        while (next < frames) {
+            uint32_t n = frames - next < ADC_HALF_FRAMES ? frames - next : ADC_HALF_FRAMES;
+            if (!lossy) {
+                // Only this thread adds frames, so the free space can only grow meanwhile
+                uint32_t space = FRAME_QUEUE_FRAMES - frame_queue_count(&queue);
+                n = n < space ? n : space;
+                if (n == 0) {
+                    std::this_thread::yield();
+                    continue;
+                }
+            }
+            for (uint32_t i = 0; i < n; i++) {
+                make_frame(burst[i], next + i);
+            }
+            frame_queue_push(&queue, burst, n);
+            next += n;
+            if (lossy) {
+                std::this_thread::yield();   // Return from the interrupt
+            }
+        }
+        done.store(true, std::memory_order_release);
+    });
+
+    AdcFrame batch[64];
+    int64_t last = -1;
+    uint32_t batches = 0;
+    for (;;) {
+        bool finished = done.load(std::memory_order_acquire);
+        uint32_t n = frame_queue_pop(&queue, batch, pop_batch);
+        for (uint32_t i = 0; i < n; i++) {
+            const AdcFrame& f = batch[i];
+            if ((int64_t)f.timestamp <= last) {
+                r.reordered++;
+            } else {
+                r.gaps += f.timestamp - last - 1;
+            }
+            last = f.timestamp;
+            for (int ch = 0; ch < ADC_CHANNELS; ch++) {
+                if (f.ch[ch] != channel_value(f.timestamp, ch)) {
+                    r.corrupt++;
+                    break;
+                }
+            }
+        }
+        r.popped += n;
+        if (n == 0) {
+            if (finished) {
+                break;   // Nothing left after the producer's last push became visible
+            }
+            std::this_thread::yield();
+        } else if (lossy && ++batches % 4096 == 0) {
+            // The main loop blocked on something else; the producer keeps going
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    }
+    producer.join();
+    r.gaps += frames - 1 - last;   // Dropped at the very end
+    r.seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+    return r;
+}
+
+int cmd_queuestress(int argc, char** argv) {
+    uint32_t frames = 20000000;
+    uint32_t pop_batch = 32;
+    for (int i = 0; i < argc; i++) {
+        if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frames = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--pop") == 0 && i + 1 < argc) {
+            pop_batch = (uint32_t)std::atoi(argv[++i]);
+            pop_batch = pop_batch < 1 ? 1 : pop_batch > 64 ? 64 : pop_batch;
+        } else {
+            std::fprintf(stderr, "queuestress: unknown argument %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (frames == 0) {
+        std::fprintf(stderr, "queuestress: --frames must be positive\n");
+        return 1;
+    }
+
+    std::printf("%u frames per run, pushes of %d, pops of up to %u, queue of %d (%u hardware threads)\n",
+                frames, ADC_HALF_FRAMES, pop_batch, FRAME_QUEUE_FRAMES, std::thread::hardware_concurrency());
+    std::printf("%-10s %10s %10s %10s %10s %8s %8s %10s\n", "producer", "Mframes/s", "popped", "dropped",
+                "gaps", "corrupt", "order", "high water");
+    int failures = 0;
+    for (int lossy = 0; lossy < 2; lossy++) {
+        StressResult r = run(frames, lossy != 0, pop_batch);
+        bool ok = r.corrupt == 0 && r.reordered == 0 && r.gaps == queue.dropped
+                  && r.popped + queue.dropped == frames && (lossy || queue.dropped == 0);
+        std::printf("%-10s %10.1f %10llu %10u %10llu %8llu %8llu %10u%s\n", lossy ? "bursts" : "lossless",
+                    frames / r.seconds / 1e6, (unsigned long long)r.popped, queue.dropped,
+                    (unsigned long long)r.gaps, (unsigned long long)r.corrupt, (unsigned long long)r.reordered,
+                    queue.high_water, ok ? "" : "  FAIL");
+        failures += ok ? 0 : 1;
+    }
+
+    std::printf("\n%s\n", failures == 0 ? "all checks passed" : "CHECKS FAILED");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,165 @@
+#include "recording.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+int label_from_path(const std::string& path) {
+    std::string stem = fs::path(path).stem().string();
+    while (!stem.empty() && std::isdigit((unsigned char)stem.back())) {
+        stem.pop_back();
+    }
+    for (int i = 0; i < NUM_CLASSES; i++) {
+        if (stem == gesture_names[i]) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+MappedFile::~MappedFile() {
+#ifndef _WIN32
+    if (mapped_) {
+        munmap((void*)data_, size_);
+    }
+#endif
+}
+
+bool MappedFile::open(const std::string& path) {
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+    size_ = (size_t)st.st_size;
+    if (size_ > 0) {
+        void* p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            madvise(p, size_, MADV_SEQUENTIAL);
+            data_ = (const char*)p;
+            mapped_ = true;
+        }
+    }
+    ::close(fd);
+    if (mapped_ || size_ == 0) {
+        return true;
+    }
+#endif
+    // No mmap (or it failed): read the file instead
+    FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) {
+        return false;
+    }
+    std::fseek(f, 0, SEEK_END);
+    long len = std::ftell(f);
+    std::fseek(f, 0, SEEK_SET);
+    copy_.resize(len > 0 ? (size_t)len : 0);
+    size_ = std::fread(copy_.data(), 1, copy_.size(), f);
+    std::fclose(f);
+    data_ = copy_.data();
+    return true;
+}
+
+FrameReader::FrameReader(const char* data, size_t size) : p_(data), end_(data + size) {
+    // UTF-8 BOM and capture noise before the first sample
+    while (p_ < end_ && *p_ != '\n' && !std::isdigit((unsigned char)*p_)) {
+        p_++;
+    }
+}
+
+static bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+bool FrameReader::next(EmgFrame& frame, int& channels) {
+    while (p_ < end_) {
+        const char* p = p_;
+        const char* eol = (const char*)std::memchr(p, '\n', (size_t)(end_ - p));
+        if (eol == nullptr) {
+            eol = end_;
+        }
+        p_ = eol < end_ ? eol + 1 : end_;
+
+        // Up to NUM_CHANNELS comma separated values
+        int count = 0;
+        while (count < NUM_CHANNELS && p < eol && is_digit(*p)) {
+            uint32_t value = 0;
+            while (p < eol && is_digit(*p)) {
+                value = value * 10 + (uint32_t)(*p++ - '0');
+            }
+            frame.ch[count++] = (int16_t)value;
+            if (p == eol || *p != ',') {
+                break;
+            }
+            p++;
+        }
+        // Lines must end after the samples (optionally followed by ":gesture")
+        while (p < eol && (*p == ' ' || *p == '\r' || *p == '\t')) p++;
+        if (count < 3 || (p < eol && *p != ':')) {
+            continue;
+        }
+        for (int ch = count; ch < NUM_CHANNELS; ch++) {
+            frame.ch[ch] = 0;
+        }
+        channels = count;
+        return true;
+    }
+    return false;
+}
+
+bool load_recording(const std::string& path, Recording& rec) {
+    MappedFile file;
+    if (!file.open(path)) {
+        return false;
+    }
+
+    rec.path = path;
+    rec.name = fs::path(path).filename().string();
+    rec.label = label_from_path(path);
+    rec.channels = 0;
+    rec.frames.clear();
+    // Lines are at least 12 bytes ("0000,0000,0000")
+    rec.frames.reserve(file.size() / 12);
+
+    FrameReader reader(file.data(), file.size());
+    EmgFrame frame;
+    int channels;
+    while (reader.next(frame, channels)) {
+        rec.channels = std::max(rec.channels, channels);
+        rec.frames.push_back(frame);
+    }
+    return true;
+}
+std::vector<std::string> expand_recording_paths(int argc, char** argv) {
+    std::vector<std::string> paths;
+    for (int i = 0; i < argc; i++) {
+        fs::path p(argv[i]);
+        if (fs::is_directory(p)) {
+            std::vector<std::string> dir;
+            for (const auto& entry : fs::directory_iterator(p)) {
+                if (entry.path().extension() == ".txt") {
+                    dir.push_back(entry.path().string());
+                }
+            }
+            std::sort(dir.begin(), dir.end());
+            paths.insert(paths.end(), dir.begin(), dir.end());
+        } else {
+            paths.push_back(p.string());
+        }
+    }
+    return paths;
+}
@@ -0,0 +1,64 @@
+// Loader for the raw EMG recordings in data/
+#ifndef RECORDING_H
+#define RECORDING_H
+
+#include "emg_classifier.h"
+#include <string>
+#include <vector>
+
+struct EmgFrame {
+    int16_t ch[NUM_CHANNELS];
+};
+
+struct Recording {
+    std::string path;
+    std::string name;   // File name without directory
+    int label;          // GestureType taken from the file name, -1 if it is not a gesture
+    int channels;       // Channels present in the file (older sessions only have 3)
+    std::vector<EmgFrame> frames;
+};
+
+// Read-only view of a whole file: mmap() on POSIX, read into memory elsewhere
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    bool open(const std::string& path);
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;
+    std::vector<char> copy_;
+};
+
+// Streams the frames of a recording held in memory without copying it. Lines are
+// "ch1,ch2,ch3[,ch4][:gesture]"; anything else is skipped. Serial captures start
+// with a UTF-8 BOM or whatever was in the USB buffer, so the first line is
+// resynchronised on its first digit.
+class FrameReader {
+public:
+    FrameReader(const char* data, size_t size);
+    // Returns false at the end; channels is the number of values on the line (3 or 4)
+    bool next(EmgFrame& frame, int& channels);
+
+private:
+    const char* p_;
+    const char* end_;
+};
+
+// Parses the whole file into rec.frames
+bool load_recording(const std::string& path, Recording& rec);
+
+// "finger-gun2.txt" -> GESTURE_FINGER_GUN, "k15_01.txt" -> -1
+int label_from_path(const std::string& path);
+
+// Expands directories into their *.txt files, sorted by name
+std::vector<std::string> expand_recording_paths(int argc, char** argv);
+
+#endif // RECORDING_H
@@ -0,0 +1,443 @@
+// Replays recordings through the same ADC DMA -> add_sample -> process_window ->
+// normalise -> validate -> classify -> decide sequence as the firmware main loop. The 3-of-5 vote
+// the decision module replaced runs alongside on the same predictions for comparison.
+#include "host_commands.h"
+#include "recording.h"
+#include "adc_acquisition.h"
+#include "gesture.h"
+#include "gesture_decision.h"
+#include "feature_normaliser.h"
+#include "gesture_vote.h"
+#include "signal_validation.h"
+#include "telemetry.h"
+#include "trace.h"
+#include "stm32f4xx_hal.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+using Clock = std::chrono::steady_clock;
+
+extern "C" UART_HandleTypeDef huart1;
+
+struct ReplayOptions {
+    bool realtime = false;   // Pace samples at SAMPLING_RATE_HZ instead of as fast as possible
+    bool events = false;     // Print every decision change
+    bool verify = false;     // Compare the streaming features with the full-window extractor
+    uint32_t stall_ms = 0;   // Main loop stops draining the ADC for this long every second
+    FILE* telemetry = nullptr;  // UART byte stream (binary frames + log text) goes here
+    bool trace = false;      // Print the per-stage trace report
+    bool validate = true;    // Apply the signal validity thresholds before classifying
+    GestureDecisionConfig decision = GESTURE_DECISION_DEFAULTS;
+};
+
+// Accuracy and gesture-change latency of one decision rule. Latency runs from the
+// first window of the latest run of raw predictions of a gesture to the switch to it.
+struct DeciderStats {
+    size_t correct = 0;   // Windows where the decided gesture matches the file label
+    size_t changes = 0;
+    size_t timed = 0;     // Changes with a latency (not forced by an invalid window)
+    double latency_ms = 0.0;
+
+    void add(const DeciderStats& o) {
+        correct += o.correct;
+        changes += o.changes;
+        timed += o.timed;
+        latency_ms += o.latency_ms;
+    }
+};
+
+struct DeciderTrack {
+    GestureType current = GESTURE_REST;
+};
+
+struct ReplayResult {
+    size_t samples = 0;
+    size_t windows = 0;
+    size_t invalid = 0;
+    size_t raw_correct = 0;      // Windows whose classifier output matches the file label
+    DeciderStats decision;       // gesture_decision (the firmware path)
+    DeciderStats vote;           // 3-of-5 majority vote
+    uint32_t frames_lost = 0;
+    uint32_t overruns = 0;
+    uint32_t max_backlog = 0;
+    std::vector<double> window_us;
+    double max_rel_error[FEATURES_PER_CHANNEL] = {};
+};
+
+static const char* feature_names[FEATURES_PER_CHANNEL] = {
+#if EMG_TIME_FEATURES & FEATURE_MAV
+    "mav",
+#endif
+#if EMG_TIME_FEATURES & FEATURE_RMS
+    "rms",
+#endif
+#if EMG_TIME_FEATURES & FEATURE_VAR
+    "var",
+#endif
+#if EMG_TIME_FEATURES & FEATURE_WL
+    "wl",
+#endif
+#if EMG_TIME_FEATURES & FEATURE_ZC
+    "zc",
+#endif
+#if EMG_TIME_FEATURES & FEATURE_SSC
+    "ssc",
+#endif
+#if EMG_TIME_FEATURES & FEATURE_WAMP
+    "wamp",
+#endif
+#if EMG_SPECTRAL_FEATURES
+    "mnf", "mdf", "bp_lo", "bp_mid", "bp_hi",
+#endif
+};
+
+static void verify_features(const EMG_Buffer& buffer, const float* features, ReplayResult& res) {
+    int16_t window[NUM_CHANNELS][WINDOW_SIZE];
+    float reference[TOTAL_FEATURES];
+    emg_buffer_get_window(&buffer, window);
+    extract_features_from_window(window, reference);
+    for (int i = 0; i < TOTAL_FEATURES; i++) {
+        double err = std::fabs((double)features[i] - reference[i])
+                     / std::max(std::fabs((double)reference[i]), 1.0);
+        double& worst = res.max_rel_error[i % FEATURES_PER_CHANNEL];
+        worst = std::max(worst, err);
+    }
+}
+
+// Firmware main-loop state for one recording
+struct ReplayPipeline {
+    EMG_Buffer buffer;
+    float features[TOTAL_FEATURES];
+    float raw_features[TOTAL_FEATURES];  // Before the normaliser
+    FeatureNormaliser normaliser;
+    GestureDecision decision;
+    GestureVote vote;
+    DeciderTrack decided;
+    DeciderTrack voted;
+    // Raw prediction runs, for the change latency
+    int last_prediction = -1;  // -1 after an invalid window
+    bool have_run[NUM_CLASSES] = {};
+    size_t run_start[NUM_CLASSES] = {};
+    uint32_t samples_to_hop = HOP_SAMPLES;
+    uint32_t wake = 0;  // trace_now() when the current drain started, for TRACE_HOP
+};
+
+static void track_decider(const ReplayPipeline& p, DeciderTrack& track, GestureType next, bool valid,
+                          size_t sample, int label, DeciderStats& stats) {
+    if (next != track.current) {
+        stats.changes++;
+        if (valid && p.have_run[next]) {
+            stats.timed++;
+            stats.latency_ms += (double)(sample - p.run_start[next]) * 1000.0 / SAMPLING_RATE_HZ;
+        }
+        track.current = next;
+    }
+    stats.correct += ((int)track.current == label) ? 1 : 0;
+}
+
+static void process_sample(ReplayPipeline& p, const uint16_t* frame, uint32_t current_time,
+                           const Recording& rec, const ReplayOptions& opt, ReplayResult& res) {
+    uint32_t t = trace_now();
+    emg_buffer_add_sample(&p.buffer, frame[0], frame[1], frame[2], frame[3]);
+#if TELEMETRY_BINARY
+    telemetry_push_sample(frame, (uint8_t)p.decided.current);
+#endif
+    trace_record(TRACE_SAMPLE, t);
+    res.samples++;
+
+    // Same hop as the firmware: every HOP_SAMPLES frames on the sample clock
+    if (--p.samples_to_hop > 0) {
+        return;
+    }
+    p.samples_to_hop = HOP_SAMPLES;
+
+    const Clock::time_point t0 = Clock::now();
+    const uint32_t t_classify = trace_now();
+    if (!emg_buffer_process_window(&p.buffer, p.features)) {
+        return;
+    }
+    // Validated on the raw features, like the firmware; only the classifier sees them normalised
+    std::memcpy(p.raw_features, p.features, sizeof(p.features));
+    bool valid = !opt.validate || is_window_valid(&p.buffer, p.raw_features);
+    feature_normaliser_apply(&p.normaliser, p.features);
+    t = trace_record(TRACE_FEATURES, t_classify);
+
+    GestureType previous = p.decided.current;
+    GestureType next = previous;
+    GestureType voted = p.voted.current;
+    GestureType prediction = GESTURE_REST;
+    if (valid) {
+        float probs[NUM_CLASSES];
+        prediction = classify_gesture_proba(p.features, probs);
+        t = trace_record(TRACE_PREDICT, t);
+        feature_normaliser_update(&p.normaliser, p.raw_features, prediction == GESTURE_REST);
+        GestureType decided;
+        bool changed = gesture_decision_push(&p.decision, probs, &decided);
+        t = trace_record(TRACE_DECIDE, t);
+        if (changed) {
+            next = decided;
+            execute_gesture(next);
+            trace_record(TRACE_ACTUATE, t);
+        }
+        GestureType most_frequent;
+        if (gesture_vote_push(&p.vote, prediction, &most_frequent)) {
+            voted = most_frequent;
+        }
+    } else {
+        t = trace_record(TRACE_PREDICT, t);
+        feature_normaliser_update(&p.normaliser, p.raw_features, false);
+        gesture_decision_reset(&p.decision, GESTURE_REST);
+        next = GESTURE_REST;
+        voted = GESTURE_REST;
+        if (previous != GESTURE_REST) {
+            execute_gesture(GESTURE_REST);
+            trace_record(TRACE_ACTUATE, t);
+        }
+    }
+    trace_record(TRACE_CLASSIFY, t_classify);
+    trace_record(TRACE_HOP, p.wake);
+    res.window_us.push_back(std::chrono::duration<double, std::micro>(Clock::now() - t0).count());
+    if (opt.verify) {
+        verify_features(p.buffer, p.raw_features, res);
+    }
+
+    res.windows++;
+    res.invalid += valid ? 0 : 1;
+    res.raw_correct += (valid && (int)prediction == rec.label) ? 1 : 0;
+    if (valid && (int)prediction != p.last_prediction) {
+        p.have_run[prediction] = true;
+        p.run_start[prediction] = res.samples - 1;
+    }
+    p.last_prediction = valid ? (int)prediction : -1;
+    track_decider(p, p.decided, next, valid, res.samples - 1, rec.label, res.decision);
+    track_decider(p, p.voted, voted, valid, res.samples - 1, rec.label, res.vote);
+
+    if (next != previous && opt.events) {
+        std::printf("  %-18s t=%8.3fs sample=%-7zu %s -> %s%s\n", rec.name.c_str(),
+                    current_time / 1000.0, res.samples - 1, gesture_names[previous],
+                    gesture_names[next], valid ? "" : " (invalid window)");
+    }
+}
+
+// Scans go through the simulated TIM3 -> ADC1 -> DMA path and the main loop drains
+// them with adc_acq_read(), optionally stalling for stall_ms once per second. The
+// recordings are at SAMPLING_RATE_HZ, so an ADC_OVERSAMPLE build scans each frame
+// that many times and the decimator's output is the recording through its response.
+static void replay_recording(const Recording& rec, const ReplayOptions& opt, ReplayResult& res) {
+    ReplayPipeline p;
+    emg_buffer_init(&p.buffer);
+    feature_normaliser_init(&p.normaliser, NULL);
+    gesture_decision_init(&p.decision, &opt.decision);
+    gesture_vote_init(&p.vote);
+    hal_shim_set_tick(0);
+    adc_acq_start();
+
+    const uint32_t stall_frames = opt.stall_ms * SAMPLING_RATE_HZ / 1000;
+    AdcFrame batch[32];
+    uint32_t current_time = 0;
+
+    const Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < rec.frames.size(); i++) {
+        current_time = (uint32_t)((uint64_t)i * 1000 / SAMPLING_RATE_HZ);
+        hal_shim_set_tick(current_time);
+
+        if (opt.realtime) {
+            std::this_thread::sleep_until(start + std::chrono::microseconds((uint64_t)i * 1000000
+                                                                            / SAMPLING_RATE_HZ));
+        }
+
+        uint16_t scan[ADC_CHANNELS];
+        for (int ch = 0; ch < ADC_CHANNELS; ch++) {
+            scan[ch] = (uint16_t)rec.frames[i].ch[ch];
+        }
+        for (int r = 0; r < ADC_OVERSAMPLE; r++) {
+            hal_shim_adc_scan(scan, ADC_CHANNELS);
+        }
+
+        if (i % SAMPLING_RATE_HZ < stall_frames) {
+            continue;  // Main loop blocked (UART, I2C, ...)
+        }
+        uint32_t count;
+        p.wake = trace_now();
+        while ((count = adc_acq_read(batch, 32)) > 0) {
+            for (uint32_t k = 0; k < count; k++) {
+                process_sample(p, batch[k].ch, current_time, rec, opt, res);
+            }
+        }
+    }
+
+    uint32_t count;
+    p.wake = trace_now();
+    while ((count = adc_acq_read(batch, 32)) > 0) {
+        for (uint32_t k = 0; k < count; k++) {
+            process_sample(p, batch[k].ch, current_time, rec, opt, res);
+        }
+    }
+
+    const ADC_AcqStats* stats = adc_acq_get_stats();
+    res.frames_lost = stats->frames_lost;
+    res.overruns = stats->overruns;
+    res.max_backlog = stats->max_backlog;
+}
+
+static void print_decider(const char* name, const DeciderStats& s, size_t windows) {
+    std::printf("%-10s %6zu changes, decided %5.1f%%, mean change latency ", name, s.changes,
+                windows > 0 ? 100.0 * s.correct / windows : 0.0);
+    if (s.timed > 0) {
+        std::printf("%.1f ms over %zu changes\n", s.latency_ms / s.timed, s.timed);
+    } else {
+        std::printf("-\n");
+    }
+}
+
+static double percentile(std::vector<double>& v, double p) {
+    if (v.empty()) return 0.0;
+    size_t k = (size_t)(p * (v.size() - 1));
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k];
+}
+
+int cmd_replay(int argc, char** argv) {
+    ReplayOptions opt;
+    int first = 0;
+    for (; first < argc && std::strncmp(argv[first], "--", 2) == 0; first++) {
+        if (std::strcmp(argv[first], "--realtime") == 0) {
+            opt.realtime = true;
+        } else if (std::strcmp(argv[first], "--events") == 0) {
+            opt.events = true;
+        } else if (std::strcmp(argv[first], "--verify") == 0) {
+            opt.verify = true;
+        } else if (std::strcmp(argv[first], "--stall") == 0 && first + 1 < argc) {
+            opt.stall_ms = (uint32_t)std::atoi(argv[++first]);
+        } else if (std::strcmp(argv[first], "--no-validate") == 0) {
+            opt.validate = false;
+        } else if (std::strcmp(argv[first], "--accept") == 0 && first + 1 < argc) {
+            opt.decision.accept = (float)std::atof(argv[++first]);
+        } else if (std::strcmp(argv[first], "--reject") == 0 && first + 1 < argc) {
+            opt.decision.reject = (float)std::atof(argv[++first]);
+        } else if (std::strcmp(argv[first], "--evidence") == 0 && first + 1 < argc) {
+            opt.decision.evidence_needed = (float)std::atof(argv[++first]);
+        } else if (std::strcmp(argv[first], "--decay") == 0 && first + 1 < argc) {
+            opt.decision.decay = (float)std::atof(argv[++first]);
+        } else if (std::strcmp(argv[first], "--trace") == 0) {
+            opt.trace = true;
+        } else if (std::strcmp(argv[first], "--uart") == 0) {
+            hal_shim_set_uart_sink(stdout);
+        } else if (std::strcmp(argv[first], "--telemetry") == 0 && first + 1 < argc) {
+            opt.telemetry = std::fopen(argv[++first], "wb");
+            if (!opt.telemetry) {
+                std::fprintf(stderr, "replay: cannot write %s\n", argv[first]);
+                return 1;
+            }
+            hal_shim_set_uart_sink(opt.telemetry);
+        } else if (std::strcmp(argv[first], "--tx-errors") == 0 && first + 1 < argc) {
+            hal_shim_uart_tx_error_every((uint32_t)std::atoi(argv[++first]));
+        } else {
+            std::fprintf(stderr, "replay: unknown option %s\n", argv[first]);
+            return 1;
+        }
+    }
+
+    std::vector<std::string> paths = expand_recording_paths(argc - first, argv + first);
+    if (paths.empty()) {
+        std::fprintf(stderr, "replay: no recordings given\n");
+        return 1;
+    }
+
+    std::printf("%-18s %-10s %3s %8s %7s %7s %7s %7s %7s %7s\n", "file", "label", "ch", "samples",
+                "windows", "invalid", "raw%", "vote%", "decide%", "changes");
+
+    telemetry_init(&huart1);
+    trace_init();
+
+    ReplayResult total;
+    size_t labelled_windows = 0;
+    double wall_s = 0.0;
+    for (const std::string& path : paths) {
+        Recording rec;
+        if (!load_recording(path, rec)) {
+            std::fprintf(stderr, "replay: cannot read %s\n", path.c_str());
+            return 1;
+        }
+
+        ReplayResult res;
+        const Clock::time_point t0 = Clock::now();
+        replay_recording(rec, opt, res);
+        wall_s += std::chrono::duration<double>(Clock::now() - t0).count();
+
+        const char* label = rec.label >= 0 ? gesture_names[rec.label] : "-";
+        if (rec.label >= 0 && res.windows > 0) {
+            std::printf("%-18s %-10s %3d %8zu %7zu %7zu %7.1f %7.1f %7.1f %7zu\n", rec.name.c_str(),
+                        label, rec.channels, res.samples, res.windows, res.invalid,
+                        100.0 * res.raw_correct / res.windows, 100.0 * res.vote.correct / res.windows,
+                        100.0 * res.decision.correct / res.windows, res.decision.changes);
+            total.raw_correct += res.raw_correct;
+            total.vote.correct += res.vote.correct;
+            total.decision.correct += res.decision.correct;
+            labelled_windows += res.windows;
+        } else {
+            std::printf("%-18s %-10s %3d %8zu %7zu %7zu %7s %7s %7s %7zu\n", rec.name.c_str(), label,
+                        rec.channels, res.samples, res.windows, res.invalid, "-", "-", "-",
+                        res.decision.changes);
+        }
+
+        total.samples += res.samples;
+        total.frames_lost += res.frames_lost;
+        total.overruns += res.overruns;
+        total.max_backlog = std::max(total.max_backlog, res.max_backlog);
+        total.windows += res.windows;
+        total.invalid += res.invalid;
+        // Accuracy is summed above for labelled files only
+        res.vote.correct = res.decision.correct = 0;
+        total.vote.add(res.vote);
+        total.decision.add(res.decision);
+        total.window_us.insert(total.window_us.end(), res.window_us.begin(), res.window_us.end());
+        for (int k = 0; k < FEATURES_PER_CHANNEL; k++) {
+            total.max_rel_error[k] = std::max(total.max_rel_error[k], res.max_rel_error[k]);
+        }
+    }
+
+    std::printf("\n%zu samples, %zu windows in %.3f s: %.0f samples/s\n", total.samples, total.windows,
+                wall_s, wall_s > 0 ? total.samples / wall_s : 0.0);
+    if (!total.window_us.empty()) {
+        double sum = 0.0;
+        for (double us : total.window_us) sum += us;
+        double mean = sum / total.window_us.size();
+        double max = *std::max_element(total.window_us.begin(), total.window_us.end());
+        double min = *std::min_element(total.window_us.begin(), total.window_us.end());
+        double p99 = percentile(total.window_us, 0.99);
+        std::printf("window latency (us): min %.2f  mean %.2f  p99 %.2f  max %.2f\n", min, mean, p99, max);
+    }
+    if (total.invalid < total.windows) {
+        print_decider("vote 3/5", total.vote, labelled_windows);
+        print_decider("decision", total.decision, labelled_windows);
+    }
+    std::printf("acquisition: %u frames lost, %u overruns, max backlog %u of %u frames\n",
+                total.frames_lost, total.overruns, total.max_backlog, FRAME_QUEUE_FRAMES);
+    if (opt.telemetry) {
+        telemetry_flush();
+        hal_shim_set_uart_sink(nullptr);
+        std::fclose(opt.telemetry);
+        const TelemetryStats* ts = telemetry_get_stats();
+        std::printf("telemetry: %u frames sent, %u dropped, %u DMA transfers, %u failed\n", ts->frames_sent,
+                    ts->frames_dropped, ts->dma_starts, ts->tx_errors);
+    }
+    if (opt.trace) {
+        static char report[2048];
+        trace_format_report(report, sizeof(report));
+        std::printf("\n%s", report);
+    }
+    if (opt.verify) {
+        std::printf("max relative error vs extract_features_from_window:");
+        for (int k = 0; k < FEATURES_PER_CHANNEL; k++) {
+            std::printf("  %s %.2e", feature_names[k], total.max_rel_error[k]);
+        }
+        std::printf("\n");
+    }
+    return total.frames_lost == 0 ? 0 : 2;
+}
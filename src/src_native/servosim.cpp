@@ -0,0 +1,191 @@
+// Finger trajectories on the host: a gesture sequence goes through execute_gesture()
+// into servo_motion, which is stepped once per PWM frame like the TIM4 tick does on
+// the board, and every frame sent to the PCA9685 is logged. The summary compares the
+// ramped motion with the old jump-to-pose actuation, where every changed finger
+// starts (and draws stall current) in the same frame.
+#include "host_commands.h"
+#include "servo_motion.h"
+#include "gesture.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+struct SimStep {
+    GestureType gesture;
+    uint32_t hold_ms;
+};
+
+struct SimOptions {
+    ServoMotionConfig motion = SERVO_MOTION_DEFAULTS;
+    uint32_t hold_ms = 1000;
+    const char* csv_path = nullptr;
+};
+
+struct SegmentStats {
+    int settle_ms = -1;       // -1: still moving when the next gesture came
+    int peak_accelerating = 0;
+    float max_step = 0.0f;    // Largest change of one finger in one frame, deg
+    uint32_t frames_sent = 0;
+    int jump_fingers = 0;     // Fingers the jump actuation would start at once
+    int jump_step = 0;
+};
+
+// "rock" or "rock:300" (hold in ms)
+static bool parse_step(const char* text, uint32_t default_hold, SimStep& step) {
+    std::string name = text;
+    step.hold_ms = default_hold;
+    size_t colon = name.find(':');
+    if (colon != std::string::npos) {
+        step.hold_ms = (uint32_t)std::atoi(name.c_str() + colon + 1);
+        name.resize(colon);
+    }
+    for (int i = 0; i < NUM_CLASSES; i++) {
+        if (name == gesture_names[i]) {
+            step.gesture = (GestureType)i;
+            return step.hold_ms > 0;
+        }
+    }
+    return false;
+}
+
+int cmd_servosim(int argc, char** argv) {
+    SimOptions opt;
+    int first = 0;
+    for (; first < argc && std::strncmp(argv[first], "--", 2) == 0; first++) {
+        const char* arg = argv[first];
+        const bool has_value = first + 1 < argc;
+        if (std::strcmp(arg, "--speed") == 0 && has_value) {
+            float speed = (float)std::atof(argv[++first]);
+            for (int i = 1; i < SERVO_COUNT; i++) {
+                opt.motion.max_speed[i] = speed;
+            }
+        } else if (std::strcmp(arg, "--thumb-speed") == 0 && has_value) {
+            opt.motion.max_speed[0] = (float)std::atof(argv[++first]);
+        } else if (std::strcmp(arg, "--accel") == 0 && has_value) {
+            opt.motion.accel = (float)std::atof(argv[++first]);
+        } else if (std::strcmp(arg, "--stagger") == 0 && has_value) {
+            opt.motion.stagger_ms = (uint16_t)std::atoi(argv[++first]);
+        } else if (std::strcmp(arg, "--hold") == 0 && has_value) {
+            opt.hold_ms = (uint32_t)std::atoi(argv[++first]);
+        } else if (std::strcmp(arg, "--csv") == 0 && has_value) {
+            opt.csv_path = argv[++first];
+        } else {
+            std::fprintf(stderr, "servosim: unknown option %s\n", arg);
+            return 1;
+        }
+    }
+    if (opt.motion.accel <= 0.0f) {
+        std::fprintf(stderr, "servosim: --accel must be positive\n");
+        return 1;
+    }
+
+    // Default: a few full-hand changes and one pre-empted halfway through
+    static const char* default_sequence[] = { "rock", "paper:200", "scissors", "okay", "rest" };
+    std::vector<SimStep> steps;
+    for (int i = first; i < argc; i++) {
+        SimStep step;
+        if (!parse_step(argv[i], opt.hold_ms, step)) {
+            std::fprintf(stderr, "servosim: bad gesture %s (name[:hold_ms])\n", argv[i]);
+            return 1;
+        }
+        steps.push_back(step);
+    }
+    if (steps.empty()) {
+        for (const char* text : default_sequence) {
+            SimStep step;
+            parse_step(text, opt.hold_ms, step);
+            steps.push_back(step);
+        }
+    }
+
+    FILE* csv = nullptr;
+    if (opt.csv_path) {
+        csv = std::fopen(opt.csv_path, "w");
+        if (!csv) {
+            std::fprintf(stderr, "servosim: cannot write %s\n", opt.csv_path);
+            return 1;
+        }
+        std::fprintf(csv, "t_ms,gesture,thumb,index,middle,ring,pinky,active,accelerating\n");
+    }
+
+    InitAllServos();
+    const HandPose rest_pose = { { SERVO_REST_ANGLE, SERVO_REST_ANGLE, SERVO_REST_ANGLE, SERVO_REST_ANGLE,
+                                   SERVO_REST_ANGLE } };
+    servo_motion_init(&servo_motion, &opt.motion, &rest_pose);
+
+    std::printf("frame %d ms, speed thumb %.0f / fingers %.0f deg/s, accel %.0f deg/s^2, stagger %u ms\n\n",
+                SERVO_FRAME_MS, opt.motion.max_speed[0], opt.motion.max_speed[1], opt.motion.accel,
+                opt.motion.stagger_ms);
+    std::printf("%-11s %7s %9s %11s %11s %9s | %13s %9s\n", "gesture", "hold_ms", "settle_ms", "frames_sent",
+                "peak_accel", "max_step", "jump: fingers", "max_step");
+
+    uint32_t t_ms = 0;
+    int worst_ramped = 0, worst_jump = 0;
+    for (const SimStep& step : steps) {
+        SegmentStats seg;
+        // What the jump actuation would do: every finger away from its target at once
+        execute_gesture(step.gesture);
+        for (int i = 0; i < SERVO_COUNT; i++) {
+            int delta = std::abs((int)servo_motion.target[i] - (int)servo_motion.output.angle[i]);
+            seg.jump_fingers += delta > 0 ? 1 : 0;
+            seg.jump_step = std::max(seg.jump_step, delta);
+        }
+
+        for (uint32_t t = 0; t < step.hold_ms; t += SERVO_FRAME_MS) {
+            float speed_before[SERVO_COUNT];
+            for (int i = 0; i < SERVO_COUNT; i++) {
+                speed_before[i] = std::fabs(servo_motion.velocity[i]);
+            }
+            HandPose previous = servo_motion.output;
+            HandPose pose;
+            if (servo_motion_tick(&servo_motion, &pose)) {
+                SetHandPose(&pose);
+                seg.frames_sent++;
+            }
+            t_ms += SERVO_FRAME_MS;
+
+            int accelerating = 0;
+            for (int i = 0; i < SERVO_COUNT; i++) {
+                accelerating += std::fabs(servo_motion.velocity[i]) > speed_before[i] ? 1 : 0;
+                seg.max_step = std::max(seg.max_step,
+                                        (float)std::abs((int)pose.angle[i] - (int)previous.angle[i]));
+            }
+            seg.peak_accelerating = std::max(seg.peak_accelerating, accelerating);
+            int active = servo_motion_active(&servo_motion);
+            if (active == 0 && seg.settle_ms < 0) {
+                seg.settle_ms = (int)(t + SERVO_FRAME_MS);
+            }
+            if (csv) {
+                std::fprintf(csv, "%u,%s,%u,%u,%u,%u,%u,%d,%d\n", t_ms, gesture_names[step.gesture],
+                             pose.angle[0], pose.angle[1], pose.angle[2], pose.angle[3], pose.angle[4], active,
+                             accelerating);
+            }
+        }
+
+        char settle[16];
+        if (seg.settle_ms >= 0) {
+            std::snprintf(settle, sizeof(settle), "%d", seg.settle_ms);
+        } else {
+            std::snprintf(settle, sizeof(settle), "pre-empted");
+        }
+        std::printf("%-11s %7u %9s %11u %11d %9.0f | %13d %9d\n", gesture_names[step.gesture], step.hold_ms,
+                    settle, seg.frames_sent, seg.peak_accelerating, seg.max_step, seg.jump_fingers,
+                    seg.jump_step);
+        worst_ramped = std::max(worst_ramped, seg.peak_accelerating);
+        worst_jump = std::max(worst_jump, seg.jump_fingers);
+    }
+
+    std::printf("\nfingers accelerating together: at most %d ramped vs %d jumping\n", worst_ramped,
+                worst_jump);
+    std::printf("PCA9685 bursts: %u written, %u coalesced, %u errors\n", pca9685.blocks_written,
+                pca9685.blocks_coalesced, pca9685.block_errors);
+    if (csv) {
+        std::fclose(csv);
+        std::printf("trajectories written to %s\n", opt.csv_path);
+    }
+    return 0;
+}
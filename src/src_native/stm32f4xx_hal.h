@@ -0,0 +1,185 @@
+// Host stand-in for the STM32Cube HAL used by the native env.
+// Only the types and calls reached from the shared src_cube modules are provided.
+#ifndef STM32F4XX_HAL_H
+#define STM32F4XX_HAL_H
+
+// Lets shared modules pick host implementations (e.g. the trace clock)
+#define HAL_SHIM 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+typedef enum {
+    HAL_OK = 0x00U,
+    HAL_ERROR = 0x01U,
+    HAL_BUSY = 0x02U,
+    HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+typedef enum {
+    GPIO_PIN_RESET = 0,
+    GPIO_PIN_SET
+} GPIO_PinState;
+
+typedef struct {
+    uint32_t ODR;
+} GPIO_TypeDef;
+
+typedef struct {
+    uint32_t ClockSpeed;
+} I2C_InitTypeDef;
+
+typedef struct {
+    I2C_InitTypeDef Init;
+} I2C_HandleTypeDef;
+
+typedef struct {
+    uint32_t BaudRate;
+} UART_InitTypeDef;
+
+// gState as in the Cube HAL: back to READY once a transmit has ended, also on error
+#define HAL_UART_STATE_READY 0x20U
+#define HAL_UART_STATE_BUSY_TX 0x21U
+
+typedef struct {
+    UART_InitTypeDef Init;
+    volatile uint32_t gState;
+} UART_HandleTypeDef;
+
+typedef struct {
+    volatile uint32_t NDTR;
+} DMA_Stream_TypeDef;
+
+typedef struct {
+    DMA_Stream_TypeDef *Instance;
+} DMA_HandleTypeDef;
+
+typedef struct {
+    uint32_t SR;
+} ADC_TypeDef;
+
+typedef struct {
+    ADC_TypeDef *Instance;
+    DMA_HandleTypeDef *DMA_Handle;
+} ADC_HandleTypeDef;
+
+typedef struct {
+    uint32_t Prescaler;
+    uint32_t Period;
+} TIM_InitTypeDef;
+
+typedef struct {
+    uint32_t CNT;
+} TIM_TypeDef;
+
+typedef struct {
+    TIM_TypeDef *Instance;
+    TIM_InitTypeDef Init;
+} TIM_HandleTypeDef;
+
+extern ADC_TypeDef host_adc1;
+#define ADC1 (&host_adc1)
+
+extern TIM_TypeDef host_tim4;
+#define TIM4 (&host_tim4)
+
+extern GPIO_TypeDef host_gpioc;
+#define GPIOC (&host_gpioc)
+#define GPIO_PIN_13 ((uint16_t)0x2000)
+
+#define I2C_MEMADD_SIZE_8BIT 0x00000001U
+
+// Internal flash of the F401CC: sectors 0-3 16 KB, 4 64 KB, 5 128 KB
+#define FLASH_BASE 0x08000000U
+#define FLASH_TYPEERASE_SECTORS 0x00000000U
+#define FLASH_TYPEPROGRAM_WORD 0x00000002U
+#define FLASH_VOLTAGE_RANGE_3 0x00000002U
+#define FLASH_SECTOR_4 4U
+#define FLASH_SECTOR_5 5U
+
+typedef struct {
+    uint32_t TypeErase;
+    uint32_t Banks;
+    uint32_t Sector;
+    uint32_t NbSectors;
+    uint32_t VoltageRange;
+} FLASH_EraseInitTypeDef;
+
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t Delay);
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size,
+                                    uint32_t Timeout);
+
+HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size);
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart);
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size);
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart);
+
+HAL_StatusTypeDef HAL_ADC_Start_DMA(ADC_HandleTypeDef *hadc, uint32_t *pData, uint32_t Length);
+void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef *hadc);
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc);
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress,
+                                    uint16_t MemAddSize, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_I2C_Mem_Write_DMA(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress,
+                                        uint16_t MemAddSize, uint8_t *pData, uint16_t Size);
+void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c);
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c);
+HAL_StatusTypeDef HAL_I2C_Mem_Read(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress,
+                                   uint16_t MemAddSize, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim);
+
+HAL_StatusTypeDef HAL_FLASH_Unlock(void);
+HAL_StatusTypeDef HAL_FLASH_Lock(void);
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef *pEraseInit, uint32_t *SectorError);
+HAL_StatusTypeDef HAL_FLASH_Program(uint32_t TypeProgram, uint32_t Address, uint64_t Data);
+
+// Single-threaded host: interrupt masking is a no-op
+static inline uint32_t __get_PRIMASK(void) { return 0; }
+static inline void __set_PRIMASK(uint32_t primask) { (void)primask; }
+static inline void __disable_irq(void) {}
+static inline void __enable_irq(void) {}
+// Nothing to wait for: the replay drives the interrupts itself
+static inline void __WFI(void) {}
+
+// ---- Host-only controls ----
+
+// The HAL tick is simulated: replays advance it from the sample clock and HAL_Delay
+// returns immediately after moving it forward.
+void hal_shim_set_tick(uint32_t tick_ms);
+// One TIM3-triggered ADC1 scan: the values land in the buffer given to
+// HAL_ADC_Start_DMA and the half/complete callbacks fire like the DMA interrupts
+void hal_shim_adc_scan(const uint16_t *values, int channels);
+// Monotonic nanoseconds (std::chrono::steady_clock), the native stand-in for DWT->CYCCNT
+uint32_t hal_shim_trace_ticks(void);
+// UART traffic is discarded unless a sink is set
+void hal_shim_set_uart_sink(FILE *sink);
+// Every nth HAL_UART_Transmit_DMA fails (0 = never): nothing is written and the
+// error callback fires instead of the complete callback, like a DMA transfer error
+void hal_shim_uart_tx_error_every(uint32_t n);
+// Flash is simulated in memory (erased to 0xFF at start-up, programming only clears
+// bits like the real cells); firmware reads at a flash address go through this
+const void *hal_shim_flash_ptr(uint32_t address);
+
+// The firmware's _write() drops stdio output; do the same for the C modules
+int hal_shim_printf(const char *format, ...);
+#ifndef __cplusplus
+#define printf hal_shim_printf
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // STM32F4XX_HAL_H
@@ -0,0 +1,8 @@
+// Host clock behind trace_now(): nanoseconds, wrapping like the 32-bit CYCCNT
+#include "stm32f4xx_hal.h"
+#include <chrono>
+
+extern "C" uint32_t hal_shim_trace_ticks(void) {
+    using namespace std::chrono;
+    return (uint32_t)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}